@@ -64,10 +64,10 @@ void updateLED2State();
 // Variables accessable from the API
 bool bLED1State = false;
 bool bLED2State = false;
-// API keywords
+// API keywords, the value type is taken from the bound variable. The LED states are kept across reboots
 apiKeyword apiKeywords[keywords] = {
-  {"LED1State", "LED1STATE", pBOOL, &bLED1State, updateLED1State},
-  {"LED2State", "LED2STATE", pBOOL, &bLED2State, updateLED2State},
+  persistentKeyword(bindKeyword("LED1State", "LED1STATE", bLED1State, updateLED1State)),
+  persistentKeyword(bindKeyword("LED2State", "LED2STATE", bLED2State, updateLED2State)),
 };
 
 // Initialize the webManager class using the given webcontent, but without API functionality
@@ -106,27 +106,46 @@ void updateLED2State() {
   }
 }
 
+// Print startup progress
+void startupPhase(uint8_t phase, uint8_t state, uint32_t duration) {
+  if (phase == phaseWiFi && state == phaseDone) {
+    Serial.print("Connected, IP address: ");
+    Serial.println(WiFi.localIP());
+  }
+  if (webCoffee.startup()->ready()) {
+    Serial.println("HTTP server ready");
+  }
+}
+
 // Setup
 void setup(void) {
   // Start serial communication
   Serial.begin(115200);
-  // Start SPIFFS (for managaing website files)
-  webCoffee.startSPIFFS();
-  // Start WiFi and connect to SSID
-  webCoffee.startWIFIclient(ssid, password);
-  // Start MDNS responder
-  webCoffee.startMDNS("esp32");
   // Add API based HTML processer to webManager
   webCoffee.setHTMLprocessor(processor);
-  // Start webManager
-  webCoffee.begin();
-  Serial.println("HTTP server started");
+  // Parse HTML pages once at startup, instead of on every request
+  webCoffee.setTemplateCache(true);
+  // Keep up to 32 kB of website files in RAM
+  webCoffee.setFileCache(32768);
+  // Push LED state changes to the web page, instead of reloading it
+  webCoffee.enablePushEvents();
+  // Serve request counters and latencies on /metrics
+  webCoffee.enableMetrics();
+  // Store the LED states on SPIFFS
+  webCoffee.enablePersistence();
   // Set pinMode for LED pins
   pinMode(LED1Pin, OUTPUT);
   pinMode(LED2Pin, OUTPUT);
+  // Start SPIFFS, WiFi, MDNS and webManager, without waiting for WiFi to connect
+  webCoffee.onStartup(startupPhase);
+  webCoffee.start(ssid, password, "esp32");
+  // Set the LEDs to the restored states
+  updateLED1State();
+  updateLED2State();
 }
 
 // Loop
 void loop(void) {
-
+  // Service the webManager (startup, push events)
+  webCoffee.poll();
 }
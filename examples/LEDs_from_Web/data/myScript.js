@@ -24,15 +24,35 @@ function updateHTML() {
 		document.getElementById("LED2Txt").innerHTML = "On"
 	}
 }
-// Reloading HTML page, after request was processed
+// Update HTML from pushed keyword changes ("LED1State=1&LED2State=0")
+function pushListener(event) {
+	event.data.split("&").forEach(function(pair) {
+		var keyword = pair.split("=")[0];
+		var value = decodeURIComponent(pair.split("=")[1]);
+		var button = document.getElementById(keyword.replace("State", "Button"));
+		if (button) {
+			button.value = keyword + "=" + value;
+		}
+	});
+	updateHTML();
+}
+// Listen for pushed changes, if the browser supports it
+var pushEvents = null;
+if (window.EventSource) {
+	pushEvents = new EventSource("/events");
+	pushEvents.addEventListener("update", pushListener);
+}
+// Reloading HTML page, after request was processed (only needed without push events)
 function apiReplyListener() {
-	setTimeout(() => { location.reload(); }, 500);
+	if (pushEvents == null) {
+		setTimeout(() => { location.reload(); }, 500);
+	}
 }
 // Send API request
 function apiRequest(type, parameter) {
 	var requestUrl = "/api/" + parameter;
 	var xmlHTTP = new XMLHttpRequest();
 	xmlHTTP.open(type, requestUrl, true);
-	xmlHTTP.onload = apiReplyListener();
+	xmlHTTP.onload = apiReplyListener;
 	xmlHTTP.send(null);
 }
\ No newline at end of file
@@ -0,0 +1,678 @@
+/*
+ * Host stand-in of the Arduino-ESP32 core, for building ESPWebManager
+ * off-device. See Arduino.h.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "Arduino.h"
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+// Manual clock, when enabled
+static bool manualClock = false;
+static uint64_t manualMicros = 0;
+// Heap figures reported to the library
+static uint32_t hostFreeHeap = 200000;
+static uint32_t hostMinFreeHeap = 200000;
+
+// Microseconds of the monotonic clock since the first call
+static uint64_t monotonicMicros() {
+	static uint64_t start = 0;
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	uint64_t micros = (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+	if (start == 0) {
+		start = micros - 1;
+	}
+	return micros - start;
+}
+
+// Format an integer in base, as the core does
+static String formatInteger(unsigned long long value, bool negative, unsigned char base) {
+	char buffer[72];
+	char *end = buffer + sizeof(buffer) - 1;
+	*end = '\0';
+	if (base < 2 || base > 36) {
+		base = 10;
+	}
+	do {
+		unsigned digit = value % base;
+		*--end = (digit < 10) ? '0' + digit : 'a' + digit - 10;
+		value /= base;
+	} while (value > 0);
+	if (negative) {
+		*--end = '-';
+	}
+	return String(end);
+}
+
+// Format a floating point number with decimalPlaces decimals
+static String formatFloat(double value, unsigned int decimalPlaces) {
+	char buffer[64];
+	snprintf(buffer, sizeof(buffer), "%.*f", (int)decimalPlaces, value);
+	return String(buffer);
+}
+
+//*************************************************************
+// String
+//*************************************************************
+
+String::String(const char *text) {
+	if (text != nullptr) {
+		copy(text, strlen(text));
+	}
+}
+
+String::String(const char *text, unsigned int length) {
+	copy(text, length);
+}
+
+String::String(const String &other) {
+	copy(other.c_str(), other._length);
+}
+
+String::String(String &&other) : _buffer(other._buffer), _capacity(other._capacity), _length(other._length) {
+	other._buffer = nullptr;
+	other._capacity = 0;
+	other._length = 0;
+}
+
+String::String(char c) {
+	copy(&c, 1);
+}
+
+String::String(unsigned char value, unsigned char base) : String(formatInteger(value, false, base)) {}
+String::String(int value, unsigned char base) : String((base == 10 && value < 0) ? formatInteger(-(long long)value, true, base) : formatInteger((unsigned int)value, false, base)) {}
+String::String(unsigned int value, unsigned char base) : String(formatInteger(value, false, base)) {}
+String::String(long value, unsigned char base) : String((base == 10 && value < 0) ? formatInteger(-(long long)value, true, base) : formatInteger((unsigned long)value, false, base)) {}
+String::String(unsigned long value, unsigned char base) : String(formatInteger(value, false, base)) {}
+String::String(long long value, unsigned char base) : String((base == 10 && value < 0) ? formatInteger(-(unsigned long long)value, true, base) : formatInteger((unsigned long long)value, false, base)) {}
+String::String(unsigned long long value, unsigned char base) : String(formatInteger(value, false, base)) {}
+String::String(float value, unsigned int decimalPlaces) : String(formatFloat(value, decimalPlaces)) {}
+String::String(double value, unsigned int decimalPlaces) : String(formatFloat(value, decimalPlaces)) {}
+
+String::~String() {
+	free(_buffer);
+}
+
+String &String::operator=(const String &other) {
+	if (this != &other) {
+		copy(other.c_str(), other._length);
+	}
+	return *this;
+}
+
+String &String::operator=(const char *text) {
+	return (text == nullptr) ? copy("", 0) : copy(text, strlen(text));
+}
+
+String &String::operator=(String &&other) {
+	if (this != &other) {
+		free(_buffer);
+		_buffer = other._buffer;
+		_capacity = other._capacity;
+		_length = other._length;
+		other._buffer = nullptr;
+		other._capacity = 0;
+		other._length = 0;
+	}
+	return *this;
+}
+
+const char *String::c_str() const {
+	return (_buffer != nullptr) ? _buffer : "";
+}
+
+unsigned int String::length() const {
+	return _length;
+}
+
+bool String::reserve(unsigned int size) {
+	if (_buffer != nullptr && _capacity >= size) {
+		return true;
+	}
+	char *buffer = (char*)realloc(_buffer, size + 1);
+	if (buffer == nullptr) {
+		return false;
+	}
+	if (_buffer == nullptr) {
+		buffer[0] = '\0';
+	}
+	_buffer = buffer;
+	_capacity = size;
+	return true;
+}
+
+bool String::isEmpty() const {
+	return _length == 0;
+}
+
+bool String::concat(const String &other) {
+	return concat(other.c_str(), other._length);
+}
+
+bool String::concat(const char *text) {
+	return text != nullptr && concat(text, strlen(text));
+}
+
+bool String::concat(const char *text, unsigned int length) {
+	if (length == 0) {
+		return true;
+	}
+	// The text may be part of this string, so it is only read after growing through an offset
+	bool self = _buffer != nullptr && text >= _buffer && text < _buffer + _length;
+	size_t offset = self ? text - _buffer : 0;
+	if (!reserve(_length + length)) {
+		return false;
+	}
+	memmove(_buffer + _length, self ? _buffer + offset : text, length);
+	_length += length;
+	_buffer[_length] = '\0';
+	return true;
+}
+
+bool String::concat(char c) {
+	return concat(&c, 1);
+}
+
+bool String::concat(int value) {
+	return concat(String(value));
+}
+
+bool String::concat(unsigned int value) {
+	return concat(String(value));
+}
+
+bool String::concat(long value) {
+	return concat(String(value));
+}
+
+bool String::concat(unsigned long value) {
+	return concat(String(value));
+}
+
+String &String::operator+=(const String &other) {
+	concat(other);
+	return *this;
+}
+
+String &String::operator+=(const char *text) {
+	concat(text);
+	return *this;
+}
+
+String &String::operator+=(char c) {
+	concat(c);
+	return *this;
+}
+
+String &String::operator+=(int value) {
+	concat(value);
+	return *this;
+}
+
+String &String::operator+=(unsigned int value) {
+	concat(value);
+	return *this;
+}
+
+String &String::operator+=(long value) {
+	concat(value);
+	return *this;
+}
+
+String &String::operator+=(unsigned long value) {
+	concat(value);
+	return *this;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+	if (from >= _length) {
+		return -1;
+	}
+	const char *found = strchr(c_str() + from, c);
+	return (found == nullptr) ? -1 : found - c_str();
+}
+
+int String::indexOf(const String &text, unsigned int from) const {
+	if (from > _length) {
+		return -1;
+	}
+	const char *found = strstr(c_str() + from, text.c_str());
+	return (found == nullptr) ? -1 : found - c_str();
+}
+
+int String::lastIndexOf(char c) const {
+	const char *found = strrchr(c_str(), c);
+	return (found == nullptr) ? -1 : found - c_str();
+}
+
+int String::lastIndexOf(const String &text) const {
+	int found = -1;
+	for (int i = indexOf(text); i >= 0; i = indexOf(text, i + 1)) {
+		found = i;
+	}
+	return found;
+}
+
+String String::substring(unsigned int from) const {
+	return substring(from, _length);
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+	if (from > to) {
+		unsigned int swap = from;
+		from = to;
+		to = swap;
+	}
+	if (from >= _length) {
+		return String();
+	}
+	if (to > _length) {
+		to = _length;
+	}
+	return String(c_str() + from, to - from);
+}
+
+long String::toInt() const {
+	return atol(c_str());
+}
+
+float String::toFloat() const {
+	return atof(c_str());
+}
+
+double String::toDouble() const {
+	return atof(c_str());
+}
+
+void String::toLowerCase() {
+	for (unsigned int i = 0; i < _length; i++) {
+		_buffer[i] = tolower((unsigned char)_buffer[i]);
+	}
+}
+
+void String::toCharArray(char *buffer, unsigned int size, unsigned int index) const {
+	if (size == 0) {
+		return;
+	}
+	unsigned int count = (index < _length) ? _length - index : 0;
+	if (count > size - 1) {
+		count = size - 1;
+	}
+	memcpy(buffer, c_str() + index, count);
+	buffer[count] = '\0';
+}
+
+bool String::equals(const String &other) const {
+	return _length == other._length && memcmp(c_str(), other.c_str(), _length) == 0;
+}
+
+bool String::equals(const char *text) const {
+	return strcmp(c_str(), text != nullptr ? text : "") == 0;
+}
+
+bool String::equalsIgnoreCase(const String &other) const {
+	return _length == other._length && strcasecmp(c_str(), other.c_str()) == 0;
+}
+
+int String::compareTo(const String &other) const {
+	return strcmp(c_str(), other.c_str());
+}
+
+bool String::startsWith(const String &prefix) const {
+	return prefix._length <= _length && strncmp(c_str(), prefix.c_str(), prefix._length) == 0;
+}
+
+bool String::endsWith(const String &suffix) const {
+	return suffix._length <= _length && strcmp(c_str() + _length - suffix._length, suffix.c_str()) == 0;
+}
+
+bool String::operator==(const String &other) const {
+	return equals(other);
+}
+
+bool String::operator==(const char *text) const {
+	return equals(text);
+}
+
+bool String::operator!=(const String &other) const {
+	return !equals(other);
+}
+
+bool String::operator!=(const char *text) const {
+	return !equals(text);
+}
+
+char String::charAt(unsigned int index) const {
+	return (index < _length) ? _buffer[index] : '\0';
+}
+
+char String::operator[](unsigned int index) const {
+	return charAt(index);
+}
+
+char &String::operator[](unsigned int index) {
+	static char dummy;
+	if (index >= _length) {
+		dummy = '\0';
+		return dummy;
+	}
+	return _buffer[index];
+}
+
+// Replace the text
+String &String::copy(const char *text, unsigned int length) {
+	// An empty string needs no buffer, as the ESP32 core keeps short strings in place
+	if (length == 0 && _buffer == nullptr) {
+		_length = 0;
+		return *this;
+	}
+	if (!reserve(length)) {
+		return *this;
+	}
+	memmove(_buffer, text, length);
+	_buffer[length] = '\0';
+	_length = length;
+	return *this;
+}
+
+String operator+(const String &left, const String &right) {
+	String result(left);
+	result += right;
+	return result;
+}
+
+String operator+(const String &left, const char *right) {
+	String result(left);
+	result += right;
+	return result;
+}
+
+String operator+(const char *left, const String &right) {
+	String result(left);
+	result += right;
+	return result;
+}
+
+//*************************************************************
+// Print
+//*************************************************************
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+	size_t written = 0;
+	while (written < size && write(buffer[written]) == 1) {
+		written++;
+	}
+	return written;
+}
+
+size_t Print::write(const char *text) {
+	return (text == nullptr) ? 0 : write((const uint8_t*)text, strlen(text));
+}
+
+size_t Print::write(const char *buffer, size_t size) {
+	return write((const uint8_t*)buffer, size);
+}
+
+size_t Print::printf(const char *format, ...) {
+	// Formatted on the stack, as the core does for short lines
+	char buffer[64];
+	va_list arguments;
+	va_start(arguments, format);
+	int length = vsnprintf(buffer, sizeof(buffer), format, arguments);
+	va_end(arguments);
+	if (length < 0) {
+		return 0;
+	}
+	if ((size_t)length < sizeof(buffer)) {
+		return write((const uint8_t*)buffer, length);
+	}
+	char *text = (char*)malloc(length + 1);
+	if (text == nullptr) {
+		return 0;
+	}
+	va_start(arguments, format);
+	vsnprintf(text, length + 1, format, arguments);
+	va_end(arguments);
+	size_t written = write((const uint8_t*)text, length);
+	free(text);
+	return written;
+}
+
+size_t Print::print(const String &text) {
+	return write((const uint8_t*)text.c_str(), text.length());
+}
+
+size_t Print::print(const char *text) {
+	return write(text);
+}
+
+size_t Print::print(char c) {
+	return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char value, int base) {
+	return print(String(value, base));
+}
+
+size_t Print::print(int value, int base) {
+	return print(String(value, base));
+}
+
+size_t Print::print(unsigned int value, int base) {
+	return print(String(value, base));
+}
+
+size_t Print::print(long value, int base) {
+	return print(String(value, base));
+}
+
+size_t Print::print(unsigned long value, int base) {
+	return print(String(value, base));
+}
+
+size_t Print::print(double value, int digits) {
+	return print(String(value, digits));
+}
+
+size_t Print::print(const Printable &printable) {
+	return printable.printTo(*this);
+}
+
+size_t Print::println(const String &text) {
+	return print(text) + println();
+}
+
+size_t Print::println(const char *text) {
+	return print(text) + println();
+}
+
+size_t Print::println(char c) {
+	return print(c) + println();
+}
+
+size_t Print::println(unsigned char value, int base) {
+	return print(value, base) + println();
+}
+
+size_t Print::println(int value, int base) {
+	return print(value, base) + println();
+}
+
+size_t Print::println(unsigned int value, int base) {
+	return print(value, base) + println();
+}
+
+size_t Print::println(long value, int base) {
+	return print(value, base) + println();
+}
+
+size_t Print::println(unsigned long value, int base) {
+	return print(value, base) + println();
+}
+
+size_t Print::println(double value, int digits) {
+	return print(value, digits) + println();
+}
+
+size_t Print::println(const Printable &printable) {
+	return print(printable) + println();
+}
+
+size_t Print::println(void) {
+	return write("\r\n");
+}
+
+//*************************************************************
+// Serial
+//*************************************************************
+
+void HardwareSerial::begin(unsigned long baud) {}
+
+int HardwareSerial::available() {
+	return 0;
+}
+
+int HardwareSerial::read() {
+	return -1;
+}
+
+int HardwareSerial::peek() {
+	return -1;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+	return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+	return fwrite(buffer, 1, size, stdout);
+}
+
+int HardwareSerial::availableForWrite() {
+	return 128;
+}
+
+//*************************************************************
+// IPAddress
+//*************************************************************
+
+IPAddress::IPAddress() : _address(0) {}
+
+IPAddress::IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _address(a | (b << 8) | (c << 16) | ((uint32_t)d << 24)) {}
+
+IPAddress::IPAddress(uint32_t address) : _address(address) {}
+
+IPAddress::operator uint32_t() const {
+	return _address;
+}
+
+String IPAddress::toString() const {
+	char text[16];
+	snprintf(text, sizeof(text), "%u.%u.%u.%u", _address & 0xFF, (_address >> 8) & 0xFF, (_address >> 16) & 0xFF, _address >> 24);
+	return String(text);
+}
+
+size_t IPAddress::printTo(Print &p) const {
+	return p.print(toString());
+}
+
+//*************************************************************
+// ESP, time, pins and heap
+//*************************************************************
+
+uint32_t EspClass::getFreeHeap() {
+	return hostFreeHeap;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+	return hostMinFreeHeap;
+}
+
+uint32_t EspClass::getMaxAllocHeap() {
+	return hostFreeHeap;
+}
+
+uint32_t EspClass::getPsramSize() {
+	return 0;
+}
+
+unsigned long millis() {
+	return micros() / 1000;
+}
+
+unsigned long micros() {
+	return manualClock ? manualMicros : monotonicMicros();
+}
+
+void delay(uint32_t ms) {
+	if (manualClock) {
+		manualMicros += (uint64_t)ms * 1000;
+	} else {
+		usleep(ms * 1000);
+	}
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+void digitalWrite(uint8_t pin, uint8_t value) {}
+
+bool psramFound() {
+	return false;
+}
+
+void *ps_malloc(size_t size) {
+	return malloc(size);
+}
+
+#ifndef hostHaveStrlcpy
+extern "C" size_t strlcpy(char *destination, const char *source, size_t size) {
+	size_t length = strlen(source);
+	if (size > 0) {
+		size_t count = (length < size - 1) ? length : size - 1;
+		memcpy(destination, source, count);
+		destination[count] = '\0';
+	}
+	return length;
+}
+#endif
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+	return hostFreeHeap;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+	return hostFreeHeap;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+	return hostMinFreeHeap;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps) {
+	return malloc(size);
+}
+
+void hostManualClock(bool manual) {
+	if (manual && !manualClock) {
+		manualMicros = monotonicMicros();
+	}
+	manualClock = manual;
+}
+
+void hostAdvanceClock(uint32_t ms) {
+	manualMicros += (uint64_t)ms * 1000;
+}
+
+void hostSetFreeHeap(uint32_t freeHeap) {
+	hostFreeHeap = freeHeap;
+	if (freeHeap < hostMinFreeHeap) {
+		hostMinFreeHeap = freeHeap;
+	}
+}
\ No newline at end of file
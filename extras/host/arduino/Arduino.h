@@ -0,0 +1,242 @@
+/*
+ * Host stand-in of the Arduino-ESP32 core, for building ESPWebManager
+ * off-device. It implements the parts of the core the library uses
+ * (String, Print, Serial, millis() and micros(), ESP, PSRAM and pin
+ * functions) on POSIX, so the library can be tested and benchmarked
+ * on a plain Linux box.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+// Ensure the stand-in is only included once
+#ifndef _HostArduino_
+#define _HostArduino_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include "esp_heap_caps.h"
+
+#define PGM_P const char *
+#define PROGMEM
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define ESP_ARDUINO_VERSION_MAJOR 2
+
+class Print;
+
+// Arduino String, growing its buffer with realloc() as the core does (without the small string optimisation)
+class String {
+	public:
+		String(const char *text = "");
+		String(const char *text, unsigned int length);
+		String(const String &other);
+		String(String &&other);
+		String(char c);
+		explicit String(unsigned char value, unsigned char base = 10);
+		explicit String(int value, unsigned char base = 10);
+		explicit String(unsigned int value, unsigned char base = 10);
+		explicit String(long value, unsigned char base = 10);
+		explicit String(unsigned long value, unsigned char base = 10);
+		explicit String(long long value, unsigned char base = 10);
+		explicit String(unsigned long long value, unsigned char base = 10);
+		explicit String(float value, unsigned int decimalPlaces = 2);
+		explicit String(double value, unsigned int decimalPlaces = 2);
+		~String();
+
+		String &operator=(const String &other);
+		String &operator=(const char *text);
+		String &operator=(String &&other);
+
+		const char *c_str() const;
+		unsigned int length() const;
+		bool reserve(unsigned int size);
+		bool isEmpty() const;
+
+		bool concat(const String &other);
+		bool concat(const char *text);
+		bool concat(const char *text, unsigned int length);
+		bool concat(char c);
+		bool concat(int value);
+		bool concat(unsigned int value);
+		bool concat(long value);
+		bool concat(unsigned long value);
+		String &operator+=(const String &other);
+		String &operator+=(const char *text);
+		String &operator+=(char c);
+		String &operator+=(int value);
+		String &operator+=(unsigned int value);
+		String &operator+=(long value);
+		String &operator+=(unsigned long value);
+
+		int indexOf(char c, unsigned int from = 0) const;
+		int indexOf(const String &text, unsigned int from = 0) const;
+		int lastIndexOf(char c) const;
+		int lastIndexOf(const String &text) const;
+		String substring(unsigned int from) const;
+		String substring(unsigned int from, unsigned int to) const;
+		long toInt() const;
+		float toFloat() const;
+		double toDouble() const;
+		void toLowerCase();
+		void toCharArray(char *buffer, unsigned int size, unsigned int index = 0) const;
+
+		bool equals(const String &other) const;
+		bool equals(const char *text) const;
+		bool equalsIgnoreCase(const String &other) const;
+		int compareTo(const String &other) const;
+		bool startsWith(const String &prefix) const;
+		bool endsWith(const String &suffix) const;
+		bool operator==(const String &other) const;
+		bool operator==(const char *text) const;
+		bool operator!=(const String &other) const;
+		bool operator!=(const char *text) const;
+		char charAt(unsigned int index) const;
+		char operator[](unsigned int index) const;
+		char &operator[](unsigned int index);
+
+	private:
+		// Buffer, nullptr while empty
+		char *_buffer = nullptr;
+		// Room in the buffer, without the terminator
+		unsigned int _capacity = 0;
+		// Length of the text
+		unsigned int _length = 0;
+
+		// Replace the text
+		String &copy(const char *text, unsigned int length);
+};
+
+String operator+(const String &left, const String &right);
+String operator+(const String &left, const char *right);
+String operator+(const char *left, const String &right);
+
+class Printable;
+
+// Arduino Print, with printf() as the ESP32 core
+class Print {
+	public:
+		virtual ~Print() {}
+		virtual size_t write(uint8_t c) = 0;
+		virtual size_t write(const uint8_t *buffer, size_t size);
+		size_t write(const char *text);
+		size_t write(const char *buffer, size_t size);
+
+		size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+		size_t print(const String &text);
+		size_t print(const char *text);
+		size_t print(char c);
+		size_t print(unsigned char value, int base = 10);
+		size_t print(int value, int base = 10);
+		size_t print(unsigned int value, int base = 10);
+		size_t print(long value, int base = 10);
+		size_t print(unsigned long value, int base = 10);
+		size_t print(double value, int digits = 2);
+		size_t print(const Printable &printable);
+		size_t println(const String &text);
+		size_t println(const char *text);
+		size_t println(char c);
+		size_t println(unsigned char value, int base = 10);
+		size_t println(int value, int base = 10);
+		size_t println(unsigned int value, int base = 10);
+		size_t println(long value, int base = 10);
+		size_t println(unsigned long value, int base = 10);
+		size_t println(double value, int digits = 2);
+		size_t println(const Printable &printable);
+		size_t println(void);
+};
+
+// Something that prints itself
+class Printable {
+	public:
+		virtual ~Printable() {}
+		virtual size_t printTo(Print &p) const = 0;
+};
+
+// Arduino Stream
+class Stream : public Print {
+	public:
+		virtual int available() = 0;
+		virtual int read() = 0;
+		virtual int peek() = 0;
+};
+
+// Serial port, writing to stdout
+class HardwareSerial : public Stream {
+	public:
+		void begin(unsigned long baud);
+		int available();
+		int read();
+		int peek();
+		size_t write(uint8_t c);
+		size_t write(const uint8_t *buffer, size_t size);
+		int availableForWrite();
+		using Print::write;
+};
+extern HardwareSerial Serial;
+
+// IPv4 address, in network order as the ESP32 core
+class IPAddress : public Printable {
+	public:
+		IPAddress();
+		IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d);
+		IPAddress(uint32_t address);
+		operator uint32_t() const;
+		String toString() const;
+		size_t printTo(Print &p) const;
+
+	private:
+		uint32_t _address;
+};
+
+// ESP chip functions, heap figures come from hostSetFreeHeap()
+class EspClass {
+	public:
+		uint32_t getFreeHeap();
+		uint32_t getMinFreeHeap();
+		uint32_t getMaxAllocHeap();
+		uint32_t getPsramSize();
+};
+extern EspClass ESP;
+
+// Time since start, from the monotonic clock or the manual clock
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+
+// Pins, without effect
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+
+// PSRAM, never present on the host
+bool psramFound();
+void *ps_malloc(size_t size);
+
+// Missing from glibc before 2.38, the host build defines hostHaveStrlcpy when the C library has it
+#ifndef hostHaveStrlcpy
+extern "C" size_t strlcpy(char *destination, const char *source, size_t size);
+#endif
+
+// Critical sections, the host build is single threaded where it matters
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+// Host only: drive millis() and micros() by hand instead of from the monotonic clock, for tests of timing
+void hostManualClock(bool manual);
+// Host only: advance the manual clock
+void hostAdvanceClock(uint32_t ms);
+// Host only: set the free heap reported by ESP.getFreeHeap() and heap_caps_get_largest_free_block()
+void hostSetFreeHeap(uint32_t freeHeap);
+#endif
\ No newline at end of file
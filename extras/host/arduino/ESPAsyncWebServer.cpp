@@ -0,0 +1,840 @@
+/*
+ * Host stand-in of ESPAsyncWebServer, for building ESPWebManager
+ * off-device. See ESPAsyncWebServer.h.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "ESPAsyncWebServer.h"
+
+// Filler result asking to be called again, as ESPAsyncWebServer
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+// Longest template placeholder name, as ESPAsyncWebServer
+#define TEMPLATE_PARAM_NAME_LENGTH 32
+// Size of each fill of a callback response, as one TCP segment
+#define hostFillSize 1460
+
+// Decode %xx escapes and '+' of a URL part
+String hostUrlDecode(const char *text, size_t length) {
+	String decoded;
+	decoded.reserve(length);
+	for (size_t i = 0; i < length; i++) {
+		if (text[i] == '%' && i + 2 < length && isxdigit((unsigned char)text[i + 1]) && isxdigit((unsigned char)text[i + 2])) {
+			char hex[3] = {text[i + 1], text[i + 2], '\0'};
+			decoded += (char)strtoul(hex, nullptr, 16);
+			i += 2;
+		} else if (text[i] == '+') {
+			decoded += ' ';
+		} else {
+			decoded += text[i];
+		}
+	}
+	return decoded;
+}
+
+// Replace %NAME% placeholders with the processor result, and %% with %, as ESPAsyncWebServer
+std::string hostProcessTemplate(const std::string &content, const AwsTemplateProcessor &processor) {
+	std::string result;
+	result.reserve(content.size());
+	size_t i = 0;
+	while (i < content.size()) {
+		if (content[i] != '%') {
+			result += content[i++];
+			continue;
+		}
+		size_t end = content.find('%', i + 1);
+		if (end == std::string::npos || end - i - 1 > TEMPLATE_PARAM_NAME_LENGTH) {
+			result += content[i++];
+		} else if (end == i + 1) {
+			result += '%';
+			i = end + 1;
+		} else {
+			String value = processor(String(content.c_str() + i + 1, end - i - 1));
+			result.append(value.c_str(), value.length());
+			i = end + 1;
+		}
+	}
+	return result;
+}
+
+// Response with a String body
+class hostBasicResponse : public AsyncWebServerResponse {
+	public:
+		hostBasicResponse(int code, const String &contentType, const String &content) : AsyncWebServerResponse(code, contentType), _content(content) {}
+		std::string body() {
+			return std::string(_content.c_str(), _content.length());
+		}
+
+	private:
+		String _content;
+};
+
+// Response sent from memory without copying, as beginResponse_P()
+class hostMemoryResponse : public AsyncWebServerResponse {
+	public:
+		hostMemoryResponse(int code, const String &contentType, const uint8_t *content, size_t length, AwsTemplateProcessor processor) : AsyncWebServerResponse(code, contentType), _content(content), _length(length), _processor(processor) {}
+		std::string body() {
+			std::string content((const char*)_content, _length);
+			return _processor ? hostProcessTemplate(content, _processor) : content;
+		}
+
+	private:
+		const uint8_t *_content;
+		size_t _length;
+		AwsTemplateProcessor _processor;
+};
+
+// Response filled by a callback, of a known length or chunked
+class hostCallbackResponse : public AsyncWebServerResponse {
+	public:
+		hostCallbackResponse(const String &contentType, size_t length, AwsResponseFiller filler, AwsTemplateProcessor processor) : AsyncWebServerResponse(200, contentType), _length(length), _filler(filler), _processor(processor) {}
+		std::string body() {
+			std::string content;
+			uint8_t buffer[hostFillSize];
+			uint32_t retries = 0;
+			while (content.size() < _length) {
+				size_t room = (_length - content.size() < sizeof(buffer)) ? _length - content.size() : sizeof(buffer);
+				size_t filled = _filler(buffer, room, content.size());
+				if (filled == RESPONSE_TRY_AGAIN) {
+					// A filler waiting for data it never gets would hang the real server as well
+					if (++retries > 1000000) {
+						break;
+					}
+					continue;
+				}
+				if (filled == 0) {
+					break;
+				}
+				content.append((const char*)buffer, filled);
+			}
+			return _processor ? hostProcessTemplate(content, _processor) : content;
+		}
+
+	private:
+		size_t _length;
+		AwsResponseFiller _filler;
+		AwsTemplateProcessor _processor;
+};
+
+// Response sent from a file, from its .gz sibling if only that exists
+class hostFileResponse : public AsyncWebServerResponse {
+	public:
+		hostFileResponse(File file, const String &contentType, AwsTemplateProcessor processor) : AsyncWebServerResponse(200, contentType), _file(file), _processor(processor) {}
+		~hostFileResponse() {
+			_file.close();
+		}
+		bool sourceValid() const {
+			return (bool)_file;
+		}
+		std::string body() {
+			std::string content;
+			uint8_t buffer[hostFillSize];
+			size_t read;
+			while ((read = _file.read(buffer, sizeof(buffer))) > 0) {
+				content.append((const char*)buffer, read);
+			}
+			return _processor ? hostProcessTemplate(content, _processor) : content;
+		}
+
+	private:
+		File _file;
+		AwsTemplateProcessor _processor;
+};
+
+// Content type from the file extension, for responses given none
+static String contentTypeOf(const String &path) {
+	if (path.endsWith(".html") || path.endsWith(".htm")) {
+		return "text/html";
+	} else if (path.endsWith(".css")) {
+		return "text/css";
+	} else if (path.endsWith(".js")) {
+		return "application/javascript";
+	} else if (path.endsWith(".json")) {
+		return "application/json";
+	}
+	return "text/plain";
+}
+
+//*************************************************************
+// Parameters, headers and clients
+//*************************************************************
+
+AsyncClient::AsyncClient(uint32_t address) : _address(address) {}
+
+IPAddress AsyncClient::remoteIP() {
+	return IPAddress(_address);
+}
+
+uint16_t AsyncClient::remotePort() {
+	return 0;
+}
+
+AsyncWebParameter::AsyncWebParameter(const String &name, const String &value) : _name(name), _value(value) {}
+
+const String &AsyncWebParameter::name() const {
+	return _name;
+}
+
+const String &AsyncWebParameter::value() const {
+	return _value;
+}
+
+size_t AsyncWebParameter::size() const {
+	return _value.length();
+}
+
+bool AsyncWebParameter::isPost() const {
+	return false;
+}
+
+bool AsyncWebParameter::isFile() const {
+	return false;
+}
+
+AsyncWebHeader::AsyncWebHeader(const String &name, const String &value) : _name(name), _value(value) {}
+
+const String &AsyncWebHeader::name() const {
+	return _name;
+}
+
+const String &AsyncWebHeader::value() const {
+	return _value;
+}
+
+//*************************************************************
+// Responses
+//*************************************************************
+
+AsyncWebServerResponse::AsyncWebServerResponse(int code, const String &contentType) : _code(code), _contentType(contentType) {}
+
+AsyncWebServerResponse::~AsyncWebServerResponse() {}
+
+void AsyncWebServerResponse::setCode(int code) {
+	_code = code;
+}
+
+void AsyncWebServerResponse::setContentLength(size_t length) {}
+
+void AsyncWebServerResponse::setContentType(const String &type) {
+	_contentType = type;
+}
+
+void AsyncWebServerResponse::addHeader(const String &name, const String &value) {
+	_headers.push_back(AsyncWebHeader(name, value));
+}
+
+int AsyncWebServerResponse::code() const {
+	return _code;
+}
+
+const String &AsyncWebServerResponse::contentType() const {
+	return _contentType;
+}
+
+const std::vector<AsyncWebHeader> &AsyncWebServerResponse::headers() const {
+	return _headers;
+}
+
+bool AsyncWebServerResponse::sourceValid() const {
+	return true;
+}
+
+AsyncResponseStream::AsyncResponseStream(const String &contentType, size_t bufferSize) : AsyncWebServerResponse(200, contentType) {
+	_content.reserve(bufferSize);
+}
+
+size_t AsyncResponseStream::write(const uint8_t *data, size_t length) {
+	_content.append((const char*)data, length);
+	return length;
+}
+
+size_t AsyncResponseStream::write(uint8_t data) {
+	return write(&data, 1);
+}
+
+std::string AsyncResponseStream::body() {
+	return _content;
+}
+
+//*************************************************************
+// Handlers
+//*************************************************************
+
+AsyncWebHandler &AsyncWebHandler::setFilter(ArRequestFilterFunction filter) {
+	_filter = filter;
+	return *this;
+}
+
+bool AsyncWebHandler::filter(AsyncWebServerRequest *request) {
+	return !_filter || _filter(request);
+}
+
+AsyncCallbackWebHandler::AsyncCallbackWebHandler(const String &uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) : _uri(uri), _method(method), _onRequest(onRequest) {}
+
+bool AsyncCallbackWebHandler::canHandle(AsyncWebServerRequest *request) {
+	if (!_onRequest || !(_method & request->method())) {
+		return false;
+	}
+	if (_uri.length() > 0 && _uri.startsWith("/*.")) {
+		// Extension pattern
+		if (!request->url().endsWith(_uri.substring(_uri.lastIndexOf('.')))) {
+			return false;
+		}
+	} else if (_uri.length() > 0 && _uri.endsWith("*")) {
+		// Prefix pattern
+		if (!request->url().startsWith(_uri.substring(0, _uri.length() - 1))) {
+			return false;
+		}
+	} else if (_uri.length() > 0 && _uri != request->url() && !request->url().startsWith(_uri + "/")) {
+		return false;
+	}
+	request->addInterestingHeader("ANY");
+	return true;
+}
+
+void AsyncCallbackWebHandler::handleRequest(AsyncWebServerRequest *request) {
+	if (_onRequest) {
+		_onRequest(request);
+	} else {
+		request->send(500);
+	}
+}
+
+//*************************************************************
+// Requests
+//*************************************************************
+
+AsyncWebServerRequest::AsyncWebServerRequest(AsyncWebServer *server, WebRequestMethodComposite method, const char *url, uint32_t address) : _server(server), _client(address), _method(method) {
+	// The path is decoded, and the query split into parameters
+	const char *query = strchr(url, '?');
+	size_t pathLength = (query != nullptr) ? (size_t)(query - url) : strlen(url);
+	_url = hostUrlDecode(url, pathLength);
+	while (query != nullptr && *query != '\0') {
+		query++;
+		const char *end = strchr(query, '&');
+		size_t length = (end != nullptr) ? (size_t)(end - query) : strlen(query);
+		const char *equals = (const char*)memchr(query, '=', length);
+		if (length > 0) {
+			if (equals != nullptr) {
+				_params.push_back(new AsyncWebParameter(hostUrlDecode(query, equals - query), hostUrlDecode(equals + 1, query + length - equals - 1)));
+			} else {
+				_params.push_back(new AsyncWebParameter(hostUrlDecode(query, length), String()));
+			}
+		}
+		query = end;
+	}
+}
+
+AsyncWebServerRequest::~AsyncWebServerRequest() {
+	for (size_t i = 0; i < _disconnectHandlers.size(); i++) {
+		_disconnectHandlers[i]();
+	}
+	for (size_t i = 0; i < _params.size(); i++) {
+		delete _params[i];
+	}
+	for (size_t i = 0; i < _headers.size(); i++) {
+		delete _headers[i];
+	}
+	delete _response;
+	free(_tempObject);
+	_tempFile.close();
+}
+
+AsyncClient *AsyncWebServerRequest::client() {
+	return &_client;
+}
+
+uint8_t AsyncWebServerRequest::version() const {
+	return 1;
+}
+
+WebRequestMethodComposite AsyncWebServerRequest::method() const {
+	return _method;
+}
+
+const String &AsyncWebServerRequest::url() const {
+	return _url;
+}
+
+const String &AsyncWebServerRequest::host() const {
+	return _host;
+}
+
+const String &AsyncWebServerRequest::contentType() const {
+	static const String none;
+	return none;
+}
+
+size_t AsyncWebServerRequest::contentLength() const {
+	return 0;
+}
+
+const char *AsyncWebServerRequest::methodToString() const {
+	switch (_method) {
+		case HTTP_GET: return "GET";
+		case HTTP_POST: return "POST";
+		case HTTP_DELETE: return "DELETE";
+		case HTTP_PUT: return "PUT";
+		case HTTP_PATCH: return "PATCH";
+		case HTTP_HEAD: return "HEAD";
+		case HTTP_OPTIONS: return "OPTIONS";
+	}
+	return "UNKNOWN";
+}
+
+void AsyncWebServerRequest::onDisconnect(ArDisconnectHandler handler) {
+	_disconnectHandlers.push_back(handler);
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse *response) {
+	if (response == nullptr) {
+		return;
+	}
+	delete _response;
+	_response = response;
+	// As ESPAsyncWebServer, a response without a source becomes a 500
+	if (!response->sourceValid()) {
+		delete response;
+		_response = nullptr;
+		send(500);
+	}
+}
+
+void AsyncWebServerRequest::send(int code, const String &contentType, const String &content) {
+	send(beginResponse(code, contentType, content));
+}
+
+void AsyncWebServerRequest::send(FS &fs, const String &path, const String &contentType, bool download, AwsTemplateProcessor callback) {
+	if (fs.exists(path) || (!download && fs.exists(path + ".gz"))) {
+		send(beginResponse(fs, path, contentType, download, callback));
+	} else {
+		send(404);
+	}
+}
+
+void AsyncWebServerRequest::send(File content, const String &path, const String &contentType, bool download, AwsTemplateProcessor callback) {
+	if (content) {
+		send(beginResponse(content, path, contentType, download, callback));
+	} else {
+		send(404);
+	}
+}
+
+void AsyncWebServerRequest::send(const String &contentType, size_t length, AwsResponseFiller callback, AwsTemplateProcessor templateCallback) {
+	send(beginResponse(contentType, length, callback, templateCallback));
+}
+
+void AsyncWebServerRequest::sendChunked(const String &contentType, AwsResponseFiller callback, AwsTemplateProcessor templateCallback) {
+	send(beginChunkedResponse(contentType, callback, templateCallback));
+}
+
+void AsyncWebServerRequest::send_P(int code, const String &contentType, const uint8_t *content, size_t length, AwsTemplateProcessor callback) {
+	send(beginResponse_P(code, contentType, content, length, callback));
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(int code, const String &contentType, const String &content) {
+	return new hostBasicResponse(code, contentType, content);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(FS &fs, const String &path, const String &contentType, bool download, AwsTemplateProcessor callback) {
+	// As ESPAsyncWebServer, nullptr if neither the file nor its .gz sibling exists
+	String type = contentType.length() > 0 ? contentType : contentTypeOf(path);
+	if (fs.exists(path)) {
+		return new hostFileResponse(fs.open(path, "r"), type, callback);
+	}
+	if (!download && fs.exists(path + ".gz")) {
+		// Compressed files are sent as they are, templates can not be processed
+		AsyncWebServerResponse *response = new hostFileResponse(fs.open(path + ".gz", "r"), type, nullptr);
+		response->addHeader("Content-Encoding", "gzip");
+		return response;
+	}
+	return nullptr;
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(File content, const String &path, const String &contentType, bool download, AwsTemplateProcessor callback) {
+	return new hostFileResponse(content, contentType.length() > 0 ? contentType : contentTypeOf(path), callback);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(const String &contentType, size_t length, AwsResponseFiller callback, AwsTemplateProcessor templateCallback) {
+	return new hostCallbackResponse(contentType, length, callback, templateCallback);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginChunkedResponse(const String &contentType, AwsResponseFiller callback, AwsTemplateProcessor templateCallback) {
+	return new hostCallbackResponse(contentType, SIZE_MAX, callback, templateCallback);
+}
+
+AsyncResponseStream *AsyncWebServerRequest::beginResponseStream(const String &contentType, size_t bufferSize) {
+	return new AsyncResponseStream(contentType, bufferSize);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse_P(int code, const String &contentType, const uint8_t *content, size_t length, AwsTemplateProcessor callback) {
+	return new hostMemoryResponse(code, contentType, content, length, callback);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse_P(int code, const String &contentType, PGM_P content, AwsTemplateProcessor callback) {
+	return beginResponse_P(code, contentType, (const uint8_t*)content, strlen(content), callback);
+}
+
+size_t AsyncWebServerRequest::headers() const {
+	return _headers.size();
+}
+
+bool AsyncWebServerRequest::hasHeader(const String &name) const {
+	return getHeader(name) != nullptr;
+}
+
+bool AsyncWebServerRequest::hasHeader(const char *name) const {
+	return getHeader(name) != nullptr;
+}
+
+AsyncWebHeader *AsyncWebServerRequest::getHeader(const String &name) const {
+	return getHeader(name.c_str());
+}
+
+AsyncWebHeader *AsyncWebServerRequest::getHeader(const char *name) const {
+	for (size_t i = 0; i < _headers.size(); i++) {
+		if (strcasecmp(_headers[i]->name().c_str(), name) == 0) {
+			return _headers[i];
+		}
+	}
+	return nullptr;
+}
+
+size_t AsyncWebServerRequest::params() const {
+	return _params.size();
+}
+
+bool AsyncWebServerRequest::hasParam(const String &name, bool post, bool file) const {
+	return getParam(name, post, file) != nullptr;
+}
+
+AsyncWebParameter *AsyncWebServerRequest::getParam(const String &name, bool post, bool file) const {
+	for (size_t i = 0; i < _params.size(); i++) {
+		if (_params[i]->name() == name && !post && !file) {
+			return _params[i];
+		}
+	}
+	return nullptr;
+}
+
+AsyncWebParameter *AsyncWebServerRequest::getParam(size_t index) const {
+	return (index < _params.size()) ? _params[index] : nullptr;
+}
+
+void AsyncWebServerRequest::addInterestingHeader(const String &name) {
+	for (size_t i = 0; i < _interestingHeaders.size(); i++) {
+		if (_interestingHeaders[i].equalsIgnoreCase(name)) {
+			return;
+		}
+	}
+	_interestingHeaders.push_back(name);
+}
+
+// Add a header, if a handler asked for it
+void AsyncWebServerRequest::addHeader(const String &name, const String &value) {
+	if (name.equalsIgnoreCase("Host")) {
+		_host = value;
+	}
+	for (size_t i = 0; i < _interestingHeaders.size(); i++) {
+		if (_interestingHeaders[i].equalsIgnoreCase(name) || _interestingHeaders[i] == "ANY") {
+			_headers.push_back(new AsyncWebHeader(name, value));
+			return;
+		}
+	}
+}
+
+//*************************************************************
+// Server
+//*************************************************************
+
+const char *hostReply::header(const char *name) const {
+	for (size_t i = 0; i < headers.size(); i++) {
+		if (strcasecmp(headers[i].name().c_str(), name) == 0) {
+			return headers[i].value().c_str();
+		}
+	}
+	return nullptr;
+}
+
+// Servers between begin() and end()
+static std::vector<AsyncWebServer*> startedServers;
+
+AsyncWebServer::AsyncWebServer(uint16_t port) : _port(port) {}
+
+AsyncWebServer::~AsyncWebServer() {
+	end();
+	for (size_t i = 0; i < _handlers.size(); i++) {
+		delete _handlers[i];
+	}
+}
+
+void AsyncWebServer::begin() {
+	end();
+	startedServers.push_back(this);
+}
+
+void AsyncWebServer::end() {
+	for (size_t i = 0; i < startedServers.size(); i++) {
+		if (startedServers[i] == this) {
+			startedServers.erase(startedServers.begin() + i);
+			return;
+		}
+	}
+}
+
+AsyncWebServer *AsyncWebServer::hostServer(uint16_t port) {
+	for (size_t i = 0; i < startedServers.size(); i++) {
+		if (startedServers[i]->_port == port) {
+			return startedServers[i];
+		}
+	}
+	return nullptr;
+}
+
+AsyncWebHandler *AsyncWebServer::hostHandler(size_t index) const {
+	return index < _handlers.size() ? _handlers[index] : nullptr;
+}
+
+AsyncWebHandler &AsyncWebServer::addHandler(AsyncWebHandler *handler) {
+	_handlers.push_back(handler);
+	return *handler;
+}
+
+bool AsyncWebServer::removeHandler(AsyncWebHandler *handler) {
+	for (size_t i = 0; i < _handlers.size(); i++) {
+		if (_handlers[i] == handler) {
+			_handlers.erase(_handlers.begin() + i);
+			return true;
+		}
+	}
+	return false;
+}
+
+AsyncCallbackWebHandler &AsyncWebServer::on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) {
+	AsyncCallbackWebHandler *handler = new AsyncCallbackWebHandler(uri, method, onRequest);
+	addHandler(handler);
+	return *handler;
+}
+
+void AsyncWebServer::onNotFound(ArRequestHandlerFunction onRequest) {
+	_notFound = onRequest;
+}
+
+// Serve a request in process
+hostReply AsyncWebServer::request(WebRequestMethodComposite method, const char *url, const std::vector<AsyncWebHeader> &headers, uint32_t address) {
+	AsyncWebServerRequest *request = new AsyncWebServerRequest(this, method, url, address);
+	// As ESPAsyncWebServer, the handler is picked once the request line is read, before the headers
+	for (size_t i = 0; i < _handlers.size() && request->_handler == nullptr; i++) {
+		if (_handlers[i]->filter(request) && _handlers[i]->canHandle(request)) {
+			request->_handler = _handlers[i];
+		}
+	}
+	for (size_t i = 0; i < headers.size(); i++) {
+		request->addHeader(headers[i].name(), headers[i].value());
+	}
+	if (request->_handler != nullptr) {
+		request->_handler->handleRequest(request);
+	} else if (_notFound) {
+		_notFound(request);
+	} else {
+		request->send(404);
+	}
+	hostReply reply = {0, String(), std::vector<AsyncWebHeader>(), std::string()};
+	if (request->_response != nullptr) {
+		reply.code = request->_response->code();
+		reply.contentType = request->_response->contentType();
+		reply.headers = request->_response->headers();
+		reply.body = request->_response->body();
+	}
+	// Runs the disconnect handlers, as when the connection closes after the response
+	delete request;
+	return reply;
+}
+
+//*************************************************************
+// Event source
+//*************************************************************
+
+void AsyncEventSourceClient::send(const char *message, const char *event, uint32_t id, uint32_t reconnect) {
+	std::string text;
+	if (id != 0) {
+		text += "id: " + std::to_string(id) + "\n";
+		_lastId = id;
+	}
+	if (event != nullptr) {
+		text += std::string("event: ") + event + "\n";
+	}
+	text += std::string("data: ") + message + "\n\n";
+	_events.push_back(text);
+}
+
+bool AsyncEventSourceClient::connected() const {
+	return true;
+}
+
+uint32_t AsyncEventSourceClient::lastId() const {
+	return _lastId;
+}
+
+const std::vector<std::string> &AsyncEventSourceClient::hostEvents() const {
+	return _events;
+}
+
+AsyncEventSource::AsyncEventSource(const String &url) : _url(url) {}
+
+AsyncEventSource::~AsyncEventSource() {
+	close();
+}
+
+void AsyncEventSource::onConnect(ArEventHandlerFunction callback) {
+	_connect = callback;
+}
+
+void AsyncEventSource::close() {
+	for (size_t i = 0; i < _clients.size(); i++) {
+		delete _clients[i];
+	}
+	_clients.clear();
+}
+
+void AsyncEventSource::send(const char *message, const char *event, uint32_t id, uint32_t reconnect) {
+	for (size_t i = 0; i < _clients.size(); i++) {
+		_clients[i]->send(message, event, id, reconnect);
+	}
+}
+
+size_t AsyncEventSource::count() const {
+	return _clients.size();
+}
+
+AsyncEventSourceClient *AsyncEventSource::hostConnect() {
+	AsyncEventSourceClient *client = new AsyncEventSourceClient();
+	_clients.push_back(client);
+	if (_connect) {
+		_connect(client);
+	}
+	return client;
+}
+
+//*************************************************************
+// WebSocket
+//*************************************************************
+
+AsyncWebSocketClient::AsyncWebSocketClient(AsyncWebSocket *server, uint32_t id) : _server(server), _id(id), _client(0x0100007F) {}
+
+uint32_t AsyncWebSocketClient::id() {
+	return _id;
+}
+
+AwsClientStatus AsyncWebSocketClient::status() {
+	return _status;
+}
+
+AsyncClient *AsyncWebSocketClient::client() {
+	return &_client;
+}
+
+bool AsyncWebSocketClient::canSend() {
+	return _status == WS_CONNECTED;
+}
+
+void AsyncWebSocketClient::text(const char *message, size_t length) {
+	if (_status == WS_CONNECTED) {
+		_frames.push_back(std::string(message, length));
+	}
+}
+
+void AsyncWebSocketClient::text(const char *message) {
+	text(message, strlen(message));
+}
+
+void AsyncWebSocketClient::text(const String &message) {
+	text(message.c_str(), message.length());
+}
+
+void AsyncWebSocketClient::binary(const uint8_t *message, size_t length) {
+	text((const char*)message, length);
+}
+
+void AsyncWebSocketClient::close(uint16_t code, const char *message) {
+	_server->hostDisconnect(this);
+}
+
+const std::vector<std::string> &AsyncWebSocketClient::hostFrames() const {
+	return _frames;
+}
+
+AsyncWebSocket::AsyncWebSocket(const String &url) : _url(url) {}
+
+AsyncWebSocket::~AsyncWebSocket() {
+	for (size_t i = 0; i < _clients.size(); i++) {
+		delete _clients[i];
+	}
+}
+
+void AsyncWebSocket::onEvent(AwsEventHandler handler) {
+	_handler = handler;
+}
+
+size_t AsyncWebSocket::count() const {
+	size_t connected = 0;
+	for (size_t i = 0; i < _clients.size(); i++) {
+		connected += (_clients[i]->_status == WS_CONNECTED) ? 1 : 0;
+	}
+	return connected;
+}
+
+AsyncWebSocketClient *AsyncWebSocket::client(uint32_t id) {
+	for (size_t i = 0; i < _clients.size(); i++) {
+		if (_clients[i]->_id == id && _clients[i]->_status == WS_CONNECTED) {
+			return _clients[i];
+		}
+	}
+	return nullptr;
+}
+
+void AsyncWebSocket::cleanupClients(uint16_t maxClients) {
+	// Clients are kept after disconnecting, so tests can still read their frames
+}
+
+void AsyncWebSocket::text(uint32_t id, const char *message, size_t length) {
+	AsyncWebSocketClient *found = client(id);
+	if (found != nullptr) {
+		found->text(message, length);
+	}
+}
+
+void AsyncWebSocket::textAll(const char *message, size_t length) {
+	for (size_t i = 0; i < _clients.size(); i++) {
+		_clients[i]->text(message, length);
+	}
+}
+
+AsyncWebSocketClient *AsyncWebSocket::hostConnect() {
+	AsyncWebSocketClient *client = new AsyncWebSocketClient(this, _nextId++);
+	_clients.push_back(client);
+	if (_handler) {
+		_handler(this, client, WS_EVT_CONNECT, nullptr, nullptr, 0);
+	}
+	return client;
+}
+
+void AsyncWebSocket::hostMessage(AsyncWebSocketClient *client, const char *message) {
+	size_t length = strlen(message);
+	AwsFrameInfo info = {WS_TEXT, 0, 1, 1, WS_TEXT, length, {0, 0, 0, 0}, 0};
+	// The real server hands over the payload in its receive buffer, which the handler may write to
+	std::string data(message, length);
+	if (_handler && client->_status == WS_CONNECTED) {
+		_handler(this, client, WS_EVT_DATA, &info, (uint8_t*)&data[0], length);
+	}
+}
+
+void AsyncWebSocket::hostDisconnect(AsyncWebSocketClient *client) {
+	if (client->_status != WS_CONNECTED) {
+		return;
+	}
+	client->_status = WS_DISCONNECTED;
+	if (_handler) {
+		_handler(this, client, WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+	}
+}
\ No newline at end of file
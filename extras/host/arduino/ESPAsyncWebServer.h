@@ -0,0 +1,390 @@
+/*
+ * Host stand-in of ESPAsyncWebServer, for building ESPWebManager
+ * off-device. Requests do not come over TCP: AsyncWebServer::request()
+ * serves one in process, the way the real server would. It picks the
+ * handler, keeps only the interesting headers and renders the response
+ * (template processing included), then runs the disconnect handlers.
+ * AsyncEventSource and AsyncWebSocket clients are connected and fed
+ * with hostConnect() and hostMessage(), and keep what they are sent.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+// Ensure the stand-in is only included once
+#ifndef _HostESPAsyncWebServer_
+#define _HostESPAsyncWebServer_
+
+#include "Arduino.h"
+#include "FS.h"
+#include <string>
+#include <vector>
+
+typedef enum {
+	HTTP_GET = 0b00000001,
+	HTTP_POST = 0b00000010,
+	HTTP_DELETE = 0b00000100,
+	HTTP_PUT = 0b00001000,
+	HTTP_PATCH = 0b00010000,
+	HTTP_HEAD = 0b00100000,
+	HTTP_OPTIONS = 0b01000000,
+	HTTP_ANY = 0b01111111
+} WebRequestMethod;
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServer;
+class AsyncWebServerRequest;
+class AsyncWebServerResponse;
+class AsyncResponseStream;
+class AsyncCallbackWebHandler;
+
+typedef std::function<void(void)> ArDisconnectHandler;
+typedef std::function<String(const String &)> AwsTemplateProcessor;
+typedef std::function<size_t(uint8_t *, size_t, size_t)> AwsResponseFiller;
+typedef std::function<void(AsyncWebServerRequest *request)> ArRequestHandlerFunction;
+typedef std::function<bool(AsyncWebServerRequest *request)> ArRequestFilterFunction;
+
+// Host only: decode %xx escapes and '+' of a URL part, as ESPAsyncWebServer
+String hostUrlDecode(const char *text, size_t length);
+// Host only: replace %NAME% placeholders with the processor result and %% with %, as ESPAsyncWebServer
+std::string hostProcessTemplate(const std::string &content, const AwsTemplateProcessor &processor);
+
+// Connection of a request
+class AsyncClient {
+	public:
+		AsyncClient(uint32_t address);
+		IPAddress remoteIP();
+		uint16_t remotePort();
+
+	private:
+		uint32_t _address;
+};
+
+// Query parameter
+class AsyncWebParameter {
+	public:
+		AsyncWebParameter(const String &name, const String &value);
+		const String &name() const;
+		const String &value() const;
+		size_t size() const;
+		bool isPost() const;
+		bool isFile() const;
+
+	private:
+		String _name;
+		String _value;
+};
+
+// Request or response header
+class AsyncWebHeader {
+	public:
+		AsyncWebHeader(const String &name, const String &value);
+		const String &name() const;
+		const String &value() const;
+
+	private:
+		String _name;
+		String _value;
+};
+
+// Response, rendered in full by the host server
+class AsyncWebServerResponse {
+	public:
+		AsyncWebServerResponse(int code, const String &contentType);
+		virtual ~AsyncWebServerResponse();
+		virtual void setCode(int code);
+		virtual void setContentLength(size_t length);
+		virtual void setContentType(const String &type);
+		virtual void addHeader(const String &name, const String &value);
+
+		// Host only: status code
+		int code() const;
+		// Host only: content type
+		const String &contentType() const;
+		// Host only: headers added to the response
+		const std::vector<AsyncWebHeader> &headers() const;
+		// Host only: false if the response has nothing to send, as a file that could not be opened
+		virtual bool sourceValid() const;
+		// Host only: the body, with templates processed
+		virtual std::string body() = 0;
+
+	protected:
+		int _code;
+		String _contentType;
+		std::vector<AsyncWebHeader> _headers;
+};
+
+// Response streamed from Print calls
+class AsyncResponseStream : public AsyncWebServerResponse, public Print {
+	public:
+		AsyncResponseStream(const String &contentType, size_t bufferSize);
+		size_t write(const uint8_t *data, size_t length);
+		size_t write(uint8_t data);
+		using Print::write;
+		std::string body();
+
+	private:
+		std::string _content;
+};
+
+// Base of request handlers
+class AsyncWebHandler {
+	public:
+		virtual ~AsyncWebHandler() {}
+		AsyncWebHandler &setFilter(ArRequestFilterFunction filter);
+		bool filter(AsyncWebServerRequest *request);
+		virtual bool canHandle(AsyncWebServerRequest *request) {
+			return false;
+		}
+		virtual void handleRequest(AsyncWebServerRequest *request) {}
+		virtual void handleUpload(AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t length, bool final) {}
+		virtual void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t length, size_t index, size_t total) {}
+		virtual bool isRequestHandlerTrivial() {
+			return true;
+		}
+
+	protected:
+		ArRequestFilterFunction _filter;
+};
+
+// Handler of server.on(), matching paths as ESPAsyncWebServer does
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+	public:
+		AsyncCallbackWebHandler(const String &uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest);
+		bool canHandle(AsyncWebServerRequest *request) override;
+		void handleRequest(AsyncWebServerRequest *request) override;
+
+	private:
+		String _uri;
+		WebRequestMethodComposite _method;
+		ArRequestHandlerFunction _onRequest;
+};
+
+// A request, parsed from the method, URL and headers given to AsyncWebServer::request()
+class AsyncWebServerRequest {
+	friend class AsyncWebServer;
+
+	public:
+		File _tempFile;
+		void *_tempObject = nullptr;
+
+		AsyncWebServerRequest(AsyncWebServer *server, WebRequestMethodComposite method, const char *url, uint32_t address);
+		~AsyncWebServerRequest();
+
+		AsyncClient *client();
+		uint8_t version() const;
+		WebRequestMethodComposite method() const;
+		const String &url() const;
+		const String &host() const;
+		const String &contentType() const;
+		size_t contentLength() const;
+		const char *methodToString() const;
+
+		void onDisconnect(ArDisconnectHandler handler);
+
+		void send(AsyncWebServerResponse *response);
+		void send(int code, const String &contentType = String(), const String &content = String());
+		void send(FS &fs, const String &path, const String &contentType = String(), bool download = false, AwsTemplateProcessor callback = nullptr);
+		void send(File content, const String &path, const String &contentType = String(), bool download = false, AwsTemplateProcessor callback = nullptr);
+		void send(const String &contentType, size_t length, AwsResponseFiller callback, AwsTemplateProcessor templateCallback = nullptr);
+		void sendChunked(const String &contentType, AwsResponseFiller callback, AwsTemplateProcessor templateCallback = nullptr);
+		void send_P(int code, const String &contentType, const uint8_t *content, size_t length, AwsTemplateProcessor callback = nullptr);
+
+		AsyncWebServerResponse *beginResponse(int code, const String &contentType = String(), const String &content = String());
+		AsyncWebServerResponse *beginResponse(FS &fs, const String &path, const String &contentType = String(), bool download = false, AwsTemplateProcessor callback = nullptr);
+		AsyncWebServerResponse *beginResponse(File content, const String &path, const String &contentType = String(), bool download = false, AwsTemplateProcessor callback = nullptr);
+		AsyncWebServerResponse *beginResponse(const String &contentType, size_t length, AwsResponseFiller callback, AwsTemplateProcessor templateCallback = nullptr);
+		AsyncWebServerResponse *beginChunkedResponse(const String &contentType, AwsResponseFiller callback, AwsTemplateProcessor templateCallback = nullptr);
+		AsyncResponseStream *beginResponseStream(const String &contentType, size_t bufferSize = 1460);
+		AsyncWebServerResponse *beginResponse_P(int code, const String &contentType, const uint8_t *content, size_t length, AwsTemplateProcessor callback = nullptr);
+		AsyncWebServerResponse *beginResponse_P(int code, const String &contentType, PGM_P content, AwsTemplateProcessor callback = nullptr);
+
+		size_t headers() const;
+		bool hasHeader(const String &name) const;
+		bool hasHeader(const char *name) const;
+		AsyncWebHeader *getHeader(const String &name) const;
+		AsyncWebHeader *getHeader(const char *name) const;
+		size_t params() const;
+		bool hasParam(const String &name, bool post = false, bool file = false) const;
+		AsyncWebParameter *getParam(const String &name, bool post = false, bool file = false) const;
+		AsyncWebParameter *getParam(size_t index) const;
+		void addInterestingHeader(const String &name);
+
+	private:
+		AsyncWebServer *_server;
+		AsyncClient _client;
+		WebRequestMethodComposite _method;
+		String _url;
+		String _host;
+		std::vector<AsyncWebParameter*> _params;
+		std::vector<AsyncWebHeader*> _headers;
+		std::vector<String> _interestingHeaders;
+		std::vector<ArDisconnectHandler> _disconnectHandlers;
+		AsyncWebHandler *_handler = nullptr;
+		AsyncWebServerResponse *_response = nullptr;
+
+		// Add a header, if a handler asked for it
+		void addHeader(const String &name, const String &value);
+};
+
+// Reply of a request served in process
+struct hostReply {
+	int code; // Status code, 0 if the handler sent nothing
+	String contentType; // Content type
+	std::vector<AsyncWebHeader> headers; // Headers added by the handler
+	std::string body; // Body, with templates processed
+	// Value of header name, nullptr if not sent
+	const char *header(const char *name) const;
+};
+
+// Web server, serving requests given to request()
+class AsyncWebServer {
+	friend class AsyncWebServerRequest;
+
+	public:
+		AsyncWebServer(uint16_t port);
+		~AsyncWebServer();
+		void begin();
+		void end();
+		AsyncWebHandler &addHandler(AsyncWebHandler *handler);
+		bool removeHandler(AsyncWebHandler *handler);
+		AsyncCallbackWebHandler &on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest);
+		void onNotFound(ArRequestHandlerFunction onRequest);
+
+		// Host only: serve a request in process. Headers are given as name, value pairs
+		hostReply request(WebRequestMethodComposite method, const char *url, const std::vector<AsyncWebHeader> &headers = std::vector<AsyncWebHeader>(), uint32_t address = 0x0100007F);
+		// Host only: the started server on port, nullptr if none
+		static AsyncWebServer *hostServer(uint16_t port);
+		// Host only: the handler added at index, nullptr if none
+		AsyncWebHandler *hostHandler(size_t index) const;
+
+	private:
+		uint16_t _port;
+		std::vector<AsyncWebHandler*> _handlers;
+		ArRequestHandlerFunction _notFound;
+};
+
+// Event source client, keeping the events sent to it
+class AsyncEventSourceClient {
+	public:
+		void send(const char *message, const char *event = NULL, uint32_t id = 0, uint32_t reconnect = 0);
+		bool connected() const;
+		uint32_t lastId() const;
+		// Host only: the events sent, in the event stream format
+		const std::vector<std::string> &hostEvents() const;
+
+	private:
+		std::vector<std::string> _events;
+		uint32_t _lastId = 0;
+};
+
+typedef std::function<void(AsyncEventSourceClient *client)> ArEventHandlerFunction;
+
+// Server-Sent Events source
+class AsyncEventSource : public AsyncWebHandler {
+	public:
+		AsyncEventSource(const String &url);
+		~AsyncEventSource();
+		void onConnect(ArEventHandlerFunction callback);
+		void close();
+		void send(const char *message, const char *event = NULL, uint32_t id = 0, uint32_t reconnect = 0);
+		size_t count() const;
+		// Host only: connect a client
+		AsyncEventSourceClient *hostConnect();
+
+	private:
+		String _url;
+		ArEventHandlerFunction _connect;
+		std::vector<AsyncEventSourceClient*> _clients;
+};
+
+typedef enum {
+	WS_DISCONNECTED,
+	WS_CONNECTED,
+	WS_DISCONNECTING
+} AwsClientStatus;
+
+typedef enum {
+	WS_CONTINUATION,
+	WS_TEXT,
+	WS_BINARY,
+	WS_DISCONNECT = 0x08,
+	WS_PING,
+	WS_PONG
+} AwsFrameType;
+
+typedef enum {
+	WS_EVT_CONNECT,
+	WS_EVT_DISCONNECT,
+	WS_EVT_PONG,
+	WS_EVT_ERROR,
+	WS_EVT_DATA
+} AwsEventType;
+
+typedef struct {
+	uint8_t message_opcode;
+	uint32_t num;
+	uint8_t final;
+	uint8_t masked;
+	uint8_t opcode;
+	uint64_t len;
+	uint8_t mask[4];
+	uint64_t index;
+} AwsFrameInfo;
+
+class AsyncWebSocket;
+
+// WebSocket client, keeping the frames sent to it
+class AsyncWebSocketClient {
+	friend class AsyncWebSocket;
+
+	public:
+		AsyncWebSocketClient(AsyncWebSocket *server, uint32_t id);
+		uint32_t id();
+		AwsClientStatus status();
+		AsyncClient *client();
+		bool canSend();
+		void text(const char *message, size_t length);
+		void text(const char *message);
+		void text(const String &message);
+		void binary(const uint8_t *message, size_t length);
+		void close(uint16_t code = 0, const char *message = NULL);
+		// Host only: the frames sent
+		const std::vector<std::string> &hostFrames() const;
+
+	private:
+		AsyncWebSocket *_server;
+		uint32_t _id;
+		AwsClientStatus _status = WS_CONNECTED;
+		AsyncClient _client;
+		std::vector<std::string> _frames;
+};
+
+typedef std::function<void(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t length)> AwsEventHandler;
+
+// WebSocket endpoint
+class AsyncWebSocket : public AsyncWebHandler {
+	friend class AsyncWebSocketClient;
+
+	public:
+		AsyncWebSocket(const String &url);
+		~AsyncWebSocket();
+		void onEvent(AwsEventHandler handler);
+		size_t count() const;
+		AsyncWebSocketClient *client(uint32_t id);
+		void cleanupClients(uint16_t maxClients = 8);
+		void text(uint32_t id, const char *message, size_t length);
+		void textAll(const char *message, size_t length);
+		// Host only: connect a client
+		AsyncWebSocketClient *hostConnect();
+		// Host only: a text frame from client
+		void hostMessage(AsyncWebSocketClient *client, const char *message);
+		// Host only: the client disconnects
+		void hostDisconnect(AsyncWebSocketClient *client);
+
+	private:
+		String _url;
+		AwsEventHandler _handler;
+		std::vector<AsyncWebSocketClient*> _clients;
+		uint32_t _nextId = 1;
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,22 @@
+/*
+ * Host stand-in of the Arduino-ESP32 MDNS responder, for building
+ * ESPWebManager off-device. It starts without announcing anything.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+// Ensure the stand-in is only included once
+#ifndef _HostESPmDNS_
+#define _HostESPmDNS_
+
+#include "Arduino.h"
+
+// MDNS responder, without a network
+class MDNSResponder {
+	public:
+		bool begin(const char *hostName);
+		void end();
+		bool addService(const char *service, const char *protocol, uint16_t port);
+};
+extern MDNSResponder MDNS;
+#endif
\ No newline at end of file
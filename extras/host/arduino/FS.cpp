@@ -0,0 +1,137 @@
+/*
+ * Host stand-in of the Arduino-ESP32 FS interface, for building
+ * ESPWebManager off-device. See FS.h.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "FS.h"
+
+using namespace fs;
+
+//*************************************************************
+// File
+//*************************************************************
+
+File::File(FileImplPtr impl) : _impl(impl) {}
+
+size_t File::write(uint8_t c) {
+	return write(&c, 1);
+}
+
+size_t File::write(const uint8_t *buffer, size_t size) {
+	return _impl ? _impl->write(buffer, size) : 0;
+}
+
+int File::available() {
+	return _impl ? (int)(_impl->size() - _impl->position()) : 0;
+}
+
+int File::read() {
+	uint8_t c;
+	return (read(&c, 1) == 1) ? c : -1;
+}
+
+int File::peek() {
+	if (!_impl) {
+		return -1;
+	}
+	size_t position = _impl->position();
+	int c = read();
+	_impl->seek(position, SeekSet);
+	return c;
+}
+
+size_t File::read(uint8_t *buffer, size_t size) {
+	return _impl ? _impl->read(buffer, size) : 0;
+}
+
+void File::flush() {
+	if (_impl) {
+		_impl->flush();
+	}
+}
+
+bool File::seek(uint32_t position, SeekMode mode) {
+	return _impl && _impl->seek(position, mode);
+}
+
+size_t File::position() const {
+	return _impl ? _impl->position() : 0;
+}
+
+size_t File::size() const {
+	return _impl ? _impl->size() : 0;
+}
+
+void File::close() {
+	if (_impl) {
+		_impl->close();
+		_impl = nullptr;
+	}
+}
+
+File::operator bool() const {
+	return _impl && *_impl;
+}
+
+const char *File::name() const {
+	return _impl ? _impl->name() : nullptr;
+}
+
+bool File::isDirectory() {
+	return _impl && _impl->isDirectory();
+}
+
+File File::openNextFile(const char *mode) {
+	return _impl ? File(_impl->openNextFile(mode)) : File();
+}
+
+//*************************************************************
+// FS
+//*************************************************************
+
+FS::FS(FSImplPtr impl) : _impl(impl) {}
+
+File FS::open(const char *path, const char *mode, const bool create) {
+	if (!_impl || path == nullptr || path[0] != '/') {
+		return File();
+	}
+	return File(_impl->open(path, mode, create));
+}
+
+File FS::open(const String &path, const char *mode, const bool create) {
+	return open(path.c_str(), mode, create);
+}
+
+bool FS::exists(const char *path) {
+	return _impl && path != nullptr && _impl->exists(path);
+}
+
+bool FS::exists(const String &path) {
+	return exists(path.c_str());
+}
+
+bool FS::remove(const char *path) {
+	return _impl && path != nullptr && _impl->remove(path);
+}
+
+bool FS::remove(const String &path) {
+	return remove(path.c_str());
+}
+
+bool FS::rename(const char *pathFrom, const char *pathTo) {
+	return _impl && pathFrom != nullptr && pathTo != nullptr && _impl->rename(pathFrom, pathTo);
+}
+
+bool FS::rename(const String &pathFrom, const String &pathTo) {
+	return rename(pathFrom.c_str(), pathTo.c_str());
+}
+
+bool FS::mkdir(const char *path) {
+	return _impl && _impl->mkdir(path);
+}
+
+bool FS::rmdir(const char *path) {
+	return _impl && _impl->rmdir(path);
+}
\ No newline at end of file
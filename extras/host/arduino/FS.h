@@ -0,0 +1,117 @@
+/*
+ * Host stand-in of the Arduino-ESP32 FS interface, for building
+ * ESPWebManager off-device. As in the core, fs::FS and fs::File are
+ * handles to an FSImpl and a FileImpl, so a filesystem is added by
+ * implementing those two (see PosixFS.h, and the memory flash of
+ * the tests).
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+// Ensure the stand-in is only included once
+#ifndef _HostFS_
+#define _HostFS_
+
+#include "Arduino.h"
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode {
+	SeekSet = 0,
+	SeekCur = 1,
+	SeekEnd = 2
+};
+
+class FileImpl;
+class FSImpl;
+typedef std::shared_ptr<FileImpl> FileImplPtr;
+typedef std::shared_ptr<FSImpl> FSImplPtr;
+
+// An open file of a filesystem implementation
+class FileImpl {
+	public:
+		virtual ~FileImpl() {}
+		virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+		virtual size_t read(uint8_t *buffer, size_t size) = 0;
+		virtual void flush() = 0;
+		virtual bool seek(uint32_t position, SeekMode mode) = 0;
+		virtual size_t position() const = 0;
+		virtual size_t size() const = 0;
+		virtual void close() = 0;
+		virtual const char *name() const = 0;
+		virtual bool isDirectory() = 0;
+		virtual FileImplPtr openNextFile(const char *mode) = 0;
+		virtual operator bool() = 0;
+};
+
+// A filesystem implementation
+class FSImpl {
+	public:
+		virtual ~FSImpl() {}
+		virtual FileImplPtr open(const char *path, const char *mode, const bool create) = 0;
+		virtual bool exists(const char *path) = 0;
+		virtual bool rename(const char *pathFrom, const char *pathTo) = 0;
+		virtual bool remove(const char *path) = 0;
+		virtual bool mkdir(const char *path) = 0;
+		virtual bool rmdir(const char *path) = 0;
+};
+
+// Handle of an open file, false when the file could not be opened
+class File : public Stream {
+	public:
+		File(FileImplPtr impl = FileImplPtr());
+
+		size_t write(uint8_t c);
+		size_t write(const uint8_t *buffer, size_t size);
+		using Print::write;
+		int available();
+		int read();
+		int peek();
+		size_t read(uint8_t *buffer, size_t size);
+		void flush();
+		bool seek(uint32_t position, SeekMode mode = SeekSet);
+		size_t position() const;
+		size_t size() const;
+		void close();
+		operator bool() const;
+		const char *name() const;
+		bool isDirectory();
+		File openNextFile(const char *mode = FILE_READ);
+
+	private:
+		FileImplPtr _impl;
+};
+
+// Handle of a filesystem
+class FS {
+	public:
+		FS(FSImplPtr impl);
+
+		File open(const char *path, const char *mode = FILE_READ, const bool create = false);
+		File open(const String &path, const char *mode = FILE_READ, const bool create = false);
+		bool exists(const char *path);
+		bool exists(const String &path);
+		bool remove(const char *path);
+		bool remove(const String &path);
+		bool rename(const char *pathFrom, const char *pathTo);
+		bool rename(const String &pathFrom, const String &pathTo);
+		bool mkdir(const char *path);
+		bool rmdir(const char *path);
+
+	protected:
+		FSImplPtr _impl;
+};
+
+}
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+#endif
\ No newline at end of file
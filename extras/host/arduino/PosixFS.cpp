@@ -0,0 +1,132 @@
+/*
+ * Host filesystem for building ESPWebManager off-device. See PosixFS.h.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "PosixFS.h"
+#include <sys/stat.h>
+#include <unistd.h>
+
+// An open file of the host filesystem
+class PosixFileImpl : public fs::FileImpl {
+	public:
+		PosixFileImpl(FILE *file, const char *name) : _file(file), _name(name) {}
+		~PosixFileImpl() {
+			close();
+		}
+
+		size_t write(const uint8_t *buffer, size_t size) {
+			return (_file != nullptr) ? fwrite(buffer, 1, size, _file) : 0;
+		}
+		size_t read(uint8_t *buffer, size_t size) {
+			return (_file != nullptr) ? fread(buffer, 1, size, _file) : 0;
+		}
+		void flush() {
+			if (_file != nullptr) {
+				fflush(_file);
+			}
+		}
+		bool seek(uint32_t position, fs::SeekMode mode) {
+			return _file != nullptr && fseek(_file, position, (mode == fs::SeekSet) ? SEEK_SET : (mode == fs::SeekCur) ? SEEK_CUR : SEEK_END) == 0;
+		}
+		size_t position() const {
+			return (_file != nullptr) ? ftell(_file) : 0;
+		}
+		size_t size() const {
+			struct stat status;
+			if (_file == nullptr) {
+				return 0;
+			}
+			fflush(_file);
+			return (fstat(fileno(_file), &status) == 0) ? status.st_size : 0;
+		}
+		void close() {
+			if (_file != nullptr) {
+				fclose(_file);
+				_file = nullptr;
+			}
+		}
+		const char *name() const {
+			return _name.c_str();
+		}
+		bool isDirectory() {
+			return false;
+		}
+		fs::FileImplPtr openNextFile(const char *mode) {
+			return fs::FileImplPtr();
+		}
+		operator bool() {
+			return _file != nullptr;
+		}
+
+	private:
+		FILE *_file;
+		std::string _name;
+};
+
+//*************************************************************
+// Public functions
+//*************************************************************
+
+// Set the root directory
+void PosixFSImpl::setRoot(const char *root) {
+	_root = root;
+	while (_root.size() > 1 && _root.back() == '/') {
+		_root.pop_back();
+	}
+}
+
+// Root directory
+const char *PosixFSImpl::root() {
+	return _root.c_str();
+}
+
+fs::FileImplPtr PosixFSImpl::open(const char *path, const char *mode, const bool create) {
+	std::string file = hostPath(path);
+	struct stat status;
+	// Only regular files, SPIFFS has no directories
+	if (stat(file.c_str(), &status) == 0 && !S_ISREG(status.st_mode)) {
+		return fs::FileImplPtr();
+	}
+	FILE *handle = fopen(file.c_str(), mode);
+	if (handle == nullptr) {
+		return fs::FileImplPtr();
+	}
+	return fs::FileImplPtr(new PosixFileImpl(handle, path));
+}
+
+bool PosixFSImpl::exists(const char *path) {
+	struct stat status;
+	return stat(hostPath(path).c_str(), &status) == 0;
+}
+
+bool PosixFSImpl::rename(const char *pathFrom, const char *pathTo) {
+	return ::rename(hostPath(pathFrom).c_str(), hostPath(pathTo).c_str()) == 0;
+}
+
+bool PosixFSImpl::remove(const char *path) {
+	return ::unlink(hostPath(path).c_str()) == 0;
+}
+
+bool PosixFSImpl::mkdir(const char *path) {
+	return ::mkdir(hostPath(path).c_str(), 0755) == 0;
+}
+
+bool PosixFSImpl::rmdir(const char *path) {
+	return ::rmdir(hostPath(path).c_str()) == 0;
+}
+
+//*************************************************************
+// Private functions
+//*************************************************************
+
+// Host path of a filesystem path
+std::string PosixFSImpl::hostPath(const char *path) {
+	// Paths climbing out of the root are kept inside it
+	std::string file = path;
+	for (size_t found = file.find("/.."); found != std::string::npos; found = file.find("/..")) {
+		file.erase(found, 3);
+	}
+	return _root + file;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+/*
+ * Host filesystem for building ESPWebManager off-device: a directory
+ * of the host filesystem served through the Arduino FS interface, so
+ * it can stand in for SPIFFS. "/index.html" is the file index.html in
+ * the root directory.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+// Ensure the stand-in is only included once
+#ifndef _HostPosixFS_
+#define _HostPosixFS_
+
+#include "FS.h"
+#include <string>
+
+// Filesystem implementation over a directory
+class PosixFSImpl : public fs::FSImpl {
+	public:
+		// Set the root directory, without a trailing slash
+		void setRoot(const char *root);
+		// Root directory
+		const char *root();
+
+		fs::FileImplPtr open(const char *path, const char *mode, const bool create);
+		bool exists(const char *path);
+		bool rename(const char *pathFrom, const char *pathTo);
+		bool remove(const char *path);
+		bool mkdir(const char *path);
+		bool rmdir(const char *path);
+
+	private:
+		// Root directory
+		std::string _root = ".";
+
+		// Host path of a filesystem path
+		std::string hostPath(const char *path);
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+/*
+ * Host stand-in of SPIFFS, for building ESPWebManager off-device. See
+ * SPIFFS.h.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "SPIFFS.h"
+#include <sys/stat.h>
+
+using namespace fs;
+
+SPIFFSFS SPIFFS;
+
+SPIFFSFS::SPIFFSFS() : FS(FSImplPtr(new PosixFSImpl())) {
+	_posix = (PosixFSImpl*)_impl.get();
+	const char *root = getenv("WEBMANAGER_SPIFFS");
+	if (root != nullptr) {
+		_posix->setRoot(root);
+	}
+}
+
+bool SPIFFSFS::begin(bool formatOnFail, const char *basePath, uint8_t maxOpenFiles, const char *partitionLabel) {
+	struct stat status;
+	if (stat(_posix->root(), &status) == 0) {
+		return S_ISDIR(status.st_mode);
+	}
+	return formatOnFail && ::mkdir(_posix->root(), 0755) == 0;
+}
+
+void SPIFFSFS::end() {}
+
+size_t SPIFFSFS::totalBytes() {
+	return 1441792;
+}
+
+size_t SPIFFSFS::usedBytes() {
+	return 0;
+}
+
+void SPIFFSFS::setRoot(const char *root) {
+	_posix->setRoot(root);
+}
+
+const char *SPIFFSFS::root() {
+	return _posix->root();
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+/*
+ * Host stand-in of SPIFFS, for building ESPWebManager off-device. The
+ * files are those of a host directory (see PosixFS.h): the directory
+ * set with setRoot(), else $WEBMANAGER_SPIFFS, else the current
+ * directory.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+// Ensure the stand-in is only included once
+#ifndef _HostSPIFFS_
+#define _HostSPIFFS_
+
+#include "FS.h"
+#include "PosixFS.h"
+
+namespace fs {
+
+// SPIFFS over a host directory
+class SPIFFSFS : public FS {
+	public:
+		SPIFFSFS();
+		// Mount, creating the root directory if formatOnFail is set
+		bool begin(bool formatOnFail = false, const char *basePath = "/spiffs", uint8_t maxOpenFiles = 10, const char *partitionLabel = NULL);
+		void end();
+		size_t totalBytes();
+		size_t usedBytes();
+
+		// Host only: serve the files of directory root
+		void setRoot(const char *root);
+		// Host only: the root directory
+		const char *root();
+
+	private:
+		// The directory filesystem
+		PosixFSImpl *_posix;
+};
+
+}
+
+extern fs::SPIFFSFS SPIFFS;
+#endif
\ No newline at end of file
@@ -0,0 +1,64 @@
+/*
+ * Host stand-ins of the Arduino-ESP32 WiFi library and MDNS responder,
+ * for building ESPWebManager off-device. See WiFi.h and ESPmDNS.h.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "WiFi.h"
+#include "ESPmDNS.h"
+
+WiFiClass WiFi;
+MDNSResponder MDNS;
+
+//*************************************************************
+// WiFi
+//*************************************************************
+
+bool WiFiClass::mode(wifi_mode_t mode) {
+	return true;
+}
+
+wl_status_t WiFiClass::begin(const char *ssid, const char *password) {
+	return WL_DISCONNECTED;
+}
+
+wl_status_t WiFiClass::status() {
+	return WL_DISCONNECTED;
+}
+
+IPAddress WiFiClass::localIP() {
+	return IPAddress();
+}
+
+bool WiFiClass::reconnect() {
+	return false;
+}
+
+bool WiFiClass::disconnect(bool wifiOff) {
+	return true;
+}
+
+bool WiFiClass::setAutoReconnect(bool autoReconnect) {
+	return true;
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventCb callback, arduino_event_id_t event) {
+	return 0;
+}
+
+void WiFiClass::removeEvent(wifi_event_id_t id) {}
+
+//*************************************************************
+// MDNS
+//*************************************************************
+
+bool MDNSResponder::begin(const char *hostName) {
+	return true;
+}
+
+void MDNSResponder::end() {}
+
+bool MDNSResponder::addService(const char *service, const char *protocol, uint16_t port) {
+	return true;
+}
\ No newline at end of file
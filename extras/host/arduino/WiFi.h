@@ -0,0 +1,59 @@
+/*
+ * Host stand-in of the Arduino-ESP32 WiFi library, for building
+ * ESPWebManager off-device. The station never connects, tests of the
+ * startup drive a WebNetwork of their own instead.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+// Ensure the stand-in is only included once
+#ifndef _HostWiFi_
+#define _HostWiFi_
+
+#include "Arduino.h"
+
+typedef enum {
+	WIFI_OFF,
+	WIFI_STA,
+	WIFI_AP,
+	WIFI_AP_STA
+} wifi_mode_t;
+
+typedef enum {
+	WL_IDLE_STATUS,
+	WL_NO_SSID_AVAIL,
+	WL_SCAN_COMPLETED,
+	WL_CONNECTED,
+	WL_CONNECT_FAILED,
+	WL_CONNECTION_LOST,
+	WL_DISCONNECTED
+} wl_status_t;
+
+typedef enum {
+	ARDUINO_EVENT_WIFI_STA_START,
+	ARDUINO_EVENT_WIFI_STA_CONNECTED,
+	ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+	ARDUINO_EVENT_WIFI_STA_GOT_IP,
+	ARDUINO_EVENT_WIFI_STA_LOST_IP,
+	ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+
+typedef arduino_event_id_t WiFiEvent_t;
+typedef void (*WiFiEventCb)(arduino_event_id_t event);
+typedef size_t wifi_event_id_t;
+
+// WiFi station, without a radio
+class WiFiClass {
+	public:
+		bool mode(wifi_mode_t mode);
+		wl_status_t begin(const char *ssid, const char *password = NULL);
+		wl_status_t status();
+		IPAddress localIP();
+		bool reconnect();
+		bool disconnect(bool wifiOff = false);
+		bool setAutoReconnect(bool autoReconnect);
+		wifi_event_id_t onEvent(WiFiEventCb callback, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+		void removeEvent(wifi_event_id_t id);
+};
+extern WiFiClass WiFi;
+#endif
\ No newline at end of file
@@ -0,0 +1,13 @@
+/*
+ * Host stand-in of the Arduino-ESP32 WiFiClient header, for building
+ * ESPWebManager off-device. The library includes it without using it.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+// Ensure the stand-in is only included once
+#ifndef _HostWiFiClient_
+#define _HostWiFiClient_
+
+#include "WiFi.h"
+#endif
\ No newline at end of file
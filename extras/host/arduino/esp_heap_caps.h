@@ -0,0 +1,24 @@
+/*
+ * Host stand-in of the ESP-IDF heap capabilities functions, for
+ * building ESPWebManager off-device. Allocations come from the C heap,
+ * and the free sizes are those set with hostSetFreeHeap().
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+// Ensure the stand-in is only included once
+#ifndef _HostHeapCaps_
+#define _HostHeapCaps_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+void *heap_caps_malloc(size_t size, uint32_t caps);
+#endif
\ No newline at end of file
@@ -0,0 +1,73 @@
+/*
+ * Allocation counter of the host build. See hostAllocations.h.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "hostAllocations.h"
+#include <stddef.h>
+
+// Counting state of the thread, so other threads (as the host server) do not add to it
+static thread_local bool counting = false;
+static thread_local hostAllocationCount count = {0, 0};
+
+#ifdef __GLIBC__
+// The glibc allocator, called by the replacements below
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+extern "C" void __libc_free(void *pointer);
+
+// Count an allocation of size bytes
+static inline void countAllocation(size_t size) {
+	if (counting) {
+		count.allocations++;
+		count.bytes += size;
+	}
+}
+
+// Counted malloc()
+extern "C" void *malloc(size_t size) {
+	countAllocation(size);
+	return __libc_malloc(size);
+}
+
+// Counted calloc()
+extern "C" void *calloc(size_t elements, size_t size) {
+	countAllocation(elements * size);
+	return __libc_calloc(elements, size);
+}
+
+// Counted realloc()
+extern "C" void *realloc(void *pointer, size_t size) {
+	countAllocation(size);
+	return __libc_realloc(pointer, size);
+}
+
+// free(), not counted
+extern "C" void free(void *pointer) {
+	__libc_free(pointer);
+}
+
+// Check if allocations can be counted
+bool hostAllocationsCounted() {
+	return true;
+}
+#else
+// Check if allocations can be counted
+bool hostAllocationsCounted() {
+	return false;
+}
+#endif
+
+// Reset the counter and start counting
+void hostStartCounting() {
+	count = {0, 0};
+	counting = true;
+}
+
+// Stop counting
+hostAllocationCount hostStopCounting() {
+	counting = false;
+	return count;
+}
\ No newline at end of file
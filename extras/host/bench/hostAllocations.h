@@ -0,0 +1,27 @@
+/*
+ * Allocation counter of the host build. It replaces malloc(), calloc(),
+ * realloc() and free() of the executables it is linked into (operator
+ * new included), and counts allocations while counting is on.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+// Ensure the counter is only included once
+#ifndef _HostAllocations_
+#define _HostAllocations_
+
+#include <stdint.h>
+
+// Allocations counted since the counter was reset
+struct hostAllocationCount {
+	uint64_t allocations; // Calls of malloc(), calloc() and realloc() that allocated
+	uint64_t bytes; // Bytes asked for
+};
+
+// Check if allocations can be counted (glibc only)
+bool hostAllocationsCounted();
+// Reset the counter and start counting, on the calling thread only
+void hostStartCounting();
+// Stop counting, returns the count since hostStartCounting()
+hostAllocationCount hostStopCounting();
+#endif
\ No newline at end of file
@@ -0,0 +1,566 @@
+/*
+ * Benchmarks of ESPWebManager on the host build. Measures API get and set
+ * throughput and keyword lookup against the number of keywords (with the
+ * linear scan it replaced), the cost of HTML placeholders, file cache
+ * throughput against concurrent clients, route dispatch against the
+ * number of routes (with a linear scan of the routes) and through the
+ * stand-in server, and heap allocations per request. Host figures are not
+ * device figures, compare them between runs.
+ *
+ *   webbench [--quick]
+ *
+ * --quick runs each measurement briefly, as the ctest smoke run does.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "ESPWebManager.h"
+#include "HostTransport.h"
+#include "hostAllocations.h"
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+// Time each measurement runs for, in ms
+static uint32_t budget = 250;
+// Keeps results alive, so measured work is not optimised away
+static volatile size_t sink = 0;
+
+// Run operation for the time budget, returns ns per run
+template <typename Operation>
+static double measure(Operation operation) {
+	typedef std::chrono::steady_clock clock;
+	for (uint16_t i = 0; i < 64; i++) {
+		operation();
+	}
+	uint64_t runs = 0;
+	clock::time_point start = clock::now();
+	clock::time_point end = start + std::chrono::milliseconds(budget);
+	clock::time_point now;
+	do {
+		for (uint16_t i = 0; i < 64; i++) {
+			operation();
+		}
+		runs += 64;
+		now = clock::now();
+	} while (now < end);
+	return std::chrono::duration<double, std::nano>(now - start).count() / runs;
+}
+
+// Allocations of one run of operation, or -1 if they can not be counted
+template <typename Operation>
+static long allocationsOf(Operation operation) {
+	if (!hostAllocationsCounted()) {
+		return -1;
+	}
+	// The first run may allocate once, as buffers growing to size
+	operation();
+	hostStartCounting();
+	operation();
+	return (long)hostStopCounting().allocations;
+}
+
+// Keywords bound to numbers, named Key000 (placeholder KEY000) and on
+struct benchKeywords {
+	std::vector<std::string> names;
+	std::vector<std::string> placeholders;
+	std::vector<uint32_t> values;
+	std::vector<apiKeyword> keywords;
+
+	benchKeywords(uint16_t count) : names(count), placeholders(count), values(count), keywords(count) {
+		char name[16];
+		for (uint16_t i = 0; i < count; i++) {
+			snprintf(name, sizeof(name), "Key%03u", i);
+			names[i] = name;
+			snprintf(name, sizeof(name), "KEY%03u", i);
+			placeholders[i] = name;
+			values[i] = i;
+			keywords[i] = bindKeyword(names[i].c_str(), placeholders[i].c_str(), values[i]);
+		}
+	}
+};
+
+//*************************************************************
+// API throughput
+//*************************************************************
+
+// Get and set throughput of the allocation free handler and of apiHandler(), against the number of keywords
+static void benchAPI() {
+	printf("\nAPI requests, ns per request\n");
+	printf("%9s %14s %14s %14s %14s\n", "keywords", "get", "set", "apiHandler get", "apiHandler set");
+	static const uint16_t counts[] = {8, 32, 128, 250};
+	for (uint16_t count : counts) {
+		benchKeywords bound(count);
+		WebAPI api(bound.keywords.data(), count);
+		std::vector<std::string> gets(count);
+		std::vector<std::string> sets(count);
+		std::vector<String> getURLs(count);
+		std::vector<String> setURLs(count);
+		for (uint16_t i = 0; i < count; i++) {
+			gets[i] = bound.names[i];
+			sets[i] = bound.names[i] + "=" + std::to_string(i * 7);
+			getURLs[i] = gets[i].c_str();
+			setURLs[i] = sets[i].c_str();
+		}
+		char buffer[valueTextSize];
+		uint16_t next = 0;
+		double get = measure([&]() {
+			sink += api.requestHandler(gets[next].c_str(), buffer).length;
+			next = (next + 1) % count;
+		});
+		double set = measure([&]() {
+			sink += api.requestHandler(sets[next].c_str(), buffer).responseCode;
+			next = (next + 1) % count;
+		});
+		double stringGet = measure([&]() {
+			sink += api.apiHandler(&getURLs[next]).responseText.length();
+			next = (next + 1) % count;
+		});
+		double stringSet = measure([&]() {
+			sink += api.apiHandler(&setURLs[next]).responseCode;
+			next = (next + 1) % count;
+		});
+		printf("%9u %14.1f %14.1f %14.1f %14.1f\n", count, get, set, stringGet, stringSet);
+	}
+}
+
+//*************************************************************
+// Keyword lookup
+//*************************************************************
+
+// Placeholder lookup as WebAPI did before its lookup index, a linear scan for the first keyword contained in name
+static int16_t linearIndex(const std::vector<apiKeyword> &keywords, const String &name) {
+	for (uint16_t i = 0; i < keywords.size(); i++) {
+		if (name.indexOf(keywords[i].htmlPlaceholder) >= 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// Placeholder lookup through the sorted index against the linear scan, against the number of keywords
+static void benchLookup() {
+	printf("\nKeyword lookup, ns per placeholder\n");
+	printf("%9s %14s %14s %9s\n", "keywords", "index", "linear scan", "speedup");
+	static const uint16_t counts[] = {8, 32, 128, 250};
+	for (uint16_t count : counts) {
+		benchKeywords bound(count);
+		WebAPI api(bound.keywords.data(), count);
+		std::vector<String> names(count);
+		for (uint16_t i = 0; i < count; i++) {
+			names[i] = bound.placeholders[i].c_str();
+		}
+		uint16_t next = 0;
+		double indexed = measure([&]() {
+			sink += api.placeholderIndex(names[next].c_str(), names[next].length());
+			next = (next + 1) % count;
+		});
+		double linear = measure([&]() {
+			sink += linearIndex(bound.keywords, names[next]);
+			next = (next + 1) % count;
+		});
+		printf("%9u %14.1f %14.1f %8.1fx\n", count, indexed, linear, linear / indexed);
+	}
+}
+
+//*************************************************************
+// HTML placeholders
+//*************************************************************
+
+// Write a page with placeholders keyword placeholders between paragraphs, returns its file name
+static std::string writePage(const char *directory, uint16_t placeholders, const benchKeywords &bound) {
+	std::string fileName = "/page" + std::to_string(placeholders) + ".html";
+	std::string page = "<html><body>\n";
+	for (uint16_t i = 0; i < placeholders; i++) {
+		page += "<p>Value " + std::to_string(i) + " is %" + bound.placeholders[i % bound.placeholders.size()] + "%</p>\n";
+	}
+	page += "</body></html>\n";
+	FILE *file = fopen((std::string(directory) + fileName).c_str(), "w");
+	fwrite(page.data(), 1, page.size(), file);
+	fclose(file);
+	return fileName;
+}
+
+// Cost of htmlProcessor(), and of rendering pages with a parsed template and a template stream
+static void benchTemplates(const char *directory) {
+	benchKeywords bound(32);
+	WebAPI api(bound.keywords.data(), 32);
+	placeholderProcessor processor = [](const String &var) {
+		return String();
+	};
+
+	std::vector<String> names(32);
+	for (uint16_t i = 0; i < 32; i++) {
+		names[i] = bound.placeholders[i].c_str();
+	}
+	uint16_t next = 0;
+	double lookup = measure([&]() {
+		sink += api.htmlProcessor(names[next]).length();
+		next = (next + 1) % 32;
+	});
+	printf("\nHTML placeholders, 32 keywords\n");
+	printf("htmlProcessor(): %.1f ns per placeholder\n", lookup);
+
+	printf("%13s %16s %16s %16s\n", "placeholders", "template page", "stream page", "per placeholder");
+	static const uint16_t counts[] = {1, 16, 128};
+	uint8_t buffer[1460];
+	for (uint16_t count : counts) {
+		std::string fileName = writePage(directory, count, bound);
+		WebTemplate htmlTemplate;
+		htmlTemplate.load(SPIFFS, fileName.c_str(), &api);
+		double parsed = measure([&]() {
+			templateState state;
+			size_t length;
+			while ((length = htmlTemplate.render(&state, buffer, sizeof(buffer), processor)) > 0) {
+				sink += length;
+			}
+		});
+		double streamed = measure([&]() {
+			WebTemplateStream stream(SPIFFS, fileName.c_str(), &api);
+			size_t length;
+			while ((length = stream.render(buffer, sizeof(buffer), processor)) > 0) {
+				sink += length;
+			}
+		});
+		printf("%13u %13.1f ns %13.1f ns %13.1f ns\n", count, parsed, streamed, parsed / count);
+	}
+}
+
+//*************************************************************
+// File cache under concurrent clients
+//*************************************************************
+
+// An asset served from SPIFFS, and from the file cache
+static const webContentEntry cacheContent[1] = {
+	{"/asset.js", "/asset.js", RESfile, HTTP_GET}
+};
+static bool cacheFlag = false;
+static apiKeyword cacheKeywordList[1] = {
+	bindKeyword("Flag", "FLAG", cacheFlag)
+};
+static HostTransport uncachedTransport(1);
+static HostTransport cachedTransport(1);
+static webManager uncachedManager(cacheContent, 1, cacheKeywordList, 1);
+static webManager cachedManager(cacheContent, 1, cacheKeywordList, 1);
+
+// A client requesting path on one kept alive connection while running is set, counting the replies
+static void benchClient(uint16_t port, const char *path, std::atomic<bool> *running, std::atomic<uint64_t> *replies) {
+	int client = socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(port);
+	if (connect(client, (struct sockaddr*)&address, sizeof(address)) != 0) {
+		close(client);
+		return;
+	}
+	std::string request = std::string("GET ") + path + " HTTP/1.1\r\nHost: bench\r\n\r\n";
+	std::string data;
+	char buffer[16384];
+	while (running->load()) {
+		if (send(client, request.data(), request.size(), 0) != (ssize_t)request.size()) {
+			break;
+		}
+		// Read the head and a body of Content-Length bytes
+		size_t headEnd = std::string::npos;
+		size_t length = 0;
+		while (headEnd == std::string::npos || data.size() < headEnd + 4 + length) {
+			ssize_t read = recv(client, buffer, sizeof(buffer), 0);
+			if (read <= 0) {
+				close(client);
+				return;
+			}
+			data.append(buffer, read);
+			if (headEnd == std::string::npos && (headEnd = data.find("\r\n\r\n")) != std::string::npos) {
+				size_t at = data.find("Content-Length: ");
+				length = at < headEnd ? strtoul(data.c_str() + at + 16, nullptr, 10) : 0;
+			}
+		}
+		data.erase(0, headEnd + 4 + length);
+		(*replies)++;
+	}
+	close(client);
+}
+
+// Requests per second of clients concurrent clients of manager, served from poll() on this thread
+static double clientThroughput(webManager &manager, HostTransport &transport, uint16_t clients) {
+	std::atomic<bool> running(true);
+	std::atomic<uint64_t> replies(0);
+	std::vector<std::thread> threads;
+	for (uint16_t i = 0; i < clients; i++) {
+		threads.emplace_back(benchClient, transport.port(), "/asset.js", &running, &replies);
+	}
+	// Let all clients connect
+	typedef std::chrono::steady_clock clock;
+	clock::time_point start = clock::now();
+	while (transport.connections() < clients && clock::now() < start + std::chrono::seconds(1)) {
+		manager.poll();
+	}
+	uint64_t first = replies.load();
+	start = clock::now();
+	clock::time_point end = start + std::chrono::milliseconds(budget * 4);
+	while (clock::now() < end) {
+		manager.poll();
+	}
+	double rate = (replies.load() - first) / std::chrono::duration<double>(clock::now() - start).count();
+	// Serve the last requests, so the clients see running cleared
+	running = false;
+	while (transport.connections() > 0) {
+		manager.poll();
+	}
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+	return rate;
+}
+
+// Throughput of a 16 KB asset with and without the file cache, against the number of concurrent clients
+static void benchCache(const char *directory) {
+	std::string asset(16384, 'x');
+	FILE *file = fopen((std::string(directory) + "/asset.js").c_str(), "w");
+	fwrite(asset.data(), 1, asset.size(), file);
+	fclose(file);
+	uncachedManager.setTransport(&uncachedTransport);
+	uncachedManager.begin(0);
+	cachedManager.setTransport(&cachedTransport);
+	cachedManager.setFileCache(65536);
+	cachedManager.begin(0);
+
+	printf("\nFile cache, 16 KB asset over the host transport, requests per second\n");
+	printf("%9s %14s %14s %9s\n", "clients", "uncached", "cached", "speedup");
+	static const uint16_t counts[] = {1, 4, 16};
+	for (uint16_t clients : counts) {
+		double uncached = clientThroughput(uncachedManager, uncachedTransport, clients);
+		double cached = clientThroughput(cachedManager, cachedTransport, clients);
+		printf("%9u %14.0f %14.0f %8.1fx\n", clients, uncached, cached, cached / uncached);
+	}
+	WebFileCache *cache = cachedManager.fileCache();
+	printf("cache hits %u, misses %u, evictions %u\n", cache->hits(), cache->misses(), cache->evictions());
+}
+
+//*************************************************************
+// Route dispatch against the number of routes
+//*************************************************************
+
+// A route as one handler per web content entry sees it
+struct linearRoute {
+	std::string path;
+	bool prefix;
+	uint8_t methods;
+};
+
+// Route lookup as one handler per entry did before the route index, the first handler whose pattern matches wins.
+// Exact routes also match the path followed by a slash, as in ESPAsyncWebServer
+static int16_t linearMatch(const std::vector<linearRoute> &routes, const char *path, size_t length, uint8_t method) {
+	for (uint16_t i = 0; i < routes.size(); i++) {
+		const linearRoute &route = routes[i];
+		if ((route.methods & method) == 0 || length < route.path.size() || memcmp(path, route.path.data(), route.path.size()) != 0) {
+			continue;
+		}
+		if (route.prefix || length == route.path.size() || path[route.path.size()] == '/') {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// Match cost of the route index against a linear scan of the routes, for sites with more and more assets
+static void benchDispatch() {
+	printf("\nRoute dispatch, ns per path\n");
+	printf("%9s %14s %14s %9s\n", "routes", "WebRoutes", "linear scan", "speedup");
+	static const uint16_t counts[] = {8, 32, 80, 200};
+	for (uint16_t count : counts) {
+		// Assets, then an API and a binary API prefix
+		std::vector<std::string> paths(count);
+		std::vector<linearRoute> linear(count);
+		WebRoutes routes(count);
+		for (uint16_t i = 0; i < count; i++) {
+			char path[24];
+			snprintf(path, sizeof(path), "/assets/file%03u.css", i);
+			paths[i] = path;
+			linear[i] = {path, false, HTTP_GET};
+		}
+		paths[count - 2] = "/api";
+		linear[count - 2] = {"/api/", true, HTTP_GET | HTTP_POST};
+		paths[count - 1] = "/bin";
+		linear[count - 1] = {"/bin/", true, HTTP_GET};
+		for (uint16_t i = 0; i < count - 2; i++) {
+			routes.add(paths[i].c_str(), HTTP_GET, i);
+		}
+		routes.add("/api/*", HTTP_GET | HTTP_POST, count - 2);
+		routes.add("/bin/*", HTTP_GET, count - 1);
+		routes.build();
+
+		// Every asset, an API request and a path no route matches
+		std::vector<std::string> requests(paths.begin(), paths.end() - 2);
+		requests.push_back("/api/LED1State");
+		requests.push_back("/missing.css");
+		uint16_t next = 0;
+		double indexed = measure([&]() {
+			sink += routes.match(requests[next].c_str(), requests[next].size(), HTTP_GET);
+			next = (next + 1) % requests.size();
+		});
+		double scanned = measure([&]() {
+			sink += linearMatch(linear, requests[next].c_str(), requests[next].size(), HTTP_GET);
+			next = (next + 1) % requests.size();
+		});
+		printf("%9u %14.1f %14.1f %8.1fx\n", count, indexed, scanned, scanned / indexed);
+	}
+}
+
+//*************************************************************
+// Dispatch and allocations through the web manager
+//*************************************************************
+
+#define benchEntries 5
+// Web content of the LEDs_from_Web example, with its data directory, and a binary API
+static const webContentEntry benchContent[benchEntries] = {
+	{"/", "/index.html", HTMLfile, HTTP_GET},
+	{"/myScript.js", "/myScript.js", RESfile, HTTP_GET},
+	{"/styles.css", "/styles.css", RESfile, HTTP_GET},
+	{"/api", "", API, HTTP_GET | HTTP_POST | HTTP_PUT},
+	{"/bin", "", BinaryAPI, HTTP_GET}
+};
+
+static bool benchLED1 = false;
+static float benchTemperature = 21.5;
+static apiKeyword benchKeywordList[2] = {
+	bindKeyword("LED1State", "LED1STATE", benchLED1),
+	bindKeyword("Temperature", "TEMPERATURE", benchTemperature)
+};
+static webManager benchManager(benchContent, benchEntries, benchKeywordList, 2);
+
+// HTML processor of the manager
+static String benchProcessor(const String &var) {
+	return benchManager.APIbasedProcessor(var);
+}
+
+// A request through the stand-in server
+struct benchRequest {
+	const char *name;
+	WebRequestMethodComposite method;
+	const char *url;
+};
+
+// Dispatch cost and allocations of requests of each content type through the web manager
+static void benchManagerRequests() {
+	SPIFFS.setRoot(hostExampleData);
+	webManager::startSPIFFS();
+	benchManager.setHTMLprocessor(benchProcessor);
+	benchManager.setTemplateCache(true);
+	benchManager.setFileCache(32768);
+	benchManager.enableBufferPool();
+	benchManager.begin(8080);
+	AsyncWebServer *server = AsyncWebServer::hostServer(8080);
+	// A route of the stand-in server alone, to tell its own cost and allocations apart
+	server->on("/baseline", HTTP_GET, [](AsyncWebServerRequest *request) {
+		request->send(200, "text/plain", "1");
+	});
+
+	// Route lookup alone
+	uint8_t next = 0;
+	static const char *paths[] = {"/", "/styles.css", "/api/LED1State", "/missing"};
+	WebRoutes routes(benchEntries);
+	routes.add("/", HTTP_GET, 0);
+	routes.add("/myScript.js", HTTP_GET, 1);
+	routes.add("/styles.css", HTTP_GET, 2);
+	routes.add("/api/*", HTTP_GET | HTTP_POST | HTTP_PUT, 3);
+	routes.add("/bin/*", HTTP_GET, 4);
+	routes.build();
+	double lookup = measure([&]() {
+		sink += routes.match(paths[next], strlen(paths[next]), HTTP_GET);
+		next = (next + 1) % 4;
+	});
+	printf("\nRoute dispatch, %u routes\n", benchEntries);
+	printf("WebRoutes::match(): %.1f ns per path\n", lookup);
+
+	static const benchRequest requests[] = {
+		{"baseline (stand-in only)", HTTP_GET, "/baseline"},
+		{"HTML page", HTTP_GET, "/"},
+		{"resource", HTTP_GET, "/styles.css"},
+		{"API get", HTTP_GET, "/api/LED1State"},
+		{"API set", HTTP_GET, "/api/LED1State=1"},
+		{"API batch", HTTP_GET, "/api/batch?LED1State&Temperature"},
+		{"binary API", HTTP_GET, "/bin/0001"},
+		{"not found", HTTP_GET, "/missing"}
+	};
+	printf("\nRequests through the stand-in server\n");
+	printf("%-26s %6s %12s %12s\n", "request", "code", "ns", "allocations");
+	for (const benchRequest &request : requests) {
+		int code = server->request(request.method, request.url).code;
+		double time = measure([&]() {
+			sink += server->request(request.method, request.url).body.size();
+		});
+		long allocations = allocationsOf([&]() {
+			sink += server->request(request.method, request.url).body.size();
+		});
+		printf("%-26s %6d %12.1f %12ld\n", request.name, code, time, allocations);
+	}
+}
+
+//*************************************************************
+// Allocations of the API handlers
+//*************************************************************
+
+// Allocations of a get and a set, by the handlers alone
+static void benchAllocations() {
+	benchKeywords bound(32);
+	String text;
+	bound.keywords.push_back(bindKeyword("Text", "TEXT", text));
+	WebAPI api(bound.keywords.data(), 33);
+	char buffer[valueTextSize];
+	String getURL = "Key017";
+	String setURL = "Key017=5";
+	printf("\nAllocations per API request\n");
+	if (!hostAllocationsCounted()) {
+		printf("not counted, the C library is not glibc\n");
+		return;
+	}
+	printf("requestHandler() get: %ld\n", allocationsOf([&]() {
+		sink += api.requestHandler("Key017", buffer).length;
+	}));
+	printf("requestHandler() set: %ld\n", allocationsOf([&]() {
+		sink += api.requestHandler("Key017=5", buffer).responseCode;
+	}));
+	printf("requestHandler() String set: %ld\n", allocationsOf([&]() {
+		sink += api.requestHandler("Text=hello", buffer).responseCode;
+	}));
+	printf("apiHandler() get: %ld\n", allocationsOf([&]() {
+		sink += api.apiHandler(&getURL).responseCode;
+	}));
+	printf("apiHandler() set: %ld\n", allocationsOf([&]() {
+		sink += api.apiHandler(&setURL).responseCode;
+	}));
+}
+
+int main(int argc, char **argv) {
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--quick") == 0) {
+			budget = 10;
+		} else {
+			fprintf(stderr, "usage: %s [--quick]\n", argv[0]);
+			return 2;
+		}
+	}
+	// Pages are written to a scratch directory, served as SPIFFS
+	char directory[] = "/tmp/webbenchXXXXXX";
+	if (mkdtemp(directory) == nullptr) {
+		perror("mkdtemp");
+		return 1;
+	}
+	SPIFFS.setRoot(directory);
+	benchAPI();
+	benchLookup();
+	benchTemplates(directory);
+	benchCache(directory);
+	benchAllocations();
+	benchDispatch();
+	benchManagerRequests();
+	std::string clean = std::string("rm -rf ") + directory;
+	return system(clean.c_str()) == 0 ? 0 : 1;
+}
\ No newline at end of file
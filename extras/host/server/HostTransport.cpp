@@ -0,0 +1,656 @@
+/*
+ * Single-threaded HTTP/1.1 server over epoll. See HostTransport.h.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "HostTransport.h"
+#include "ESPAsyncWebServer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Longest request head (request line and headers), longer ones are refused
+#define hostMaxHead 8192
+// Size of each part of a file or chunked reply, as one TCP segment
+#define hostPartSize 1460
+// Size of each part of a buffer reply
+#define hostBufferPart 16384
+// Events handled per epoll_wait()
+#define hostEvents 64
+
+// Reason phrase of a status code
+static const char *reasonOf(uint16_t code) {
+	switch (code) {
+		case 200: return "OK";
+		case 204: return "No Content";
+		case 304: return "Not Modified";
+		case 400: return "Bad Request";
+		case 404: return "Not Found";
+		case 405: return "Method Not Allowed";
+		case 413: return "Payload Too Large";
+		case 431: return "Request Header Fields Too Large";
+		case 500: return "Internal Server Error";
+		case 501: return "Not Implemented";
+		case 503: return "Service Unavailable";
+	}
+	return "Unknown";
+}
+
+// Method bit of a method name, 0 if unknown
+static uint8_t methodOf(const std::string &name) {
+	static const std::pair<const char*, uint8_t> methods[] = {
+		{"GET", HTTP_GET}, {"POST", HTTP_POST}, {"DELETE", HTTP_DELETE}, {"PUT", HTTP_PUT},
+		{"PATCH", HTTP_PATCH}, {"HEAD", HTTP_HEAD}, {"OPTIONS", HTTP_OPTIONS}
+	};
+	for (const std::pair<const char*, uint8_t> &method : methods) {
+		if (name == method.first) {
+			return method.second;
+		}
+	}
+	return 0;
+}
+
+// Print into a string, for printed replies
+class hostStringPrint : public Print {
+	public:
+		std::string text;
+		size_t write(uint8_t data) {
+			text += (char)data;
+			return 1;
+		}
+		size_t write(const uint8_t *data, size_t length) {
+			text.append((const char*)data, length);
+			return length;
+		}
+};
+
+// Body sources of a reply
+typedef enum {
+	hostBodyNone, // Head only
+	hostBodyBuffer, // Caller's buffer, or the processed template
+	hostBodyFile, // Open file, read in parts
+	hostBodyFiller // Filler, called for each part
+} hostBodies;
+
+//*************************************************************
+// Request
+//*************************************************************
+
+// A request read from a connection, and its reply
+class hostRequest : public WebRequest {
+	friend class HostTransport;
+
+	public:
+		// Constructor
+		hostRequest(uint8_t method, uint32_t address, bool http11, bool keepAlive) : _method(method), _address(address), _http11(http11), _keepAlive(keepAlive) {}
+		// Destructor, the request is done
+		~hostRequest() {
+			if (_done) {
+				_done();
+			}
+			if (_freeData) {
+				free((void*)_data);
+			}
+			_file.close();
+		}
+
+		const String &url() override {
+			return _url;
+		}
+		uint8_t method() override {
+			return _method;
+		}
+		uint32_t clientAddress() override {
+			return _address;
+		}
+		const char *header(const char *name) override {
+			for (const std::pair<String, String> &header : _headers) {
+				if (header.first.equalsIgnoreCase(name)) {
+					return header.second.c_str();
+				}
+			}
+			return nullptr;
+		}
+		size_t params() override {
+			return _params.size();
+		}
+		const char *paramName(size_t index) override {
+			return _params[index].first.c_str();
+		}
+		const char *paramValue(size_t index) override {
+			return _params[index].second.c_str();
+		}
+		const char *param(const char *name) override {
+			for (const std::pair<String, String> &param : _params) {
+				if (param.first == name) {
+					return param.second.c_str();
+				}
+			}
+			return nullptr;
+		}
+		void addHeader(const char *name, const char *value) override {
+			_replyHeaders.push_back(std::make_pair(name, value));
+		}
+		void send(uint16_t code, const char *contentType, const char *text, size_t length) override {
+			if (!beginReply(code, contentType, length, false)) {
+				return;
+			}
+			_processed.assign(text != nullptr ? text : "", text != nullptr ? length : 0);
+			_body = hostBodyBuffer;
+			_data = (const uint8_t*)_processed.data();
+			_length = _processed.size();
+		}
+		void sendBuffer(uint16_t code, const char *contentType, const uint8_t *data, size_t length, bool freeData = false, placeholderProcessor processor = nullptr) override {
+			if (processor) {
+				// Processed in one go, the processed length is the content length
+				_processed = hostProcessTemplate(std::string((const char*)data, length), processor);
+				if (freeData) {
+					free((void*)data);
+				}
+				data = (const uint8_t*)_processed.data();
+				length = _processed.size();
+				freeData = false;
+			}
+			if (!beginReply(code, contentType, length, false)) {
+				if (freeData) {
+					free((void*)data);
+				}
+				return;
+			}
+			_body = hostBodyBuffer;
+			_data = data;
+			_length = length;
+			_freeData = freeData;
+		}
+		void sendFile(File file, const char *contentType, placeholderProcessor processor = nullptr) override {
+			if (processor) {
+				std::string content;
+				uint8_t buffer[hostPartSize];
+				size_t read;
+				while ((read = file.read(buffer, sizeof(buffer))) > 0) {
+					content.append((const char*)buffer, read);
+				}
+				file.close();
+				_processed = hostProcessTemplate(content, processor);
+				sendBuffer(200, contentType, (const uint8_t*)_processed.data(), _processed.size());
+				return;
+			}
+			if (!beginReply(200, contentType, file.size(), false)) {
+				file.close();
+				return;
+			}
+			_body = hostBodyFile;
+			_file = file;
+		}
+		void sendChunked(uint16_t code, const char *contentType, webFiller filler) override {
+			if (!beginReply(code, contentType, 0, true)) {
+				return;
+			}
+			_body = hostBodyFiller;
+			_filler = filler;
+		}
+		void sendPrinted(uint16_t code, const char *contentType, webPrinter printer) override {
+			hostStringPrint output;
+			printer(output);
+			send(code, contentType, output.text.data(), output.text.size());
+		}
+		void onDone(webDone done) override {
+			_done = done;
+		}
+
+	private:
+		// Request method
+		uint8_t _method;
+		// Client address
+		uint32_t _address;
+		// The client speaks HTTP/1.1, and takes chunked replies
+		bool _http11;
+		// The connection is kept open after the reply
+		bool _keepAlive;
+		// Decoded path
+		String _url;
+		// Query parameters
+		std::vector<std::pair<String, String>> _params;
+		// Request headers the handler reads
+		std::vector<std::pair<String, String>> _headers;
+		// Reply headers, not copied until the reply is sent
+		std::vector<std::pair<const char*, const char*>> _replyHeaders;
+		// Called when the request is done
+		webDone _done;
+
+		// A reply was sent
+		bool _sent = false;
+		// Status line and headers of the reply
+		std::string _head;
+		// The head was written
+		bool _headWritten = false;
+		// Body source (hostBodies)
+		uint8_t _body = hostBodyNone;
+		// Body of a buffer reply
+		const uint8_t *_data = nullptr;
+		// Length of a buffer reply
+		size_t _length = 0;
+		// Bytes of the buffer written
+		size_t _offset = 0;
+		// The buffer is from malloc(), and freed when done
+		bool _freeData = false;
+		// Copied or processed body
+		std::string _processed;
+		// File of a file reply
+		File _file;
+		// Filler of a chunked reply
+		webFiller _filler;
+		// Bytes filled so far
+		size_t _index = 0;
+		// The filler is done
+		bool _filled = false;
+
+		// Format the status line and headers, false if a reply was sent already
+		bool beginReply(uint16_t code, const char *contentType, size_t length, bool chunked) {
+			if (_sent) {
+				fprintf(stderr, "HostTransport: second reply to %s dropped\n", _url.c_str());
+				return false;
+			}
+			_sent = true;
+			// Without chunked encoding, a reply of unknown length ends when the connection closes
+			if (chunked && !_http11) {
+				_keepAlive = false;
+			}
+			char line[64];
+			snprintf(line, sizeof(line), "HTTP/1.1 %u %s\r\n", code, reasonOf(code));
+			_head = line;
+			if (contentType != nullptr) {
+				_head = _head + "Content-Type: " + contentType + "\r\n";
+			}
+			if (chunked && _http11) {
+				_head += "Transfer-Encoding: chunked\r\n";
+			} else if (!chunked) {
+				_head += "Content-Length: " + std::to_string(length) + "\r\n";
+			}
+			for (const std::pair<const char*, const char*> &header : _replyHeaders) {
+				_head = _head + header.first + ": " + header.second + "\r\n";
+			}
+			_head += _keepAlive ? (_http11 ? "" : "Connection: keep-alive\r\n") : "Connection: close\r\n";
+			_head += "\r\n";
+			return true;
+		}
+
+		// Append the next part of the reply to output, false when the reply is complete
+		bool produce(std::string &output) {
+			if (!_headWritten) {
+				output += _head;
+				_headWritten = true;
+				if (_method == HTTP_HEAD) {
+					_body = hostBodyNone;
+				}
+				return true;
+			}
+			uint8_t buffer[hostPartSize];
+			switch (_body) {
+				case hostBodyBuffer: {
+					if (_offset >= _length) {
+						return false;
+					}
+					size_t part = (_length - _offset < hostBufferPart) ? _length - _offset : hostBufferPart;
+					output.append((const char*)_data + _offset, part);
+					_offset += part;
+					return true;
+				}
+				case hostBodyFile: {
+					size_t read = _file.read(buffer, sizeof(buffer));
+					if (read == 0) {
+						return false;
+					}
+					output.append((const char*)buffer, read);
+					return true;
+				}
+				case hostBodyFiller: {
+					if (_filled) {
+						return false;
+					}
+					size_t filled = _filler(buffer, sizeof(buffer), _index);
+					_index += filled;
+					if (filled == 0) {
+						_filled = true;
+						if (_http11) {
+							output += "0\r\n\r\n";
+						}
+						return true;
+					}
+					if (_http11) {
+						char size[16];
+						snprintf(size, sizeof(size), "%zx\r\n", filled);
+						output += size;
+					}
+					output.append((const char*)buffer, filled);
+					if (_http11) {
+						output += "\r\n";
+					}
+					return true;
+				}
+			}
+			return false;
+		}
+};
+
+//*************************************************************
+// Connection
+//*************************************************************
+
+// An open connection
+class hostConnection {
+	public:
+		// Socket
+		int socket;
+		// Client address
+		uint32_t address;
+		// Bytes read, not yet served
+		std::string input;
+		// Bytes of the reply to write
+		std::string output;
+		// Bytes of output written
+		size_t written = 0;
+		// Request being replied to, nullptr if none
+		hostRequest *request = nullptr;
+		// The socket is watched for room to write
+		bool writable = false;
+};
+
+//*************************************************************
+// Transport
+//*************************************************************
+
+// Constructor
+HostTransport::HostTransport(int timeout) : _timeout(timeout) {}
+
+// Destructor
+HostTransport::~HostTransport() {
+	while (!_connections.empty()) {
+		close(_connections.begin()->second);
+	}
+	if (_listener >= 0) {
+		::close(_listener);
+	}
+	if (_epoll >= 0) {
+		::close(_epoll);
+	}
+}
+
+// Listen on port
+bool HostTransport::begin(uint16_t port, WebRequestHandler *handler) {
+	_handler = handler;
+	_listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (_listener < 0) {
+		perror("HostTransport: socket");
+		return false;
+	}
+	int enable = 1;
+	setsockopt(_listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+	struct sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(port);
+	if (bind(_listener, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(_listener, 128) < 0) {
+		perror("HostTransport: bind");
+		return false;
+	}
+	socklen_t length = sizeof(address);
+	getsockname(_listener, (struct sockaddr*)&address, &length);
+	_port = ntohs(address.sin_port);
+	_epoll = epoll_create1(EPOLL_CLOEXEC);
+	struct epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.fd = _listener;
+	epoll_ctl(_epoll, EPOLL_CTL_ADD, _listener, &event);
+	return true;
+}
+
+// Serve what is ready
+void HostTransport::poll() {
+	if (_epoll < 0) {
+		return;
+	}
+	struct epoll_event events[hostEvents];
+	int ready = epoll_wait(_epoll, events, hostEvents, _timeout);
+	for (int i = 0; i < ready; i++) {
+		if (events[i].data.fd == _listener) {
+			accept();
+			continue;
+		}
+		std::map<int, hostConnection*>::iterator found = _connections.find(events[i].data.fd);
+		if (found == _connections.end()) {
+			continue;
+		}
+		hostConnection *connection = found->second;
+		if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+			close(connection);
+		} else if (events[i].events & EPOLLOUT) {
+			if (transmit(connection)) {
+				serve(connection);
+			}
+		} else if (events[i].events & EPOLLIN) {
+			receive(connection);
+		}
+	}
+}
+
+// Port listened on
+uint16_t HostTransport::port() {
+	return _port;
+}
+
+// Number of open connections
+size_t HostTransport::connections() {
+	return _connections.size();
+}
+
+// Accept waiting connections
+void HostTransport::accept() {
+	for (;;) {
+		struct sockaddr_in address;
+		socklen_t length = sizeof(address);
+		int client = accept4(_listener, (struct sockaddr*)&address, &length, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (client < 0) {
+			return;
+		}
+		int enable = 1;
+		setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+		hostConnection *connection = new hostConnection();
+		connection->socket = client;
+		// Kept in memory order, as IPAddress converts to and from uint32_t
+		connection->address = address.sin_addr.s_addr;
+		_connections[client] = connection;
+		struct epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.fd = client;
+		epoll_ctl(_epoll, EPOLL_CTL_ADD, client, &event);
+	}
+}
+
+// Read from a connection
+void HostTransport::receive(hostConnection *connection) {
+	char buffer[4096];
+	for (;;) {
+		ssize_t read = recv(connection->socket, buffer, sizeof(buffer), 0);
+		if (read > 0) {
+			connection->input.append(buffer, read);
+		} else if (read == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+			// Closed by the client
+			close(connection);
+			return;
+		} else if (errno != EINTR) {
+			break;
+		}
+	}
+	serve(connection);
+}
+
+// Serve the complete requests read, one at a time
+void HostTransport::serve(hostConnection *connection) {
+	while (connection->request == nullptr) {
+		std::string &input = connection->input;
+		size_t headEnd = input.find("\r\n\r\n");
+		if (headEnd == std::string::npos) {
+			if (input.size() > hostMaxHead) {
+				connection->request = new hostRequest(HTTP_GET, connection->address, true, false);
+				connection->request->send(431, "text/plain", "Request header too large", 24);
+				transmit(connection);
+			}
+			return;
+		}
+		// Request line
+		size_t lineEnd = input.find("\r\n");
+		std::string line = input.substr(0, lineEnd);
+		size_t methodEnd = line.find(' ');
+		size_t targetEnd = line.rfind(' ');
+		uint8_t method = (methodEnd != std::string::npos) ? methodOf(line.substr(0, methodEnd)) : 0;
+		bool http11 = targetEnd != std::string::npos && line.compare(targetEnd + 1, std::string::npos, "HTTP/1.1") == 0;
+		std::string target = (methodEnd != std::string::npos && targetEnd > methodEnd) ? line.substr(methodEnd + 1, targetEnd - methodEnd - 1) : std::string();
+		// Headers
+		std::vector<std::pair<String, String>> headers;
+		size_t contentLength = 0;
+		bool keepAlive = http11;
+		bool chunkedBody = false;
+		size_t position = lineEnd + 2;
+		while (position < headEnd) {
+			size_t end = input.find("\r\n", position);
+			size_t colon = input.find(':', position);
+			if (colon != std::string::npos && colon < end) {
+				String name(input.data() + position, colon - position);
+				size_t value = input.find_first_not_of(" \t", colon + 1);
+				if (value == std::string::npos || value > end) {
+					value = end;
+				}
+				String text(input.data() + value, end - value);
+				if (name.equalsIgnoreCase("Content-Length")) {
+					contentLength = strtoul(text.c_str(), nullptr, 10);
+				} else if (name.equalsIgnoreCase("Transfer-Encoding")) {
+					chunkedBody = true;
+				} else if (name.equalsIgnoreCase("Connection")) {
+					if (text.equalsIgnoreCase("close")) {
+						keepAlive = false;
+					} else if (text.equalsIgnoreCase("keep-alive")) {
+						keepAlive = true;
+					}
+				}
+				// Only the headers the handler reads are kept, as the async server does
+				for (const char *const *wanted = _handler->headers(); *wanted != nullptr; wanted++) {
+					if (name.equalsIgnoreCase(*wanted)) {
+						headers.push_back(std::make_pair(name, text));
+					}
+				}
+			}
+			position = end + 2;
+		}
+		// The body is read and dropped, the web manager takes everything from the URL
+		if (input.size() < headEnd + 4 + contentLength) {
+			return;
+		}
+		input.erase(0, headEnd + 4 + contentLength);
+
+		hostRequest *request = new hostRequest(method, connection->address, http11, keepAlive && !chunkedBody);
+		connection->request = request;
+		if (method == 0 || target.empty() || target[0] != '/') {
+			request->_keepAlive = false;
+			request->send(400, "text/plain", "Bad request", 11);
+		} else if (chunkedBody) {
+			request->send(501, "text/plain", "Chunked request bodies are not supported", 40);
+		} else {
+			size_t query = target.find('?');
+			request->_url = hostUrlDecode(target.c_str(), (query != std::string::npos) ? query : target.size());
+			while (query != std::string::npos) {
+				size_t start = query + 1;
+				query = target.find('&', start);
+				size_t end = (query != std::string::npos) ? query : target.size();
+				size_t equals = target.find('=', start);
+				if (end == start) {
+					continue;
+				}
+				if (equals != std::string::npos && equals < end) {
+					request->_params.push_back(std::make_pair(hostUrlDecode(target.c_str() + start, equals - start), hostUrlDecode(target.c_str() + equals + 1, end - equals - 1)));
+				} else {
+					request->_params.push_back(std::make_pair(hostUrlDecode(target.c_str() + start, end - start), String()));
+				}
+			}
+			request->_headers = headers;
+			_handler->handleRequest(request);
+			if (!request->_sent) {
+				fprintf(stderr, "HostTransport: no reply to %s\n", request->_url.c_str());
+				request->send(500, "text/plain", "No reply", 8);
+			}
+		}
+		if (!transmit(connection)) {
+			return;
+		}
+	}
+}
+
+// Write as much of the reply as the socket takes
+bool HostTransport::transmit(hostConnection *connection) {
+	for (;;) {
+		if (connection->written < connection->output.size()) {
+			ssize_t sent = ::send(connection->socket, connection->output.data() + connection->written, connection->output.size() - connection->written, MSG_NOSIGNAL);
+			if (sent < 0) {
+				if (errno == EAGAIN || errno == EWOULDBLOCK) {
+					waitWritable(connection, true);
+					return true;
+				}
+				if (errno == EINTR) {
+					continue;
+				}
+				close(connection);
+				return false;
+			}
+			connection->written += sent;
+			continue;
+		}
+		connection->output.clear();
+		connection->written = 0;
+		hostRequest *request = connection->request;
+		if (request == nullptr) {
+			waitWritable(connection, false);
+			return true;
+		}
+		if (!request->produce(connection->output)) {
+			// The reply is complete, and the request done
+			bool keepAlive = request->_keepAlive;
+			connection->request = nullptr;
+			delete request;
+			if (!keepAlive) {
+				close(connection);
+				return false;
+			}
+			waitWritable(connection, false);
+			return true;
+		}
+	}
+}
+
+// Watch the socket for room to write, or not
+void HostTransport::waitWritable(hostConnection *connection, bool writable) {
+	if (connection->writable == writable) {
+		return;
+	}
+	connection->writable = writable;
+	struct epoll_event event = {};
+	event.events = writable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+	event.data.fd = connection->socket;
+	epoll_ctl(_epoll, EPOLL_CTL_MOD, connection->socket, &event);
+}
+
+// Close a connection
+void HostTransport::close(hostConnection *connection) {
+	// A request cut off is done as well, as when the async server sees the client disconnect
+	delete connection->request;
+	_connections.erase(connection->socket);
+	::close(connection->socket);
+	delete connection;
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+/*
+ * Single-threaded HTTP/1.1 server over epoll, serving the web manager on
+ * Linux through the WebTransport interface. Connections are kept alive,
+ * pipelined requests are served in order, and chunked and file replies
+ * are produced in parts as the socket takes them, as the async server
+ * does on the device. Request bodies are read and dropped.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+// Ensure the server is only included once
+#ifndef _HostTransport_
+#define _HostTransport_
+
+#include "WebTransport.h"
+#include <map>
+
+class hostConnection;
+
+// Transport serving HTTP/1.1 on a TCP port, from poll()
+class HostTransport : public WebTransport {
+	public:
+		// Constructor, poll() waits at most timeout ms for a connection to be ready
+		HostTransport(int timeout = 0);
+		// Destructor, closes all connections
+		~HostTransport();
+
+		// Listen on port (0 for any free port) on all addresses
+		bool begin(uint16_t port, WebRequestHandler *handler) override;
+		// Accept connections, read requests and write replies that are ready
+		void poll() override;
+
+		// Port listened on, 0 before begin()
+		uint16_t port();
+		// Number of open connections
+		size_t connections();
+
+	private:
+		// Time poll() waits, in ms
+		int _timeout;
+		// Listening socket
+		int _listener = -1;
+		// Event queue
+		int _epoll = -1;
+		// Port listened on
+		uint16_t _port = 0;
+		// Handler of the requests
+		WebRequestHandler *_handler = nullptr;
+		// Open connections, by socket
+		std::map<int, hostConnection*> _connections;
+
+		// Accept waiting connections
+		void accept();
+		// Read from a connection, and serve the requests read
+		void receive(hostConnection *connection);
+		// Serve the complete requests read from a connection, one at a time
+		void serve(hostConnection *connection);
+		// Write as much of the reply as the socket takes, returns false if the connection was closed
+		bool transmit(hostConnection *connection);
+		// Wait for the socket to take more of the reply, or not
+		void waitWritable(hostConnection *connection, bool writable);
+		// Close a connection, finishing its request
+		void close(hostConnection *connection);
+};
+#endif
\ No newline at end of file
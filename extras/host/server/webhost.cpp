@@ -0,0 +1,94 @@
+/*
+ * Host server of the LEDs_from_Web example, serving the web manager over
+ * HostTransport with SPIFFS taken from a directory. Used as the target of
+ * extras/webload.py, to load test the library without a device.
+ *
+ *   webhost [--port 8080] [--root examples/LEDs_from_Web/data]
+ *
+ * Port 0 listens on any free port. The port is printed on the first line
+ * of output ("webhost: listening on port 8080"). SIGINT or SIGTERM stops it.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "ESPWebManager.h"
+#include "HostTransport.h"
+#include <signal.h>
+
+// Number of web content entries
+#define hostEntries 6
+// Web content of the LEDs_from_Web example, and a binary API
+static const webContentEntry hostContent[hostEntries] = {
+	{"/", "/index.html", HTMLfile, HTTP_GET},
+	{"/index.html", "/index.html", HTMLfile, HTTP_GET},
+	{"/myScript.js", "/myScript.js", RESfile, HTTP_GET},
+	{"/styles.css", "/styles.css", RESfile, HTTP_GET},
+	{"/api", "", API, HTTP_GET | HTTP_POST | HTTP_PUT},
+	{"/bin", "", BinaryAPI, HTTP_GET}
+};
+
+// Number of API keywords
+#define hostKeywords 3
+// Variables accessable from the API
+static bool bLED1State = false;
+static bool bLED2State = false;
+static float temperature = 21.5;
+static apiKeyword hostKeywordList[hostKeywords] = {
+	bindKeyword("LED1State", "LED1STATE", bLED1State),
+	bindKeyword("LED2State", "LED2STATE", bLED2State),
+	bindKeyword("Temperature", "TEMPERATURE", temperature)
+};
+
+static webManager hostManager(hostContent, hostEntries, hostKeywordList, hostKeywords);
+
+// Cleared by SIGINT and SIGTERM
+static volatile sig_atomic_t running = 1;
+
+// Stop serving
+static void stop(int signal) {
+	running = 0;
+}
+
+// HTML processor of the manager
+static String processor(const String &var) {
+	return hostManager.APIbasedProcessor(var);
+}
+
+int main(int argc, char **argv) {
+	uint16_t port = 8080;
+	const char *root = hostExampleData;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+			port = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+			root = argv[++i];
+		} else {
+			fprintf(stderr, "usage: %s [--port 8080] [--root directory]\n", argv[0]);
+			return 2;
+		}
+	}
+	signal(SIGINT, stop);
+	signal(SIGTERM, stop);
+
+	// poll() waits for connections, so the loop does not spin
+	HostTransport transport(10);
+	SPIFFS.setRoot(root);
+	webManager::startSPIFFS();
+	hostManager.setTransport(&transport);
+	hostManager.setHTMLprocessor(processor);
+	hostManager.setTemplateCache(true);
+	hostManager.setFileCache(32768);
+	hostManager.enableBufferPool();
+	hostManager.enableMetrics();
+	hostManager.enableLogRoute();
+	hostManager.begin(port);
+	if (transport.port() == 0) {
+		return 1;
+	}
+	printf("webhost: listening on port %u\n", transport.port());
+	fflush(stdout);
+	while (running) {
+		hostManager.poll();
+	}
+	return 0;
+}
\ No newline at end of file
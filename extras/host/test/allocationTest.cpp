@@ -0,0 +1,138 @@
+/*
+ * Test of the allocation free API path: gets and sets of each value type
+ * through WebAPI::requestHandler(), deferred sets, and API requests through
+ * the web manager's dispatcher with the buffer pool, all without a single
+ * heap allocation. Allocations are counted on glibc only, elsewhere the
+ * test is skipped.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "ESPWebManager.h"
+#include "hostAllocations.h"
+#include "hostTest.h"
+#include "testRequest.h"
+
+// Allocations of one run of operation, after a first run growing buffers to size
+template <typename Operation>
+static uint64_t allocationsOf(Operation operation) {
+	operation();
+	hostStartCounting();
+	operation();
+	return hostStopCounting().allocations;
+}
+
+static bool testFlag = false;
+static uint32_t testCount = 0;
+static int64_t testOffset = 0;
+static float testLevel = 0;
+static double testRatio = 0;
+static String testStatus = "Idle";
+static char testName[16] = "host";
+static apiKeyword testKeywords[7] = {
+	bindKeyword("Flag", "FLAG", testFlag),
+	bindKeyword("Count", "COUNT", testCount),
+	bindKeyword("Offset", "OFFSET", testOffset),
+	bindKeyword("Level", "LEVEL", testLevel),
+	bindKeyword("Ratio", "RATIO", testRatio),
+	bindKeyword("Status", "STATUS", testStatus),
+	bindKeyword("Name", "NAME", testName)
+};
+
+//*************************************************************
+// Requests through the dispatcher
+//*************************************************************
+
+static const webContentEntry testContent[1] = {
+	{"/api", "", API, HTTP_GET}
+};
+static webManager testManager(testContent, 1, testKeywords, 7);
+static testTransport transport;
+
+// Allocations of a request through the dispatcher, its reply is checked against code and body
+static uint64_t requestAllocations(const String &path, uint16_t code, const char *body) {
+	uint16_t replyCode = 0;
+	char replyBody[64] = "";
+	uint64_t allocations = allocationsOf([&]() {
+		testRequest request(path);
+		transport.handler->handleRequest(&request);
+		replyCode = request.code;
+		memcpy(replyBody, request.body, sizeof(replyBody));
+	});
+	hostCheck(replyCode == code);
+	hostCheck(strcmp(replyBody, body) == 0);
+	return allocations;
+}
+
+int main() {
+	if (!hostAllocationsCounted()) {
+		printf("skipped, allocations are only counted on glibc\n");
+		return 0;
+	}
+	WebAPI api(testKeywords, 7);
+	char buffer[valueTextSize];
+
+	// Gets of each value type
+	static const char *gets[] = {"Flag", "Count", "Offset", "Level", "Ratio", "Status", "Name"};
+	for (const char *get : gets) {
+		uint64_t allocations = allocationsOf([&]() {
+			hostCheck(api.requestHandler(get, buffer).responseCode == 200);
+		});
+		if (allocations != 0) {
+			fprintf(stderr, "get %s: %llu allocations\n", get, (unsigned long long)allocations);
+		}
+		hostCheck(allocations == 0);
+	}
+
+	// Sets of each value type, Strings to values that fit their buffer
+	static const char *sets[] = {"Flag=1", "Count=42", "Offset=-7", "Level=2.5", "Ratio=0.125", "Status=Busy", "Name=device"};
+	for (const char *set : sets) {
+		uint64_t allocations = allocationsOf([&]() {
+			hostCheck(api.requestHandler(set, buffer).responseCode == 200);
+		});
+		if (allocations != 0) {
+			fprintf(stderr, "set %s: %llu allocations\n", set, (unsigned long long)allocations);
+		}
+		hostCheck(allocations == 0);
+	}
+	hostCheck(testFlag && testCount == 42 && testOffset == -7 && testLevel == 2.5f && testRatio == 0.125);
+	hostCheck(testStatus == "Busy" && strcmp(testName, "device") == 0);
+
+	// Unknown keywords and bad values are replied to without allocating as well
+	hostCheck(allocationsOf([&]() {
+		hostCheck(api.requestHandler("Missing", buffer).responseCode == 404);
+		hostCheck(api.requestHandler("Count=many", buffer).responseCode != 200);
+	}) == 0);
+
+	// Deferred sets are queued without allocating, and applied by poll(). Queue slots keep their text buffer, so once
+	// every slot (one more than the queue size) was used a set does not allocate
+	WebAPI deferred(testKeywords, 7);
+	deferred.enableDeferredSets();
+	hostCheck(allocationsOf([&]() {
+		for (uint8_t i = 0; i <= defaultSetQueueSize; i++) {
+			hostCheck(deferred.requestHandler("Count=7", buffer).responseCode == 200);
+			deferred.poll();
+		}
+	}) == 0);
+	hostCheck(testCount == 7);
+
+	// API requests through the dispatcher, replied to from the buffer pool
+	testManager.setTransport(&transport);
+	testManager.enableBufferPool();
+	testManager.begin(80);
+	hostCheck(transport.handler != nullptr);
+	if (transport.handler != nullptr) {
+		String getPath = "/api/Count";
+		String setPath = "/api/Count=9";
+		String stringPath = "/api/Status";
+		hostCheck(requestAllocations(setPath, 200, "Ok") == 0);
+		hostCheck(requestAllocations(getPath, 200, "9") == 0);
+		hostCheck(requestAllocations(stringPath, 200, "Busy") == 0);
+		// Pool blocks went back when the requests were done
+		WebPool *pool = testManager.bufferPool();
+		for (uint8_t i = 0; i < pool->classes(); i++) {
+			hostCheck(pool->sizeClass(i)->used == 0);
+		}
+	}
+	return hostTestResult();
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+/*
+ * Test of batch requests: the callback of a keyword set several times in
+ * one batch runs once, when sets are applied at once and when they are
+ * deferred to poll(). Deferred batches reach poll() whole, and a batch
+ * larger than the set queue keeps the sets that fit.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "ESPWebManager.h"
+#include "hostTest.h"
+
+static uint32_t batchLevel = 0;
+static uint32_t batchMode = 0;
+static uint16_t levelCalls = 0;
+static uint16_t modeCalls = 0;
+
+// Count the callbacks
+static void levelChanged() {
+	levelCalls++;
+}
+static void modeChanged() {
+	modeCalls++;
+}
+
+static apiKeyword batchKeywords[2] = {
+	bindKeyword("Level", "LEVEL", batchLevel, levelChanged),
+	bindKeyword("Mode", "MODE", batchMode, modeChanged)
+};
+
+// Reset values and callback counts
+static void reset() {
+	batchLevel = 0;
+	batchMode = 0;
+	levelCalls = 0;
+	modeCalls = 0;
+}
+
+// Level set three times and Mode once, with a get in between
+static const apiBatchItem batchItems[5] = {
+	{"Level", "1"},
+	{"Level", "2"},
+	{"Mode", nullptr},
+	{"Level", "3"},
+	{"Mode", "4"}
+};
+
+// Sets applied at once run each callback once, at the end of the batch
+static void testImmediate() {
+	reset();
+	WebAPI api(batchKeywords, 2);
+	apiResponse reply = api.batchHandler(batchItems, 5);
+	hostCheck(reply.responseCode == 200);
+	hostCheck(batchLevel == 3 && batchMode == 4);
+	hostCheck(levelCalls == 1 && modeCalls == 1);
+}
+
+// Deferred sets are queued by the batch, and poll() runs each callback once after the last set of the batch
+static void testDeferred() {
+	reset();
+	WebAPI api(batchKeywords, 2);
+	api.enableDeferredSets();
+	apiResponse reply = api.batchHandler(batchItems, 5);
+	hostCheck(reply.responseCode == 200);
+	hostCheck(batchLevel == 0 && levelCalls == 0);
+	hostCheck(api.poll() == 4);
+	hostCheck(batchLevel == 3 && batchMode == 4);
+	hostCheck(levelCalls == 1 && modeCalls == 1);
+
+	// Two batches before a poll are two batches, each with its callbacks
+	api.batchHandler(batchItems, 2);
+	api.batchHandler(batchItems + 3, 1);
+	hostCheck(api.poll() == 3);
+	hostCheck(batchLevel == 3 && levelCalls == 3 && modeCalls == 1);
+
+	// Single sets keep a callback each
+	char buffer[valueTextSize];
+	hostCheck(api.requestHandler("Level=5", buffer).responseCode == 200);
+	hostCheck(api.requestHandler("Level=6", buffer).responseCode == 200);
+	hostCheck(api.poll() == 2);
+	hostCheck(batchLevel == 6 && levelCalls == 5);
+}
+
+// A batch larger than the queue keeps the sets that fit, and rejects the rest as busy
+static void testQueueFull() {
+	reset();
+	WebAPI api(batchKeywords, 2);
+	api.enableDeferredSets(2);
+	apiResponse reply = api.batchHandler(batchItems, 5);
+	hostCheck(reply.responseCode == 200);
+	hostCheck(reply.responseText.indexOf("Level:503") > 0 && reply.responseText.indexOf("Mode:503") > 0);
+	hostCheck(api.poll() == 2);
+	hostCheck(batchLevel == 2 && batchMode == 0 && levelCalls == 1 && modeCalls == 0);
+}
+
+int main() {
+	testImmediate();
+	testDeferred();
+	testQueueFull();
+	return hostTestResult();
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+/*
+ * Test of history requests: the window and point count are checked and
+ * clamped before use, so a window past the history or a point count past
+ * the most a reply has still gives points, and 0 or malformed values get
+ * a 400 instead of an empty reply.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "ESPWebManager.h"
+#include "hostTest.h"
+#include <string>
+
+// Port of the test server
+#define historyPort 8084
+// Slots of the history, one per s
+#define historySlots 60
+
+static const webContentEntry historyContent[1] = {
+	{"/api", "", API, HTTP_GET}
+};
+static float historyTemp = 20;
+static apiKeyword historyKeywords[1] = {
+	bindKeyword("Temp", "TEMP", historyTemp)
+};
+static webManager historyManager(historyContent, 1, historyKeywords, 1);
+static keywordHistory<historySlots> tempHistory(1000);
+
+// Lines of a reply body, one per point
+static size_t lines(const std::string &body) {
+	size_t count = 0;
+	for (char c : body) {
+		count += (c == '\n');
+	}
+	return count;
+}
+
+int main() {
+	hostManualClock(true);
+	hostCheck(historyManager.addHistory("Temp", tempHistory));
+	historyManager.begin(historyPort);
+	AsyncWebServer *server = AsyncWebServer::hostServer(historyPort);
+	hostCheck(server != nullptr);
+	if (server == nullptr) {
+		return hostTestResult();
+	}
+	// Fill all slots, and more
+	for (uint16_t i = 0; i < historySlots * 2; i++) {
+		historyTemp = 20 + i % 5;
+		historyManager.poll();
+		hostAdvanceClock(1000);
+	}
+	historyManager.poll();
+
+	// Defaults, an hour clamped to the minute held
+	hostReply reply = server->request(HTTP_GET, "/api/history?keyword=Temp");
+	hostCheck(reply.code == 200 && lines(reply.body) == historySlots);
+	reply = server->request(HTTP_GET, "/api/history?keyword=Temp&window=30&points=10");
+	hostCheck(reply.code == 200 && lines(reply.body) == 10);
+
+	// A window past 4294967 s does not wrap around in ms, and a point count past 16 bits does not wrap to 0
+	reply = server->request(HTTP_GET, "/api/history?keyword=Temp&window=4294968&points=10");
+	hostCheck(reply.code == 200 && lines(reply.body) == 10);
+	reply = server->request(HTTP_GET, "/api/history?keyword=Temp&points=65536");
+	hostCheck(reply.code == 200 && lines(reply.body) == historySlots);
+	reply = server->request(HTTP_GET, "/api/history?keyword=Temp&window=99999999999999999999&points=99999999999999999999");
+	hostCheck(reply.code == 200 && lines(reply.body) == historySlots);
+
+	// Zero and malformed values are bad requests
+	static const char *bad[] = {"window=0", "points=0", "window=", "points=ten", "window=-5", "points=12x"};
+	for (const char *query : bad) {
+		std::string url = std::string("/api/history?keyword=Temp&") + query;
+		reply = server->request(HTTP_GET, url.c_str());
+		if (reply.code != 400) {
+			fprintf(stderr, "%s: %d\n", query, reply.code);
+		}
+		hostCheck(reply.code == 400);
+	}
+	hostCheck(server->request(HTTP_GET, "/api/history?keyword=Missing").code == 404);
+	return hostTestResult();
+}
\ No newline at end of file
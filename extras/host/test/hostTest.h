@@ -0,0 +1,27 @@
+/*
+ * Checks of the host tests. A failed check prints its expression and
+ * line and fails the test, the test goes on to report further failures.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+// Ensure the checks are only included once
+#ifndef _HostTest_
+#define _HostTest_
+
+#include <stdio.h>
+
+// Number of failed checks
+static int hostFailures = 0;
+
+// Check a condition
+#define hostCheck(condition) do { \
+	if (!(condition)) { \
+		fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+		hostFailures++; \
+	} \
+} while (0)
+
+// Exit code of the test
+#define hostTestResult() (hostFailures == 0 ? 0 : 1)
+#endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+/*
+ * Test of the value lock: the application writes a bound String from its
+ * own thread under manager.lockValues(), while requests on the server side
+ * set and read it. A request waits for the application to unlock, and
+ * every reply holds one whole value, never a String buffer being
+ * reallocated.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "ESPWebManager.h"
+#include "hostTest.h"
+#include "testRequest.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Writes by the application thread, and requests by the server thread
+#define lockWrites 200000
+#define lockRequests 200000
+
+// Values written by the application, of different lengths so the String buffer is reallocated. Shorter than the 63
+// bytes a testRequest keeps
+static const char *const applicationValues[2] = {"Idle", "Running a longer task, which does not fit the old buffer"};
+// Value set by requests
+static const char *requestValue = "Set from the web";
+
+static const webContentEntry lockContent[1] = {
+	{"/api", "", API, HTTP_GET}
+};
+static String lockStatus = "Idle";
+static apiKeyword lockKeywords[1] = {
+	bindKeyword("Status", "STATUS", lockStatus)
+};
+static webManager lockManager(lockContent, 1, lockKeywords, 1);
+static testTransport transport;
+
+// Application loop, writing the String under the value lock
+static void application(std::atomic<bool> *running) {
+	for (uint32_t i = 0; i < lockWrites && running->load(); i++) {
+		lockManager.lockValues();
+		lockStatus = applicationValues[i % 2];
+		lockManager.unlockValues();
+	}
+}
+
+// Check if a reply is one of the values written
+static bool knownValue(const char *value) {
+	return strcmp(value, applicationValues[0]) == 0 || strcmp(value, applicationValues[1]) == 0 || strcmp(value, requestValue) == 0;
+}
+
+int main() {
+	lockManager.setTransport(&transport);
+	lockManager.begin(80);
+	hostCheck(transport.handler != nullptr);
+	if (transport.handler == nullptr) {
+		return hostTestResult();
+	}
+	String getPath = "/api/Status";
+	String setPath = String("/api/Status=") + requestValue;
+
+	// A request waits while the application holds the lock, and reads what it wrote. Holds on a single core too
+	lockManager.lockValues();
+	lockStatus = applicationValues[1];
+	std::atomic<bool> replied(false);
+	char body[64] = "";
+	std::thread server([&]() {
+		testRequest request(getPath);
+		transport.handler->handleRequest(&request);
+		memcpy(body, request.body, sizeof(body));
+		replied = true;
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	hostCheck(!replied);
+	lockStatus = applicationValues[0];
+	lockManager.unlockValues();
+	server.join();
+	hostCheck(strcmp(body, applicationValues[0]) == 0);
+
+	// Writes and requests at once, on as many cores as there are
+	std::atomic<bool> running(true);
+	std::thread writer(application, &running);
+	uint32_t unknown = 0;
+	for (uint32_t i = 0; i < lockRequests; i++) {
+		testRequest request(i % 4 == 0 ? setPath : getPath);
+		transport.handler->handleRequest(&request);
+		hostCheck(request.code == 200);
+		if (i % 4 != 0 && !knownValue(request.body)) {
+			unknown++;
+		}
+	}
+	running = false;
+	writer.join();
+	hostCheck(unknown == 0);
+	hostCheck(knownValue(lockStatus.c_str()));
+	return hostTestResult();
+}
\ No newline at end of file
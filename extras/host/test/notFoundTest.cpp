@@ -0,0 +1,85 @@
+/*
+ * Test of not found handlers: a handler taking the WebRequest, and a
+ * handler of earlier versions taking the ESPAsyncWebServer request, which
+ * is called over ESPAsyncWebServer and skipped over other transports.
+ * Metrics count the status the handler sent, not a 404.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "ESPWebManager.h"
+#include "hostTest.h"
+#include "testRequest.h"
+
+// Port of the ESPAsyncWebServer manager
+#define notFoundPort 8083
+
+static const webContentEntry notFoundContent[1] = {
+	{"/api", "", API, HTTP_GET}
+};
+static bool notFoundFlag = false;
+static apiKeyword notFoundKeywords[1] = {
+	bindKeyword("Flag", "FLAG", notFoundFlag)
+};
+static webManager asyncManager(notFoundContent, 1, notFoundKeywords, 1);
+static webManager transportManager(notFoundContent, 1, notFoundKeywords, 1);
+static testTransport transport;
+
+// Not found handler taking the WebRequest
+static void webNotFound(WebRequest *request) {
+	request->send(410, "text/plain", "Gone", 4);
+}
+
+// Not found handler serving a page of its own, as a single page application does
+static void pageNotFound(WebRequest *request) {
+	request->send(200, "text/html", "index", 5);
+}
+
+// Not found handler of earlier versions
+static void asyncNotFound(AsyncWebServerRequest *request) {
+	request->send(404, "text/plain", "Missing page");
+}
+
+// Reply of a request to path, over the test transport
+static uint16_t transportRequest(const String &path, char *body) {
+	testRequest request(path);
+	transport.handler->handleRequest(&request);
+	memcpy(body, request.body, sizeof(request.body));
+	return request.code;
+}
+
+int main() {
+	// A handler of earlier versions gets the ESPAsyncWebServer request
+	asyncManager.setNotFoundHandle(asyncNotFound);
+	asyncManager.begin(notFoundPort);
+	AsyncWebServer *server = AsyncWebServer::hostServer(notFoundPort);
+	hostCheck(server != nullptr);
+	if (server != nullptr) {
+		hostReply reply = server->request(HTTP_GET, "/missing");
+		hostCheck(reply.code == 404 && reply.body == "Missing page");
+		hostCheck(server->request(HTTP_GET, "/api/Flag").code == 200);
+	}
+
+	// Over another transport the handler of earlier versions is skipped, a WebRequest handler replaces it
+	transportManager.setTransport(&transport);
+	transportManager.setNotFoundHandle(asyncNotFound);
+	transportManager.enableMetrics();
+	transportManager.begin(80);
+	hostCheck(transport.handler != nullptr);
+	if (transport.handler == nullptr) {
+		return hostTestResult();
+	}
+	String missing = "/missing";
+	char body[64];
+	hostCheck(transportRequest(missing, body) == 404 && strcmp(body, "Not found") == 0);
+	transportManager.setNotFoundHandle(webNotFound);
+	hostCheck(transportRequest(missing, body) == 410 && strcmp(body, "Gone") == 0);
+	transportManager.setNotFoundHandle(pageNotFound);
+	hostCheck(transportRequest(missing, body) == 200 && strcmp(body, "index") == 0);
+
+	// The not found route, after the one entry, counts the page as a success
+	const routeMetrics *metrics = transportManager.metrics()->route(1);
+	hostCheck(metrics != nullptr && metrics->requests == 3 && metrics->errors == 2);
+	hostCheck(metrics != nullptr && metrics->bytesSent == 9 + 4 + 5);
+	return hostTestResult();
+}
\ No newline at end of file
@@ -0,0 +1,165 @@
+/*
+ * Soak test of the buffer pool: a long random run of allocations and
+ * releases against the pool alone, then many API requests through the
+ * web manager's dispatcher with several in flight, finishing in random
+ * order. Blocks never overlap, all go back to the pool, and the heap is
+ * only touched by misses. The host heap is not the ESP32 heap, so its
+ * largest free block is not checked here.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "ESPWebManager.h"
+#include "hostAllocations.h"
+#include "hostTest.h"
+#include "testRequest.h"
+#include <random>
+#include <vector>
+
+// Number of random operations on the pool alone
+#define soakOperations 1000000
+// Number of requests through the dispatcher
+#define soakRequestCount 200000
+// Most requests in flight at once, more than the blocks of all classes so some requests miss
+#define soakInFlight 16
+
+// A buffer held by the test, filled with a pattern to find blocks handed out twice
+struct heldBuffer {
+	uint8_t *data;
+	size_t size;
+	uint8_t pattern;
+};
+
+// Random allocations (up to past the largest class) and releases, checking the blocks and the heap use
+static void soakPool() {
+	const uint16_t sizes[] = {defaultPoolSmall, defaultPoolMedium, defaultPoolLarge};
+	const uint8_t blocks[] = {defaultPoolSmallBlocks, defaultPoolMediumBlocks, defaultPoolLargeBlocks};
+	WebPool pool(sizes, blocks, 3);
+	std::mt19937 random(19);
+	std::vector<heldBuffer> held;
+	held.reserve(64);
+	bool intact = true;
+
+	hostStartCounting();
+	for (uint32_t i = 0; i < soakOperations; i++) {
+		if (held.size() < 32 && (held.empty() || random() % 2 == 0)) {
+			heldBuffer buffer;
+			buffer.size = 1 + random() % (defaultPoolLarge + 512);
+			buffer.pattern = random();
+			buffer.data = (uint8_t*)pool.allocate(buffer.size);
+			memset(buffer.data, buffer.pattern, buffer.size);
+			held.push_back(buffer);
+		} else {
+			size_t index = random() % held.size();
+			heldBuffer buffer = held[index];
+			for (size_t j = 0; j < buffer.size && intact; j++) {
+				intact = buffer.data[j] == buffer.pattern;
+			}
+			pool.release(buffer.data);
+			held[index] = held.back();
+			held.pop_back();
+		}
+	}
+	for (const heldBuffer &buffer : held) {
+		pool.release(buffer.data);
+	}
+	hostAllocationCount heap = hostStopCounting();
+
+	hostCheck(intact);
+	for (uint8_t i = 0; i < pool.classes(); i++) {
+		hostCheck(pool.sizeClass(i)->used == 0);
+		hostCheck(pool.sizeClass(i)->peak == pool.sizeClass(i)->blocks);
+	}
+	// Only misses came from the heap
+	hostCheck(pool.misses() > 0);
+	if (hostAllocationsCounted()) {
+		hostCheck(heap.allocations == pool.misses());
+	}
+	printf("pool: %u operations, %lu misses\n", soakOperations, (unsigned long)pool.misses());
+}
+
+//*************************************************************
+// Requests through the dispatcher
+//*************************************************************
+
+static const webContentEntry soakContent[1] = {
+	{"/api", "", API, HTTP_GET}
+};
+static uint32_t soakCount = 0;
+static float soakLevel = 0;
+static String soakStatus = "Idle";
+static apiKeyword soakKeywords[3] = {
+	bindKeyword("Count", "COUNT", soakCount),
+	bindKeyword("Level", "LEVEL", soakLevel),
+	bindKeyword("Status", "STATUS", soakStatus)
+};
+static webManager soakManager(soakContent, 1, soakKeywords, 3);
+static testTransport transport;
+
+// API gets and sets with up to soakInFlight requests in flight, finished in random order
+static void soakRequests() {
+	soakManager.setTransport(&transport);
+	soakManager.enableBufferPool();
+	soakManager.begin(80);
+	hostCheck(transport.handler != nullptr);
+	if (transport.handler == nullptr) {
+		return;
+	}
+	WebPool *pool = soakManager.bufferPool();
+	static const char *paths[] = {"/api/Count", "/api/Count=5", "/api/Level", "/api/Level=2.5", "/api/Status"};
+	std::vector<String> urls(paths, paths + 5);
+	std::mt19937 random(22);
+	uint32_t failed = 0;
+	uint32_t missesBefore = pool->misses();
+
+	// Requests are constructed in place, so the run itself allocates nothing but misses
+	std::vector<uint8_t> storage(sizeof(testRequest) * soakInFlight);
+	std::vector<bool> slotUsed(soakInFlight, false);
+	std::vector<uint8_t> slots;
+	slots.reserve(soakInFlight);
+	hostStartCounting();
+	for (uint32_t i = 0; i < soakRequestCount; i++) {
+		if (slots.size() == soakInFlight || (!slots.empty() && random() % 2 == 0)) {
+			size_t index = random() % slots.size();
+			uint8_t slot = slots[index];
+			testRequest *request = (testRequest*)(storage.data() + slot * sizeof(testRequest));
+			failed += request->code != 200;
+			request->~testRequest();
+			slotUsed[slot] = false;
+			slots[index] = slots.back();
+			slots.pop_back();
+		}
+		uint8_t slot = 0;
+		while (slotUsed[slot]) {
+			slot++;
+		}
+		slotUsed[slot] = true;
+		slots.push_back(slot);
+		testRequest *request = new (storage.data() + slot * sizeof(testRequest)) testRequest(urls[random() % urls.size()]);
+		transport.handler->handleRequest(request);
+	}
+	for (uint8_t slot : slots) {
+		testRequest *request = (testRequest*)(storage.data() + slot * sizeof(testRequest));
+		failed += request->code != 200;
+		request->~testRequest();
+	}
+	hostAllocationCount heap = hostStopCounting();
+
+	hostCheck(failed == 0);
+	for (uint8_t i = 0; i < pool->classes(); i++) {
+		hostCheck(pool->sizeClass(i)->used == 0);
+		hostCheck(pool->sizeClass(i)->peak <= pool->sizeClass(i)->blocks);
+	}
+	uint32_t misses = pool->misses() - missesBefore;
+	hostCheck(misses > 0);
+	if (hostAllocationsCounted()) {
+		hostCheck(heap.allocations == misses);
+	}
+	printf("requests: %u requests, %lu misses\n", soakRequestCount, (unsigned long)misses);
+}
+
+int main() {
+	soakPool();
+	soakRequests();
+	return hostTestResult();
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+/*
+ * Test of the push of keyword changes as Server-Sent Events: a client
+ * gets the full state on connect and each change after it, including a
+ * change made while a push is scanning the keywords. The push is held in
+ * its scan by the value lock, which the application takes while a request
+ * sets another keyword.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "ESPWebManager.h"
+#include "hostTest.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+// Port of the test server, and interval of the push in ms
+#define pushPort 8082
+#define pushInterval 100
+
+static const webContentEntry pushContent[1] = {
+	{"/api", "", API, HTTP_GET}
+};
+// Count comes before Status, so a push blocked on Status has already scanned past it
+static uint32_t pushCount = 0;
+static String pushStatus = "Idle";
+static apiKeyword pushKeywords[2] = {
+	bindKeyword("Count", "COUNT", pushCount),
+	bindKeyword("Status", "STATUS", pushStatus)
+};
+static webManager pushManager(pushContent, 1, pushKeywords, 2);
+
+// Find the event source among the handlers of server
+static AsyncEventSource *eventSource(AsyncWebServer *server) {
+	for (size_t i = 0; server->hostHandler(i) != nullptr; i++) {
+		AsyncEventSource *source = dynamic_cast<AsyncEventSource*>(server->hostHandler(i));
+		if (source != nullptr) {
+			return source;
+		}
+	}
+	return nullptr;
+}
+
+// Check if an event was sent to client with data containing text
+static bool sent(AsyncEventSourceClient *client, const char *text) {
+	for (const std::string &event : client->hostEvents()) {
+		if (event.find(text) != std::string::npos) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Run the manager a push interval later
+static void push() {
+	hostAdvanceClock(pushInterval);
+	pushManager.poll();
+}
+
+int main() {
+	hostManualClock(true);
+	pushManager.enablePushEvents("/events", pushInterval);
+	pushManager.begin(pushPort);
+	AsyncWebServer *server = AsyncWebServer::hostServer(pushPort);
+	AsyncEventSource *source = server != nullptr ? eventSource(server) : nullptr;
+	hostCheck(source != nullptr);
+	if (source == nullptr) {
+		return hostTestResult();
+	}
+
+	// The full state on connect, then the keywords that changed. Generation 0 is before any set, so the first push
+	// after a start has every keyword
+	AsyncEventSourceClient *client = source->hostConnect();
+	hostCheck(client->hostEvents().size() == 1 && sent(client, "Count=0&Status=Idle"));
+	hostCheck(server->request(HTTP_GET, "/api/Status=Busy").code == 200);
+	push();
+	hostCheck(client->hostEvents().size() == 2 && sent(client, "Status=Busy"));
+	push();
+	hostCheck(client->hostEvents().size() == 2);
+	hostCheck(server->request(HTTP_GET, "/api/Status=Ready").code == 200);
+	push();
+	hostCheck(client->hostEvents().size() == 3 && sent(client, "data: Status=Ready\n"));
+
+	// A push blocks on the Status value while the application holds the lock, and a request sets Count meanwhile
+	hostCheck(server->request(HTTP_GET, "/api/Status=Done").code == 200);
+	pushManager.lockValues();
+	std::atomic<bool> pushed(false);
+	std::thread pusher([&]() {
+		push();
+		pushed = true;
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	hostCheck(!pushed);
+	hostCheck(server->request(HTTP_GET, "/api/Count=5").code == 200);
+	pushManager.unlockValues();
+	pusher.join();
+	hostCheck(sent(client, "Status=Done"));
+
+	// The change made during the push is sent by the next one, if the push did not already take it
+	push();
+	hostCheck(sent(client, "Count=5"));
+	return hostTestResult();
+}
\ No newline at end of file
@@ -0,0 +1,203 @@
+/*
+ * Test of the non-blocking startup, against a mock network on a manual
+ * clock: boot latency when WiFi takes a while, reconnects with backoff
+ * while the access point is missing, a lost connection, and start() of
+ * the web manager returning (serving) before WiFi is connected.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "ESPWebManager.h"
+#include "hostTest.h"
+
+// Network connecting after a latency, or failing while the access point is missing
+class mockNetwork : public WebNetwork {
+	public:
+		WebStartup *startup = nullptr;
+		uint32_t latency = 300; // Time from connect() to the result, in ms
+		bool available = true; // Access point reachable
+		uint16_t connects = 0; // Calls of connect()
+		uint32_t connectTimes[16] = {}; // Time of the first connect() calls, in ms
+		uint16_t mdnsStarts = 0; // Calls of startMDNS()
+
+		void connect(const char *ssid, const char *password) override {
+			if (connects < 16) {
+				connectTimes[connects] = millis();
+			}
+			connects++;
+			_connectAt = millis();
+			_pending = true;
+		}
+
+		bool startMDNS(const char *hostname) override {
+			mdnsStarts++;
+			return true;
+		}
+
+		// Report the result of a connect once its latency passed, as the WiFi event task does
+		void tick() {
+			if (_pending && millis() - _connectAt >= latency) {
+				_pending = false;
+				if (available) {
+					startup->connected();
+				} else {
+					startup->disconnected();
+				}
+			}
+		}
+
+	private:
+		// A connect is in progress
+		bool _pending = false;
+		// Time of the last connect(), in ms
+		uint32_t _connectAt = 0;
+};
+
+// Phase changes reported to the callback
+struct phaseChange {
+	uint8_t phase;
+	uint8_t state;
+	uint32_t duration;
+};
+static phaseChange changes[32];
+static uint8_t changeCount = 0;
+
+// Keep phase changes
+static void recordPhase(uint8_t phase, uint8_t state, uint32_t duration) {
+	if (changeCount < 32) {
+		changes[changeCount++] = {phase, state, duration};
+	}
+}
+
+// Start connecting, and mount SPIFFS and build routes meanwhile, as webManager::start() does
+static void boot(mockNetwork &network, WebStartup &startup, const char *hostname) {
+	network.startup = &startup;
+	changeCount = 0;
+	startup.onPhase(recordPhase);
+	startup.connect("ssid", "password", hostname);
+	startup.started(phaseSPIFFS);
+	startup.finished(phaseSPIFFS, true);
+	startup.started(phaseRoutes);
+	startup.finished(phaseRoutes, true);
+}
+
+// Run the network and the startup for ms, a ms at a time, until ready if untilReady is set. Returns the time run
+static uint32_t run(mockNetwork &network, WebStartup &startup, uint32_t ms, bool untilReady = false) {
+	uint32_t elapsed = 0;
+	while (elapsed < ms && !(untilReady && startup.ready())) {
+		hostAdvanceClock(1);
+		elapsed++;
+		network.tick();
+		startup.poll();
+	}
+	return elapsed;
+}
+
+// Boot with WiFi connecting in 300 ms: the other phases do not wait for it, and MDNS follows the IP address
+static void testBootLatency() {
+	mockNetwork network;
+	WebStartup startup(&network);
+	boot(network, startup, "device");
+	hostCheck(network.connects == 1);
+	hostCheck(startup.state(phaseSPIFFS) == phaseDone && startup.state(phaseRoutes) == phaseDone);
+	hostCheck(startup.state(phaseWiFi) == phaseRunning && !startup.ready());
+
+	uint32_t latency = run(network, startup, 5000, true);
+	hostCheck(startup.ready());
+	hostCheck(latency == network.latency);
+	hostCheck(startup.duration(phaseWiFi) == network.latency);
+	hostCheck(network.mdnsStarts == 1);
+	hostCheck(changeCount == 4);
+	if (changeCount == 4) {
+		hostCheck(changes[0].phase == phaseSPIFFS && changes[1].phase == phaseRoutes);
+		hostCheck(changes[2].phase == phaseWiFi && changes[2].state == phaseDone && changes[2].duration == network.latency);
+		hostCheck(changes[3].phase == phaseMDNS && changes[3].state == phaseDone);
+	}
+}
+
+// A missing access point is retried with a doubling delay, up to the maximum, and connects once it is back
+static void testBackoff() {
+	mockNetwork network;
+	WebStartup startup(&network);
+	network.latency = 0;
+	network.available = false;
+	boot(network, startup, nullptr);
+
+	run(network, startup, 150000);
+	hostCheck(!startup.ready());
+	hostCheck(network.connects >= 10);
+	// Each failure is reported a ms after its connect, and the next attempt follows after the delay
+	uint32_t delay = defaultReconnectDelay;
+	for (uint8_t i = 1; i < 10; i++) {
+		hostCheck(network.connectTimes[i] - network.connectTimes[i - 1] == delay + 1);
+		delay = (delay * 2 > maxReconnectDelay) ? maxReconnectDelay : delay * 2;
+	}
+	hostCheck(startup.attempts() == network.connects - 1);
+
+	network.available = true;
+	run(network, startup, maxReconnectDelay + 10, true);
+	hostCheck(startup.ready());
+	hostCheck(startup.attempts() == 0);
+}
+
+// A lost connection fails the WiFi phase, which starts over and reconnects after the first delay
+static void testLostConnection() {
+	mockNetwork network;
+	WebStartup startup(&network);
+	network.latency = 100;
+	boot(network, startup, "device");
+	run(network, startup, 5000, true);
+	hostCheck(startup.ready());
+
+	changeCount = 0;
+	startup.disconnected();
+	run(network, startup, 1);
+	hostCheck(!startup.ready());
+	hostCheck(changeCount == 1 && changes[0].phase == phaseWiFi && changes[0].state == phaseFailed);
+	hostCheck(startup.state(phaseWiFi) == phaseRunning);
+
+	run(network, startup, 5000, true);
+	hostCheck(startup.ready());
+	hostCheck(startup.duration(phaseWiFi) == defaultReconnectDelay + network.latency);
+	// MDNS keeps running over the reconnect
+	hostCheck(network.mdnsStarts == 1);
+}
+
+static const webContentEntry testContent[1] = {
+	{"/api", "", API, HTTP_GET}
+};
+static bool testFlag = true;
+static apiKeyword testKeywords[1] = {
+	bindKeyword("Flag", "FLAG", testFlag)
+};
+static webManager testManager(testContent, 1, testKeywords, 1);
+
+// start() of the web manager mounts SPIFFS and serves requests without waiting for WiFi
+static void testManagerStart() {
+	SPIFFS.setRoot(hostExampleData);
+	testManager.start("ssid", "password", "device", 8081);
+	WebStartup *startup = testManager.startup();
+	hostCheck(startup != nullptr);
+	if (startup == nullptr) {
+		return;
+	}
+	hostCheck(startup->state(phaseSPIFFS) == phaseDone && startup->state(phaseRoutes) == phaseDone);
+	hostCheck(startup->state(phaseWiFi) == phaseRunning);
+	for (uint16_t i = 0; i < 100; i++) {
+		hostAdvanceClock(10);
+		testManager.poll();
+	}
+	// The stand-in WiFi never connects
+	hostCheck(!startup->ready() && startup->duration(phaseWiFi) == 1000);
+	AsyncWebServer *server = AsyncWebServer::hostServer(8081);
+	hostCheck(server != nullptr && server->request(HTTP_GET, "/api/Flag").body == "1");
+}
+
+int main() {
+	hostManualClock(true);
+	testBootLatency();
+	testBackoff();
+	testLostConnection();
+	testManagerStart();
+	return hostTestResult();
+}
\ No newline at end of file
@@ -0,0 +1,279 @@
+/*
+ * Test of the persistent keyword store on simulated flash: a filesystem
+ * in memory that counts the bytes programmed and can cut writes short, as
+ * a full flash or a power loss does. Checks restore after a reboot, write
+ * coalescing, compaction, and recovery from torn writes.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "ESPWebManager.h"
+#include "WebStore.h"
+#include "hostTest.h"
+#include <map>
+#include <string>
+#include <vector>
+
+//*************************************************************
+// Simulated flash
+//*************************************************************
+
+// Files of the simulated flash, with its write counter and fault injection
+struct flashState {
+	std::map<std::string, std::vector<uint8_t>> files;
+	size_t programmed = 0; // Bytes written
+	size_t writeLimit = SIZE_MAX; // Bytes that can be written before writes are cut short
+};
+
+// An open file of the simulated flash
+class flashFile : public fs::FileImpl {
+	public:
+		flashFile(flashState *flash, const std::string &path, size_t position) : _flash(flash), _path(path), _position(position) {}
+
+		size_t write(const uint8_t *buffer, size_t size) override {
+			size_t length = size < _flash->writeLimit ? size : _flash->writeLimit;
+			_flash->writeLimit -= length;
+			_flash->programmed += length;
+			std::vector<uint8_t> &data = _flash->files[_path];
+			if (data.size() < _position + length) {
+				data.resize(_position + length);
+			}
+			memcpy(data.data() + _position, buffer, length);
+			_position += length;
+			return length;
+		}
+		size_t read(uint8_t *buffer, size_t size) override {
+			const std::vector<uint8_t> &data = _flash->files[_path];
+			size_t length = _position < data.size() ? data.size() - _position : 0;
+			length = size < length ? size : length;
+			memcpy(buffer, data.data() + _position, length);
+			_position += length;
+			return length;
+		}
+		void flush() override {}
+		bool seek(uint32_t position, fs::SeekMode mode) override {
+			_position = position;
+			return true;
+		}
+		size_t position() const override { return _position; }
+		size_t size() const override { return _flash->files[_path].size(); }
+		void close() override {}
+		const char *name() const override { return _path.c_str(); }
+		bool isDirectory() override { return false; }
+		fs::FileImplPtr openNextFile(const char *mode) override { return fs::FileImplPtr(); }
+		operator bool() override { return true; }
+
+	private:
+		flashState *_flash;
+		std::string _path;
+		size_t _position;
+};
+
+// Filesystem over the simulated flash
+class flashFS : public fs::FSImpl {
+	public:
+		flashFS(flashState *flash) : _flash(flash) {}
+
+		fs::FileImplPtr open(const char *path, const char *mode, const bool create) override {
+			std::map<std::string, std::vector<uint8_t>>::iterator file = _flash->files.find(path);
+			if (mode[0] == 'r') {
+				return file != _flash->files.end() ? std::make_shared<flashFile>(_flash, path, 0) : fs::FileImplPtr();
+			}
+			if (mode[0] == 'w' || file == _flash->files.end()) {
+				_flash->files[path].clear();
+			}
+			return std::make_shared<flashFile>(_flash, path, mode[0] == 'a' ? _flash->files[path].size() : 0);
+		}
+		bool exists(const char *path) override {
+			return _flash->files.count(path) > 0;
+		}
+		bool rename(const char *pathFrom, const char *pathTo) override {
+			if (_flash->files.count(pathFrom) == 0) {
+				return false;
+			}
+			_flash->files[pathTo] = _flash->files[pathFrom];
+			_flash->files.erase(pathFrom);
+			return true;
+		}
+		bool remove(const char *path) override {
+			return _flash->files.erase(path) > 0;
+		}
+		bool mkdir(const char *path) override { return true; }
+		bool rmdir(const char *path) override { return true; }
+
+	private:
+		flashState *_flash;
+};
+
+//*************************************************************
+// Device
+//*************************************************************
+
+static bool storedFlag = false;
+static uint32_t storedCount = 0;
+static float storedLevel = 0;
+static String storedStatus = "";
+static char storedName[16] = "";
+static uint32_t volatileCount = 0;
+
+static apiKeyword storedKeywords[6] = {
+	persistentKeyword(bindKeyword("Flag", "FLAG", storedFlag)),
+	persistentKeyword(bindKeyword("Count", "COUNT", storedCount)),
+	persistentKeyword(bindKeyword("Level", "LEVEL", storedLevel)),
+	persistentKeyword(bindKeyword("Status", "STATUS", storedStatus)),
+	persistentKeyword(bindKeyword("Name", "NAME", storedName)),
+	bindKeyword("Volatile", "VOLATILE", volatileCount)
+};
+
+// Reset the variables, as a reboot does
+static void reboot() {
+	storedFlag = false;
+	storedCount = 0;
+	storedLevel = 0;
+	storedStatus = "";
+	storedName[0] = '\0';
+	volatileCount = 0;
+}
+
+// Set keyword to value through the API
+static void set(WebAPI &api, const char *request) {
+	char buffer[valueTextSize];
+	hostCheck(api.requestHandler(request, buffer).responseCode == 200);
+}
+
+// Restore from flash after a reboot, returns the records applied
+static uint16_t restore(flashState &flash) {
+	reboot();
+	FS fs(std::make_shared<flashFS>(&flash));
+	WebAPI api(storedKeywords, 6);
+	WebStore store(&api, fs);
+	return store.restore();
+}
+
+//*************************************************************
+// Tests
+//*************************************************************
+
+// Values of each type survive a reboot, volatile keywords do not
+static void testRestore() {
+	flashState flash;
+	FS fs(std::make_shared<flashFS>(&flash));
+	WebAPI api(storedKeywords, 6);
+	WebStore store(&api, fs);
+	hostCheck(store.restore() == 0);
+	set(api, "Flag=1");
+	set(api, "Count=1234");
+	set(api, "Level=3.5");
+	set(api, "Status=Running");
+	set(api, "Name=kitchen");
+	set(api, "Volatile=9");
+	hostCheck(store.flush());
+	hostCheck(store.records() == 5);
+	hostCheck(store.bytesWritten() == flash.programmed);
+
+	hostCheck(restore(flash) == 5);
+	hostCheck(storedFlag && storedCount == 1234 && storedLevel == 3.5f);
+	hostCheck(storedStatus == "Running" && strcmp(storedName, "kitchen") == 0);
+	hostCheck(volatileCount == 0);
+}
+
+// Changes within an interval are written as one batch, with one record per keyword
+static void testCoalescing() {
+	flashState flash;
+	FS fs(std::make_shared<flashFS>(&flash));
+	WebAPI api(storedKeywords, 6);
+	WebStore store(&api, fs, defaultStoreFile, 1000);
+	store.restore();
+	char request[24];
+	for (uint16_t i = 1; i <= 100; i++) {
+		snprintf(request, sizeof(request), "Count=%u", i);
+		set(api, request);
+		hostAdvanceClock(5);
+		store.poll();
+	}
+	hostAdvanceClock(1000);
+	store.poll();
+	hostCheck(store.changes() == 100);
+	hostCheck(store.flushes() == 1 && store.records() == 1);
+	// Nothing changed, nothing written
+	size_t programmed = flash.programmed;
+	hostCheck(store.flush());
+	hostCheck(flash.programmed == programmed);
+	hostCheck(restore(flash) == 1 && storedCount == 100);
+}
+
+// The log is compacted once it grows past the compaction size, keeping the latest values
+static void testCompaction() {
+	flashState flash;
+	FS fs(std::make_shared<flashFS>(&flash));
+	WebAPI api(storedKeywords, 6);
+	WebStore store(&api, fs, defaultStoreFile, 1000, 128);
+	store.restore();
+	char request[24];
+	for (uint16_t i = 1; i <= 200; i++) {
+		snprintf(request, sizeof(request), "Count=%u", i);
+		set(api, request);
+		set(api, "Flag=1");
+		hostCheck(store.flush());
+	}
+	hostCheck(store.compactions() > 0);
+	hostCheck(flash.files[defaultStoreFile].size() <= 128 + 32);
+	hostCheck(flash.files.count(std::string(defaultStoreFile) + ".tmp") == 0);
+	hostCheck(restore(flash) >= 2 && storedCount == 200 && storedFlag);
+}
+
+// A write cut short keeps the values of the log before it, and the batch is written again once flash takes it
+static void testTornWrite() {
+	flashState flash;
+	FS fs(std::make_shared<flashFS>(&flash));
+	WebAPI api(storedKeywords, 6);
+	WebStore store(&api, fs);
+	store.restore();
+	set(api, "Count=1");
+	set(api, "Status=Idle");
+	hostCheck(store.flush());
+
+	// Power lost a few bytes into the next batch
+	set(api, "Count=2");
+	set(api, "Status=Busy");
+	flash.writeLimit = 5;
+	hostCheck(!store.flush());
+	flashState lost = flash;
+
+	// Flash takes writes again, the log is rewritten with the batch that was cut short
+	flash.writeLimit = SIZE_MAX;
+	set(api, "Flag=1");
+	hostCheck(store.flush());
+	hostCheck(restore(flash) >= 3);
+	hostCheck(storedCount == 2 && storedStatus == "Busy" && storedFlag);
+
+	// Rebooting right after the power loss restores the values before it
+	hostCheck(restore(lost) == 2 && storedCount == 1 && storedStatus == "Idle");
+}
+
+// A compaction cut short between removing the old log and renaming the new one is finished by restore()
+static void testInterruptedCompaction() {
+	flashState flash;
+	FS fs(std::make_shared<flashFS>(&flash));
+	WebAPI api(storedKeywords, 6);
+	WebStore store(&api, fs);
+	store.restore();
+	set(api, "Count=77");
+	hostCheck(store.flush());
+	std::string tempName = std::string(defaultStoreFile) + ".tmp";
+	flash.files[tempName] = flash.files[defaultStoreFile];
+	flash.files.erase(defaultStoreFile);
+
+	hostCheck(restore(flash) == 1 && storedCount == 77);
+	hostCheck(flash.files.count(defaultStoreFile) == 1 && flash.files.count(tempName) == 0);
+}
+
+int main() {
+	hostManualClock(true);
+	testRestore();
+	testCoalescing();
+	testCompaction();
+	testTornWrite();
+	testInterruptedCompaction();
+	return hostTestResult();
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+/*
+ * A transport and a request for tests that drive the web manager's
+ * dispatcher directly, without sockets. The request keeps its reply in a
+ * fixed buffer and runs its done callback when destroyed, so it does not
+ * allocate by itself.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+// Ensure the test request is only included once
+#ifndef _TestRequest_
+#define _TestRequest_
+
+#include "WebTransport.h"
+
+// Transport keeping the handler, requests are passed to it by the test
+class testTransport : public WebTransport {
+	public:
+		WebRequestHandler *handler = nullptr;
+
+		bool begin(uint16_t port, WebRequestHandler *requestHandler) override {
+			handler = requestHandler;
+			return true;
+		}
+};
+
+// A GET request without headers or parameters, keeping its reply in a fixed buffer
+class testRequest : public WebRequest {
+	public:
+		uint16_t code = 0;
+		char body[64] = "";
+
+		testRequest(const String &path) : _path(path) {}
+		~testRequest() {
+			if (_done) {
+				_done();
+			}
+		}
+
+		const String &url() override { return _path; }
+		uint8_t method() override { return HTTP_GET; }
+		uint32_t clientAddress() override { return 0x0100007f; }
+		const char *header(const char *name) override { return nullptr; }
+		size_t params() override { return 0; }
+		const char *paramName(size_t index) override { return ""; }
+		const char *paramValue(size_t index) override { return ""; }
+		const char *param(const char *name) override { return nullptr; }
+		void addHeader(const char *name, const char *value) override {}
+
+		void send(uint16_t replyCode, const char *contentType, const char *text, size_t length) override {
+			reply(replyCode, (const uint8_t*)text, length);
+		}
+		void sendBuffer(uint16_t replyCode, const char *contentType, const uint8_t *data, size_t length, bool freeData, placeholderProcessor processor) override {
+			reply(replyCode, data, length);
+			if (freeData) {
+				free((void*)data);
+			}
+		}
+		void sendFile(File file, const char *contentType, placeholderProcessor processor) override { code = 200; }
+		void sendChunked(uint16_t replyCode, const char *contentType, webFiller filler) override { code = replyCode; }
+		void sendPrinted(uint16_t replyCode, const char *contentType, webPrinter printer) override { code = replyCode; }
+		void onDone(webDone done) override { _done = done; }
+
+	private:
+		const String &_path;
+		webDone _done;
+
+		// Keep a reply
+		void reply(uint16_t replyCode, const uint8_t *data, size_t length) {
+			code = replyCode;
+			length = length < sizeof(body) - 1 ? length : sizeof(body) - 1;
+			memcpy(body, data, length);
+			body[length] = '\0';
+		}
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,211 @@
+/*
+ * Test of the web manager over the host transport: requests over real
+ * sockets, pipelined and kept alive, ETag validation, chunked template
+ * replies, and requests finishing (pooled buffers released) when their
+ * reply is sent or their connection closes.
+ *
+ * Not part of the library, only used by the host build in extras/host.
+*/
+
+#include "ESPWebManager.h"
+#include "HostTransport.h"
+#include "hostTest.h"
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#define testEntries 4
+static const webContentEntry testContent[testEntries] = {
+	{"/", "/index.html", HTMLfile, HTTP_GET},
+	{"/styles.css", "/styles.css", RESfile, HTTP_GET},
+	{"/api", "", API, HTTP_GET | HTTP_POST | HTTP_PUT},
+	{"/bin", "", BinaryAPI, HTTP_GET}
+};
+
+static bool testLED1 = false;
+static bool testLED2 = true;
+static apiKeyword testKeywords[2] = {
+	bindKeyword("LED1State", "LED1STATE", testLED1),
+	bindKeyword("LED2State", "LED2STATE", testLED2)
+};
+static webManager testManager(testContent, testEntries, testKeywords, 2);
+static HostTransport transport;
+
+// HTML processor of the manager
+static String processor(const String &var) {
+	return testManager.APIbasedProcessor(var);
+}
+
+// A reply read by the client
+struct testReply {
+	int code;
+	std::string head;
+	std::string body;
+};
+
+// Value of a reply header, empty if not sent
+static std::string headerOf(const testReply &reply, const char *name) {
+	std::string key = std::string("\r\n") + name + ": ";
+	size_t at = reply.head.find(key);
+	if (at == std::string::npos) {
+		return std::string();
+	}
+	size_t start = at + key.size();
+	return reply.head.substr(start, reply.head.find("\r\n", start) - start);
+}
+
+// Take one reply from the front of data, false if it is not complete
+static bool parseReply(std::string &data, testReply *reply) {
+	size_t headEnd = data.find("\r\n\r\n");
+	if (headEnd == std::string::npos) {
+		return false;
+	}
+	reply->head = data.substr(0, headEnd + 2);
+	reply->code = atoi(reply->head.c_str() + 9);
+	reply->body.clear();
+	size_t position = headEnd + 4;
+	if (headerOf(*reply, "Transfer-Encoding") == "chunked") {
+		for (;;) {
+			size_t lineEnd = data.find("\r\n", position);
+			if (lineEnd == std::string::npos) {
+				return false;
+			}
+			size_t size = strtoul(data.c_str() + position, nullptr, 16);
+			if (data.size() < lineEnd + 2 + size + 2) {
+				return false;
+			}
+			reply->body.append(data, lineEnd + 2, size);
+			position = lineEnd + 2 + size + 2;
+			if (size == 0) {
+				break;
+			}
+		}
+	} else {
+		size_t length = strtoul(headerOf(*reply, "Content-Length").c_str(), nullptr, 10);
+		if (data.size() < position + length) {
+			return false;
+		}
+		reply->body = data.substr(position, length);
+		position += length;
+	}
+	data.erase(0, position);
+	return true;
+}
+
+// Connect to the server
+static int connectClient() {
+	int client = socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(transport.port());
+	connect(client, (struct sockaddr*)&address, sizeof(address));
+	return client;
+}
+
+// Send requests on client, and serve them until count replies are read. closed is set if the server closed the connection
+static std::vector<testReply> exchange(int client, const std::string &requests, size_t count, bool *closed = nullptr) {
+	send(client, requests.data(), requests.size(), 0);
+	std::vector<testReply> replies;
+	std::string data;
+	char buffer[4096];
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+	bool ended = false;
+	while (std::chrono::steady_clock::now() < deadline && !ended && (replies.size() < count || closed != nullptr)) {
+		testManager.poll();
+		ssize_t read = recv(client, buffer, sizeof(buffer), MSG_DONTWAIT);
+		if (read > 0) {
+			data.append(buffer, read);
+		} else if (read == 0) {
+			ended = true;
+		}
+		testReply reply;
+		while (parseReply(data, &reply)) {
+			replies.push_back(reply);
+		}
+	}
+	if (closed != nullptr) {
+		*closed = ended;
+	}
+	return replies;
+}
+
+// A GET request line and headers
+static std::string get(const char *path, const char *headers = "") {
+	return std::string("GET ") + path + " HTTP/1.1\r\nHost: test\r\n" + headers + "\r\n";
+}
+
+int main() {
+	SPIFFS.setRoot(hostExampleData);
+	webManager::startSPIFFS();
+	testManager.setTransport(&transport);
+	testManager.setHTMLprocessor(processor);
+	testManager.setTemplateCache(true);
+	testManager.setFileCache(32768);
+	testManager.enableBufferPool();
+	testManager.begin(0);
+	hostCheck(transport.port() != 0);
+
+	int client = connectClient();
+	// Pipelined requests are replied to in order, on one connection
+	std::vector<testReply> replies = exchange(client, get("/api/LED1State=1") + get("/api/LED1State") + get("/api/batch?LED1State&LED2State=0"), 3);
+	hostCheck(replies.size() == 3);
+	if (replies.size() == 3) {
+		hostCheck(replies[0].code == 200 && replies[0].body == "Ok");
+		hostCheck(replies[1].code == 200 && replies[1].body == "1");
+		hostCheck(replies[2].body == "LED1State:200:1\nLED2State:200:Ok\n");
+	}
+	hostCheck(testLED1 && !testLED2);
+
+	// Templates are rendered in chunks, with the current values
+	replies = exchange(client, get("/"), 1);
+	hostCheck(replies.size() == 1);
+	if (replies.size() == 1) {
+		hostCheck(replies[0].code == 200);
+		hostCheck(headerOf(replies[0], "Transfer-Encoding") == "chunked");
+		hostCheck(replies[0].body.find("</html>") != std::string::npos);
+		hostCheck(replies[0].body.find("%LED1STATE%") == std::string::npos);
+	}
+
+	// A resource is validated by its ETag, a header the handler asked for
+	replies = exchange(client, get("/styles.css"), 1);
+	std::string etag = replies.size() == 1 ? headerOf(replies[0], "ETag") : std::string();
+	hostCheck(!etag.empty());
+	replies = exchange(client, get("/styles.css", ("If-None-Match: " + etag + "\r\n").c_str()), 1);
+	hostCheck(replies.size() == 1 && replies[0].code == 304 && replies[0].body.empty());
+
+	// Not found, and the binary API from a pooled buffer
+	replies = exchange(client, get("/missing") + get("/bin/0001"), 2);
+	hostCheck(replies.size() == 2);
+	if (replies.size() == 2) {
+		hostCheck(replies[0].code == 404);
+		hostCheck(replies[1].code == 200 && headerOf(replies[1], "Content-Type") == "application/octet-stream");
+	}
+
+	// Connection: close is honoured
+	bool closed = false;
+	replies = exchange(client, get("/api/LED2State", "Connection: close\r\n"), 1, &closed);
+	hostCheck(replies.size() == 1 && replies[0].body == "0");
+	hostCheck(closed);
+	close(client);
+
+	// A connection closed before its reply is read finishes its request as well
+	client = connectClient();
+	std::string request = get("/");
+	send(client, request.data(), request.size(), 0);
+	close(client);
+	for (uint16_t i = 0; i < 100; i++) {
+		testManager.poll();
+	}
+	hostCheck(transport.connections() == 0);
+
+	// All requests are done, so no pooled buffer is held
+	WebPool *pool = testManager.bufferPool();
+	for (uint8_t i = 0; i < pool->classes(); i++) {
+		hostCheck(pool->sizeClass(i)->used == 0);
+	}
+	return hostTestResult();
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+Pack a data directory into a web asset bundle header for ESPWebManager.
+
+Each file is stored gzip-compressed when that makes it smaller, with its MIME
+type, length and ETag (FNV-1a hash of the stored bytes) worked out at build
+time. The content is placed in flash, and served by BUNDLEfile entries without
+any filesystem calls.
+
+Usage: python3 webbundle.py <data directory> <output header> [--name webBundle]
+
+Then in the sketch:
+    #include "webBundle.h"
+    webCoffee.setBundle(webBundle, webBundleFiles);
+"""
+
+import argparse
+import gzip
+import os
+import re
+import sys
+
+# MIME types for file extensions, same as the resource file table in ESPWebManager.cpp
+MIME_TYPES = {
+    "html": "text/html",
+    "htm": "text/html",
+    "css": "text/css",
+    "js": "application/javascript",
+    "json": "application/json",
+    "txt": "text/plain",
+    "xml": "text/xml",
+    "csv": "text/csv",
+    "png": "image/png",
+    "gif": "image/gif",
+    "jpg": "image/jpeg",
+    "jpeg": "image/jpeg",
+    "ico": "image/x-icon",
+    "svg": "image/svg+xml",
+    "webp": "image/webp",
+    "woff": "font/woff",
+    "woff2": "font/woff2",
+    "ttf": "font/ttf",
+    "pdf": "application/pdf",
+    "zip": "application/zip",
+    "wasm": "application/wasm",
+}
+
+
+def mime_type(file_name):
+    extension = os.path.splitext(file_name)[1][1:].lower()
+    return MIME_TYPES.get(extension, "application/octet-stream")
+
+
+def fnv1a(data):
+    value = 2166136261
+    for byte in data:
+        value = ((value ^ byte) * 16777619) & 0xFFFFFFFF
+    return value
+
+
+def identifier(bundle, file_name, index):
+    return "%sData%u_%s" % (bundle, index, re.sub(r"[^A-Za-z0-9]", "_", file_name).strip("_"))
+
+
+def bundle_files(directory):
+    files = []
+    for root, _, names in os.walk(directory):
+        for name in sorted(names):
+            path = os.path.join(root, name)
+            file_name = "/" + os.path.relpath(path, directory).replace(os.sep, "/")
+            with open(path, "rb") as file:
+                content = file.read()
+            # Keep the compressed file only where it is smaller
+            compressed = gzip.compress(content, compresslevel=9, mtime=0)
+            use_gzip = len(compressed) < len(content)
+            files.append((file_name, compressed if use_gzip else content, use_gzip))
+    return sorted(files)
+
+
+def write_header(files, output, bundle):
+    lines = [
+        "// Web asset bundle generated by extras/webbundle.py, do not edit",
+        "#pragma once",
+        "#include \"WebBundle.h\"",
+        "",
+    ]
+    total = 0
+    for index, (file_name, data, use_gzip) in enumerate(files):
+        lines.append("// %s, %u bytes%s" % (file_name, len(data), " gzip" if use_gzip else ""))
+        lines.append("static const uint8_t %s[] PROGMEM = {" % identifier(bundle, file_name, index))
+        for offset in range(0, len(data), 16):
+            lines.append("\t" + ", ".join("0x%02x" % byte for byte in data[offset:offset + 16]) + ",")
+        lines.append("};")
+        total += len(data)
+    lines.append("")
+    lines.append("// Number of files in the bundle")
+    lines.append("#define %sFiles %u" % (bundle, len(files)))
+    lines.append("")
+    lines.append("// Bundle files, %u bytes in total" % total)
+    lines.append("static const webBundleFile %s[%sFiles] = {" % (bundle, bundle))
+    for index, (file_name, data, use_gzip) in enumerate(files):
+        lines.append("\t{\"%s\", %s, %u, \"%s\", 0x%08xUL, %s}," % (
+            file_name, identifier(bundle, file_name, index), len(data), mime_type(file_name), fnv1a(data), "true" if use_gzip else "false"))
+    lines.append("};")
+    with open(output, "w") as file:
+        file.write("\n".join(lines) + "\n")
+    return total
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Pack a data directory into a web asset bundle header")
+    parser.add_argument("directory", help="data directory to pack")
+    parser.add_argument("output", help="header file to write")
+    parser.add_argument("--name", default="webBundle", help="name of the bundle table (default webBundle)")
+    args = parser.parse_args()
+    if not os.path.isdir(args.directory):
+        sys.exit("Not a directory: %s" % args.directory)
+    files = bundle_files(args.directory)
+    total = write_header(files, args.output, args.name)
+    print("Packed %u files into %s, %u bytes" % (len(files), args.output, total))
@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""
+Load generator for ESPWebManager, reporting requests/sec and p50/p99 latency.
+
+Runs a number of keep-alive HTTP/1.1 connections against a server, each sending
+requests back to back for the given duration, spread over the HTML, resource
+and API paths given. Latency is measured per request, from sending it to having
+read the whole response. Results are reported per route class, so a regression
+in e.g. the API path shows up even when static files dominate the traffic.
+
+Usage: python3 webload.py <host[:port]> [--html /index.html] [--resource /styles.css]
+                          [--api /api/LED1State] [--connections 4] [--duration 10]
+       python3 webload.py --host-server build/webhost [--host-root data] [...]
+
+Each of --html, --resource and --api can be given more than once.
+
+With --host-server, the host server of the host build (extras/host) is started on
+a free port and loaded instead of a device, so the library can be load tested and
+profiled on a Linux box. --host-root is the directory it serves as SPIFFS.
+"""
+
+import argparse
+import asyncio
+import re
+import signal
+import subprocess
+import sys
+import time
+
+
+class RouteStats:
+    def __init__(self):
+        self.latencies = []
+        self.errors = 0
+        self.bytes = 0
+
+    def percentile(self, fraction):
+        if not self.latencies:
+            return 0.0
+        ordered = sorted(self.latencies)
+        return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+async def read_response(reader):
+    # Status line and headers, then the body by Content-Length or chunks
+    status_line = await reader.readline()
+    if not status_line:
+        raise ConnectionError("connection closed")
+    code = int(status_line.split()[1])
+    length = None
+    chunked = False
+    close = False
+    while True:
+        line = await reader.readline()
+        if line in (b"\r\n", b"\n", b""):
+            break
+        name, _, value = line.decode("latin-1").partition(":")
+        name = name.strip().lower()
+        value = value.strip().lower()
+        if name == "content-length":
+            length = int(value)
+        elif name == "transfer-encoding" and "chunked" in value:
+            chunked = True
+        elif name == "connection" and value == "close":
+            close = True
+    size = 0
+    if chunked:
+        while True:
+            chunk = int((await reader.readline()).split(b";")[0], 16)
+            if chunk > 0:
+                size += len(await reader.readexactly(chunk))
+            await reader.readline()
+            if chunk == 0:
+                break
+    elif length is not None:
+        size = len(await reader.readexactly(length))
+    else:
+        size = len(await reader.read())
+        close = True
+    return code, size, close
+
+
+async def connection(host, port, requests, stats, deadline, offset):
+    reader = writer = None
+    index = offset
+    while time.monotonic() < deadline:
+        route, path = requests[index % len(requests)]
+        index += 1
+        try:
+            if writer is None:
+                reader, writer = await asyncio.open_connection(host, port)
+            start = time.monotonic()
+            writer.write(("GET %s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n\r\n" % (path, host)).encode())
+            await writer.drain()
+            code, size, close = await read_response(reader)
+            stats[route].latencies.append((time.monotonic() - start) * 1000)
+            stats[route].bytes += size
+            if code >= 400:
+                stats[route].errors += 1
+            if close:
+                writer.close()
+                writer = None
+        except (OSError, ConnectionError, ValueError, IndexError, asyncio.IncompleteReadError):
+            stats[route].errors += 1
+            if writer is not None:
+                writer.close()
+            writer = None
+            # Back off a little, a device that refuses connections should not be hammered
+            await asyncio.sleep(0.05)
+    if writer is not None:
+        writer.close()
+
+
+async def run(host, port, requests, connections, duration):
+    stats = {route: RouteStats() for route, _ in requests}
+    deadline = time.monotonic() + duration
+    # Each connection starts at a different path, so all routes see load from the start
+    await asyncio.gather(*(connection(host, port, requests, stats, deadline, i) for i in range(connections)))
+    return stats
+
+
+def report(stats, duration):
+    print("%-10s %8s %8s %10s %9s %9s %10s" % ("route", "requests", "errors", "req/s", "p50 ms", "p99 ms", "bytes"))
+    total = 0
+    for route, route_stats in stats.items():
+        count = len(route_stats.latencies)
+        total += count
+        print("%-10s %8d %8d %10.1f %9.2f %9.2f %10d" % (route, count, route_stats.errors, count / duration,
+                                                          route_stats.percentile(0.50), route_stats.percentile(0.99),
+                                                          route_stats.bytes))
+    print("%-10s %8d %8s %10.1f" % ("total", total, "", total / duration))
+
+
+def start_host_server(path, root):
+    # The server prints the port it listens on as its first line
+    command = [path, "--port", "0"] + (["--root", root] if root else [])
+    process = subprocess.Popen(command, stdout=subprocess.PIPE, text=True)
+    line = process.stdout.readline()
+    match = re.search(r"listening on port (\d+)", line)
+    if not match:
+        process.kill()
+        sys.exit("host server did not start: %s" % line.strip())
+    return process, int(match.group(1))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Load test an ESPWebManager server")
+    parser.add_argument("server", nargs="?", help="host or host:port of the server")
+    parser.add_argument("--html", action="append", default=[], help="path of an HTML page")
+    parser.add_argument("--resource", action="append", default=[], help="path of a resource file")
+    parser.add_argument("--api", action="append", default=[], help="path of an API request")
+    parser.add_argument("--connections", type=int, default=4, help="concurrent keep-alive connections")
+    parser.add_argument("--duration", type=float, default=10, help="test duration in seconds")
+    parser.add_argument("--host-server", help="start this host server (extras/host webhost) and load it")
+    parser.add_argument("--host-root", help="directory the host server serves as SPIFFS")
+    args = parser.parse_args()
+    if (args.server is None) == (args.host_server is None):
+        parser.error("give either a server or --host-server")
+
+    process = None
+    if args.host_server:
+        process, port = start_host_server(args.host_server, args.host_root)
+        host = "127.0.0.1"
+    else:
+        host, _, port = args.server.partition(":")
+    requests = [("html", path) for path in args.html] + \
+               [("resource", path) for path in args.resource] + \
+               [("api", path) for path in args.api]
+    if not requests:
+        requests = [("html", "/")]
+    try:
+        stats = asyncio.run(run(host, int(port) if port else 80, requests, args.connections, args.duration))
+    finally:
+        if process is not None:
+            process.send_signal(signal.SIGINT)
+            process.wait(timeout=5)
+    report(stats, args.duration)
+    if any(route_stats.errors for route_stats in stats.values()):
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
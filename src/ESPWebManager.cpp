@@ -28,15 +28,212 @@
 */ 
 
 #include "ESPWebManager.h"
+#include <memory>
+
+// File extension to MIME type
+struct mimeTypeEntry {
+	const char *extension;
+	const char *mimeType;
+};
+
+// MIME types for resource files
+static const mimeTypeEntry mimeTypes[] = {
+	{"html", "text/html"},
+	{"htm", "text/html"},
+	{"css", "text/css"},
+	{"js", "application/javascript"},
+	{"json", "application/json"},
+	{"txt", "text/plain"},
+	{"xml", "text/xml"},
+	{"csv", "text/csv"},
+	{"png", "image/png"},
+	{"gif", "image/gif"},
+	{"jpg", "image/jpeg"},
+	{"jpeg", "image/jpeg"},
+	{"ico", "image/x-icon"},
+	{"svg", "image/svg+xml"},
+	{"webp", "image/webp"},
+	{"woff", "font/woff"},
+	{"woff2", "font/woff2"},
+	{"ttf", "font/ttf"},
+	{"pdf", "application/pdf"},
+	{"zip", "application/zip"},
+	{"wasm", "application/wasm"}
+};
+
+// Look up MIME type from the extension of fileName
+static const char *mimeTypeOf(const char *fileName) {
+	const char *extension = strrchr(fileName, '.');
+	if (extension != nullptr) {
+		extension++;
+		for (size_t i = 0; i < sizeof(mimeTypes) / sizeof(mimeTypes[0]); i++) {
+			if (strcasecmp(extension, mimeTypes[i].extension) == 0) {
+				return mimeTypes[i].mimeType;
+			}
+		}
+	}
+	return "application/octet-stream";
+}
+
+// Hash file content (FNV-1a), used as ETag
+static uint32_t hashFile(const char *fileName) {
+	uint32_t hash = 2166136261UL;
+	File file = SPIFFS.open(fileName, "r");
+	if (!file) {
+		return hash;
+	}
+	uint8_t buffer[128];
+	size_t read;
+	while ((read = file.read(buffer, sizeof(buffer))) > 0) {
+		for (size_t i = 0; i < read; i++) {
+			hash = (hash ^ buffer[i]) * 16777619UL;
+		}
+	}
+	file.close();
+	return hash;
+}
+
+// Size of a file, 0 if it does not exist
+static size_t fileSize(const char *fileName) {
+	File file = SPIFFS.open(fileName, "r");
+	if (!file) {
+		return 0;
+	}
+	size_t size = file.size();
+	file.close();
+	return size;
+}
+
+// Parse a query parameter of at least 1, fallback if it was not sent. Values above limit (below UINT32_MAX / 10) are
+// clamped to it. Returns false for empty, malformed and 0 values
+static bool countParam(const char *text, uint32_t fallback, uint32_t limit, uint32_t *value) {
+	if (text == nullptr) {
+		*value = fallback;
+		return true;
+	}
+	uint32_t parsed = 0;
+	const char *digit = text;
+	for (; *digit >= '0' && *digit <= '9'; digit++) {
+		// Stop counting once past the limit, so long digit strings do not wrap around
+		if (parsed <= limit) {
+			parsed = parsed * 10 + (*digit - '0');
+		}
+	}
+	if (digit == text || *digit != '\0' || parsed == 0) {
+		return false;
+	}
+	*value = (parsed > limit) ? limit : parsed;
+	return true;
+}
+
+// Note the response of a tracked request
+static void noteResponse(requestContext *context, uint16_t code, size_t bytes) {
+	if (context != nullptr) {
+		context->code = code;
+		context->bytes = bytes;
+	}
+}
+
+// Request given to a custom not found handler, noting the reply the handler sends instead of assuming a 404
+class notFoundRequest : public WebRequest {
+	public:
+		// Constructor
+		notFoundRequest(WebRequest *request, requestContext *context) : _request(request), _context(context) {}
+
+		const String &url() override { return _request->url(); }
+		uint8_t method() override { return _request->method(); }
+		uint32_t clientAddress() override { return _request->clientAddress(); }
+		const char *header(const char *name) override { return _request->header(name); }
+		size_t params() override { return _request->params(); }
+		const char *paramName(size_t index) override { return _request->paramName(index); }
+		const char *paramValue(size_t index) override { return _request->paramValue(index); }
+		const char *param(const char *name) override { return _request->param(name); }
+		void addHeader(const char *name, const char *value) override { _request->addHeader(name, value); }
+		void send(uint16_t code, const char *contentType, const char *text, size_t length) override {
+			noteResponse(_context, code, length);
+			_request->send(code, contentType, text, length);
+		}
+		void sendBuffer(uint16_t code, const char *contentType, const uint8_t *data, size_t length, bool freeData = false, placeholderProcessor processor = nullptr) override {
+			noteResponse(_context, code, processor == nullptr ? length : 0);
+			_request->sendBuffer(code, contentType, data, length, freeData, processor);
+		}
+		void sendFile(File file, const char *contentType, placeholderProcessor processor = nullptr) override {
+			noteResponse(_context, 200, 0);
+			_request->sendFile(file, contentType, processor);
+		}
+		void sendChunked(uint16_t code, const char *contentType, webFiller filler) override {
+			noteResponse(_context, code, 0);
+			_request->sendChunked(code, contentType, filler);
+		}
+		void sendPrinted(uint16_t code, const char *contentType, webPrinter printer) override {
+			noteResponse(_context, code, 0);
+			_request->sendPrinted(code, contentType, printer);
+		}
+		void onDone(webDone done) override { _request->onDone(done); }
+		AsyncWebServerRequest *asyncRequest() override { return _request->asyncRequest(); }
+
+	private:
+		// The request of the transport
+		WebRequest *_request;
+		// Tracking of the request, nullptr if untracked
+		requestContext *_context;
+};
+
+// WiFi event names differ between core versions
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 2
+#define wifiEventGotIP ARDUINO_EVENT_WIFI_STA_GOT_IP
+#define wifiEventDisconnected ARDUINO_EVENT_WIFI_STA_DISCONNECTED
+#else
+#define wifiEventGotIP SYSTEM_EVENT_STA_GOT_IP
+#define wifiEventDisconnected SYSTEM_EVENT_STA_DISCONNECTED
+#endif
+
+// Startup receiving WiFi events, only one web manager starts WiFi
+static WebStartup *wifiStartup = nullptr;
+
+// Pass WiFi events on to the startup, runs on the WiFi event task
+static void onWiFiEvent(WiFiEvent_t event) {
+	if (wifiStartup == nullptr) {
+		return;
+	}
+	if (event == wifiEventGotIP) {
+		wifiStartup->connected();
+	} else if (event == wifiEventDisconnected) {
+		wifiStartup->disconnected();
+	}
+}
+
+// Startup network on the ESP32 WiFi station
+class wifiNetwork : public WebNetwork {
+	public:
+		// Start connecting, reconnects are left to the startup backoff
+		void connect(const char *ssid, const char *password) {
+			if (!_begun) {
+				_begun = true;
+				WiFi.mode(WIFI_STA);
+				WiFi.setAutoReconnect(false);
+				WiFi.onEvent(onWiFiEvent);
+				WiFi.begin(ssid, password);
+			} else {
+				WiFi.reconnect();
+			}
+		}
+		// Start the MDNS responder
+		bool startMDNS(const char *hostname) {
+			return webManager::startMDNS(hostname) == 0;
+		}
+
+	private:
+		// WiFi has been started
+		bool _begun = false;
+};
 
 //*************************************************************
 // Public functions
 //*************************************************************
 
 // Constructor, API disabled
-webManager::webManager(const webContentEntry *webContent, const uint8_t contentEntries) : _webContent(webContent), _contentEntries(contentEntries){
-	delete &api;
-}
+webManager::webManager(const webContentEntry *webContent, const uint8_t contentEntries) : _webContent(webContent), _contentEntries(contentEntries){}
 
 // Constructor, API enabled
 webManager::webManager(const webContentEntry *webContent, const uint8_t contentEntries, apiKeyword *apiKeywords, const uint8_t keywords) : _webContent(webContent), _contentEntries(contentEntries){
@@ -46,67 +243,41 @@ webManager::webManager(const webContentEntry *webContent, const uint8_t contentE
 
 // Start SPIFFS
 uint8_t webManager::startSPIFFS() {
-	#ifdef useVerboseSerial
-		Serial.print("webManager::startSPIFFS(), Starting SPIFFS...");
-	#endif
 	if (SPIFFS.begin(true)) {
-		#ifdef useVerboseSerial
-			Serial.println("Success!");
-		#endif
+		webLogInfo("webManager::startSPIFFS(), Starting SPIFFS...Success!");
 		return 0;
 	} else {
-		#ifdef useVerboseSerial
-			Serial.println("Failed!");
-		#endif
+		webLogError("webManager::startSPIFFS(), Starting SPIFFS...Failed!");
 		return 1;
 	}
 }
 
 // Start WiFi in client mode
-uint8_t webManager::startWIFIclient(const char* ssid, const char* password) {
-	#ifdef useVerboseSerial
-		Serial.print("webManager::startWIFIclient(), Starting WiFi. ");
-	#endif
+uint8_t webManager::startWIFIclient(const char* ssid, const char* password, uint32_t timeout) {
+	webLogInfo("webManager::startWIFIclient(), Starting WiFi. Connecting");
 	WiFi.mode(WIFI_STA); // Set WiFi mode to client
 	WiFi.begin(ssid, password); // Begin WiFi libaray
-	#ifdef useVerboseSerial
-		Serial.print("Connecting");
-	#endif
-	// Wait for connection
-	while (WiFi.status() != WL_CONNECTED) {
-		#ifdef useVerboseSerial
-			Serial.print(".");
-		#endif
-		delay(500); // Wait for a time
+	// Wait for connection, at most timeout ms
+	uint32_t started = millis();
+	while (WiFi.status() != WL_CONNECTED && millis() - started < timeout) {
+		delay(50); // Wait for a time
 	}
 	if (WiFi.status() == WL_CONNECTED) {
-		#ifdef useVerboseSerial
-			Serial.println("Success!");
-			Serial.print("webManager::startWIFIclient(), Connected to ");
-			Serial.println(ssid);
-			Serial.print("webManager::startWIFIclient(), IP address: ");
-			Serial.println(WiFi.localIP());
-		#endif
+		webLogInfo("webManager::startWIFIclient(), Connected to %s, IP address: %s", ssid, WiFi.localIP().toString().c_str());
 		return 0;
 	} else {
+		webLogError("webManager::startWIFIclient(), Connecting to %s...Timed out!", ssid);
 		return 1;
 	}	
 }
 
 // Start MDNS responder
 uint8_t webManager::startMDNS(const char* hostname) {
-	#ifdef useVerboseSerial
-		Serial.print("webManager::startMDNS(), Starting MDNS responder...");
-	#endif
 	if (MDNS.begin(hostname)) {
-		#ifdef useVerboseSerial
-			Serial.println("Success!");
-		#endif
+		webLogInfo("webManager::startMDNS(), Starting MDNS responder...Success!");
 		return 0;
 	} else {
-		#ifdef useVerboseSerial
-			Serial.println("Failed!");
-		#endif
+		webLogError("webManager::startMDNS(), Starting MDNS responder...Failed!");
 		return 1;
 	}
 }
@@ -135,107 +306,857 @@ String webManager::APIbasedProcessor(const String &var) {
 // Set Handle Not found callback
 void webManager::setNotFoundHandle(NotFoundHandle callback) {
 	_NotFoundHandle = callback;
+	_asyncNotFoundHandle = nullptr;
+}
+
+// Set Handle Not found callback of earlier versions
+void webManager::setNotFoundHandle(AsyncNotFoundHandle callback) {
+	_asyncNotFoundHandle = callback;
+	_NotFoundHandle = nullptr;
+}
+
+// Enable pre-parsed HTML templates
+void webManager::setTemplateCache(bool enable) {
+	_templateCache = enable;
+}
+
+// Enable streaming HTML pages with fixed memory
+void webManager::setTemplateStreaming(bool enable) {
+	_templateStreaming = enable;
+}
+
+// Set the compiled-in asset bundle
+void webManager::setBundle(const webBundleFile *files, uint16_t count) {
+	_bundle = files;
+	_bundleFiles = count;
+}
+
+// Enable in-RAM file cache
+void webManager::setFileCache(size_t budget, uint8_t maxFiles) {
+	delete _fileCache;
+	_fileCache = new WebFileCache(budget, maxFiles);
+}
+
+// Get the file cache
+WebFileCache *webManager::fileCache() {
+	return _fileCache;
+}
+
+// Enable a pool of reply buffers
+void webManager::enableBufferPool(uint8_t small, uint8_t medium, uint8_t large) {
+	const uint16_t sizes[] = {defaultPoolSmall, defaultPoolMedium, defaultPoolLarge};
+	const uint8_t blocks[] = {small, medium, large};
+	delete _pool;
+	_pool = new WebPool(sizes, blocks, 3);
+}
+
+// Get the buffer pool
+WebPool *webManager::bufferPool() {
+	return _pool;
+}
+
+// Lock String and char array values of the API
+void webManager::lockValues() {
+	if (api != nullptr) {
+		api->lockValues();
+	}
+}
+
+// Unlock String and char array values of the API
+void webManager::unlockValues() {
+	if (api != nullptr) {
+		api->unlockValues();
+	}
+}
+
+// Enable push of keyword changes as Server-Sent Events
+void webManager::enablePushEvents(const char *path, uint16_t flushInterval) {
+	// Push needs the API
+	if (api == nullptr || _events != nullptr) {
+		return;
+	}
+	_events = new AsyncEventSource(path);
+	_pushInterval = flushInterval;
+	// Send the full state to new clients, including keywords never set, changes follow as they happen
+	WebAPI *webAPI = api;
+	_events->onConnect([webAPI](AsyncEventSourceClient *client){
+		client->send(webAPI->allValues().c_str(), "update", webAPI->generation());
+	});
+}
+
+// Enable the keyword API over a WebSocket
+void webManager::enableSocketAPI(const char *path, uint16_t flushInterval) {
+	// The socket needs the API
+	if (api == nullptr || _socketAPI != nullptr) {
+		return;
+	}
+	_socketAPI = new WebSocketAPI(api, path, flushInterval);
+}
+
+// Defer keyword sets to poll()
+void webManager::enableDeferredSets(uint8_t queueSize) {
+	if (api != nullptr) {
+		api->enableDeferredSets(queueSize);
+	}
+}
+
+// Store persistent keywords on SPIFFS
+void webManager::enablePersistence(const char *fileName, uint32_t interval) {
+	_storeFile = fileName;
+	_storeInterval = interval;
+}
+
+// Get the keyword store
+WebStore *webManager::store() {
+	return _store;
+}
+
+// Enable a route returning the recent log lines
+void webManager::enableLogRoute(const char *path) {
+	_logPath = path;
+}
+
+// Set where poll() prints log lines
+void webManager::setLogOutput(Print *output) {
+	_logOutput = output;
+}
+
+// Set callback for startup phase changes
+void webManager::onStartup(startupCallback callback) {
+	_startupCallback = callback;
+}
+
+// Start without blocking
+void webManager::start(const char *ssid, const char *password, const char *hostname, uint16_t webPort) {
+	if (_startup != nullptr) {
+		return;
+	}
+	_startup = new WebStartup(new wifiNetwork());
+	_startup->onPhase(_startupCallback);
+	wifiStartup = _startup;
+	// Connect in the background, while SPIFFS is mounted and the routes are built
+	_startup->connect(ssid, password, hostname);
+	_startup->started(phaseSPIFFS);
+	_startup->finished(phaseSPIFFS, startSPIFFS() == 0);
+	_startup->started(phaseRoutes);
+	begin(webPort);
+	_startup->finished(phaseRoutes, true);
+}
+
+// Get the startup state
+WebStartup *webManager::startup() {
+	return _startup;
+}
+
+// Enable request metrics
+void webManager::enableMetrics(const char *path) {
+	_metricsPath = path;
+}
+
+// Get the metrics
+WebMetrics *webManager::metrics() {
+	return _metrics;
+}
+
+// Keep a history of a numeric keyword
+bool webManager::addHistory(const char *keyword, WebHistory &history) {
+	return api != nullptr && api->addHistory(keyword, history);
+}
+
+// Get admission control
+WebAdmission *webManager::admission() {
+	if (_admission == nullptr) {
+		_admission = new WebAdmission();
+	}
+	return _admission;
+}
+
+// Serve requests over a transport of choice
+void webManager::setTransport(WebTransport *transport) {
+	_transport = transport;
 }
 
 // Start web manager
 void webManager::begin(uint16_t webPort) {
-	#ifdef useVerboseSerial
-		Serial.println("webManager::begin(), Starting webServer...");
-		Serial.println("webManager::begin(), Setting up webpath responses...");
-	#endif
-	// Create AsyncWebServer object on webPort0
-	_server = new AsyncWebServer(webPort);
-	// Process all web content and assign on request handler 
+	webLogInfo("webManager::begin(), Starting webServer...");
+	// Serve over ESPAsyncWebServer, unless a transport was set
+	if (_transport == nullptr) {
+		_asyncTransport = new WebAsyncTransport();
+		_transport = _asyncTransport;
+	}
+	// Restore persistent keywords, before templates are parsed and requests are served
+	if (_storeFile != nullptr && api != nullptr && _store == nullptr) {
+		_store = new WebStore(api, SPIFFS, _storeFile, _storeInterval);
+		_store->restore();
+	}
+	// Create runtime state for all web content
+	_entryStates = new webEntryState[_contentEntries];
+	// Create metrics, with one route for each entry and one for not found requests
+	if (_metricsPath != nullptr) {
+		_metrics = new WebMetrics(_contentEntries + 1);
+		for (uint8_t i = 0; i < _contentEntries; i++) {
+			_metrics->setRoute(i, _webContent[i].webPath);
+		}
+		_metrics->setRoute(_contentEntries, "notfound");
+	}
+	// Process all web content and add it to the route index
+	_routes = new WebRoutes(_contentEntries);
 	for (uint8_t i = 0; i < _contentEntries; i++) {
-		#ifdef useVerboseSerial
-			Serial.print("webManager::begin(), Setting reponse for webpath: ");
-			Serial.println(_webContent[i].webPath);
-		#endif
+		webLogDebug("webManager::begin(), Setting reponse for webpath: %s", _webContent[i].webPath);
 		// Setting webserver responses
-		processWebEntry(&_webContent[i]);
+		_entryStates[i].route = i;
+		processWebEntry(&_webContent[i], &_entryStates[i]);
 	}
-	// Check if a callback for the not found handler is given
-	if (_NotFoundHandle != nullptr) {
-		// On invalid path
-		_server->onNotFound(this->_NotFoundHandle);
-	} else {
-		_server->onNotFound([](AsyncWebServerRequest *request){
-			request->send(404, "text/plain", "Not found");
-		});
+	_routes->build();
+	// Push events start from the current state, which new clients get in full on connect
+	if (api != nullptr) {
+		_pushedGeneration = api->generation();
+	}
+	// One handler serves all requests, instead of one handler per entry
+	_dispatcher = new webDispatcher(this);
+	_transport->begin(webPort, _dispatcher);
+	// Push events and the WebSocket API are handlers of ESPAsyncWebServer
+	if ((_events != nullptr || _socketAPI != nullptr) && _asyncTransport == nullptr) {
+		webLogError("webManager::begin(), Push events and the WebSocket API need ESPAsyncWebServer");
+	}
+	// Add push event stream
+	if (_events != nullptr && _asyncTransport != nullptr) {
+		_asyncTransport->server()->addHandler(_events);
+	}
+	// Add WebSocket API
+	if (_socketAPI != nullptr && _asyncTransport != nullptr) {
+		_asyncTransport->server()->addHandler(_socketAPI->handler());
+	}
+	webLogInfo("webManager::begin(), WebServer setup finished!");
+}
+
+// Service periodic work
+void webManager::poll() {
+	// Serve pending connections, for transports without a task of their own
+	if (_transport != nullptr) {
+		_transport->poll();
+	}
+	// Advance startup: connection events, reconnects and MDNS
+	if (_startup != nullptr) {
+		_startup->poll();
+	}
+	// Apply deferred keyword sets, before pushing the changes
+	if (api != nullptr) {
+		api->poll();
+	}
+	// Store changed persistent keywords, in batches
+	if (_store != nullptr) {
+		_store->poll();
+	}
+	// Print log lines, off the request path
+	if (_logOutput != nullptr) {
+		WebLog::drain(*_logOutput);
+	}
+	// Push changed keywords, at most once per interval
+	if (_events != nullptr && millis() - _lastPush >= _pushInterval) {
+		_lastPush = millis();
+		uint32_t generation = api->generation();
+		if (generation != _pushedGeneration) {
+			String values = api->changedValues(_pushedGeneration);
+			_pushedGeneration = generation;
+			if (_events->count() > 0) {
+				_events->send(values.c_str(), "update", generation);
+			}
+		}
+	}
+	// Send changes to WebSocket subscribers, at most once per interval
+	if (_socketAPI != nullptr) {
+		_socketAPI->poll();
 	}
-	// Start the webserver
-	_server->begin();
-	#ifdef useVerboseSerial
-		Serial.println("webManager::begin(), WebServer setup finished!");
-	#endif
 }
 
 //*************************************************************
 // Private functions
 //*************************************************************
 
-// Process web content, and assign proper handler
-void webManager::processWebEntry(const webContentEntry *entry) {
-	// Setup the server response on request
+// Start tracking a request until it disconnects
+requestContext *webManager::trackRequest(WebRequest *request, uint8_t route) {
+	for (uint8_t i = 0; i < maxTrackedRequests; i++) {
+		requestContext *context = &_requests[i];
+		if (!context->active) {
+			*context = {true, route, 200, 0, (uint32_t)micros(), nullptr, false, nullptr};
+			// The request holds a single done callback, so everything done at the end of a request goes through finishRequest()
+			request->onDone([this,context](){
+				this->finishRequest(context);
+			});
+			return context;
+		}
+	}
+	if (_metrics != nullptr) {
+		_metrics->untracked();
+	}
+	return nullptr;
+}
+
+// Finish a tracked request
+void webManager::finishRequest(requestContext *context) {
+	if (_metrics != nullptr) {
+		_metrics->record(context->route, context->code, context->bytes, (uint32_t)micros() - context->start);
+		_metrics->sampleHeap();
+	}
+	if (context->file != nullptr) {
+		_fileCache->release(context->file);
+	}
+	if (context->admitted) {
+		_admission->finished(_webContent[context->route].contentType);
+	}
+	if (context->buffer != nullptr) {
+		_pool->release(context->buffer);
+	}
+	context->active = false;
+}
+
+// Reject a request with 503 and Retry-After
+void webManager::rejectRequest(WebRequest *request, uint8_t index) {
+	char retryAfter[12];
+	snprintf(retryAfter, sizeof(retryAfter), "%lu", (unsigned long)_admission->retryAfter());
+	request->addHeader("Retry-After", retryAfter);
+	request->send(503, "text/plain", "Busy", 4);
+	// Not tracked, the reply is sent at once
+	if (_metrics != nullptr) {
+		_metrics->record(_entryStates[index].route, 503, 4, 0);
+	}
+}
+
+// Send the recent log lines
+void webManager::sendLog(WebRequest *request) {
+	request->sendPrinted(200, "text/plain", [](Print &output){
+		WebLog::print(output);
+	});
+}
+
+// Send the metrics
+void webManager::sendMetrics(WebRequest *request) {
+	WebMetrics *metrics = _metrics;
+	WebFileCache *cache = _fileCache;
+	WebAdmission *admission = _admission;
+	WebPool *pool = _pool;
+	request->sendPrinted(200, "text/plain; version=0.0.4", [metrics,cache,admission,pool](Print &output){
+		metrics->print(output);
+		if (cache != nullptr) {
+			output.print("# TYPE webmanager_file_cache_hits_total counter\n");
+			output.printf("webmanager_file_cache_hits_total %lu\n", (unsigned long)cache->hits());
+			output.print("# TYPE webmanager_file_cache_misses_total counter\n");
+			output.printf("webmanager_file_cache_misses_total %lu\n", (unsigned long)cache->misses());
+			output.print("# TYPE webmanager_file_cache_evictions_total counter\n");
+			output.printf("webmanager_file_cache_evictions_total %lu\n", (unsigned long)cache->evictions());
+			output.print("# TYPE webmanager_file_cache_used_bytes gauge\n");
+			output.printf("webmanager_file_cache_used_bytes %lu\n", (unsigned long)cache->used());
+		}
+		if (admission != nullptr) {
+			static const char *reasons[] = {"", "concurrency", "rate", "heap"};
+			output.print("# TYPE webmanager_rejected_total counter\n");
+			for (uint8_t reason = rejectedConcurrency; reason < admissionResults; reason++) {
+				output.printf("webmanager_rejected_total{reason=\"%s\"} %lu\n", reasons[reason], (unsigned long)admission->rejected(reason));
+			}
+		}
+		if (pool != nullptr) {
+			output.print("# TYPE webmanager_pool_used_blocks gauge\n");
+			for (uint8_t i = 0; i < pool->classes(); i++) {
+				output.printf("webmanager_pool_used_blocks{size=\"%u\"} %u\n", pool->sizeClass(i)->size, pool->sizeClass(i)->used);
+			}
+			output.print("# TYPE webmanager_pool_peak_blocks gauge\n");
+			for (uint8_t i = 0; i < pool->classes(); i++) {
+				output.printf("webmanager_pool_peak_blocks{size=\"%u\"} %u\n", pool->sizeClass(i)->size, pool->sizeClass(i)->peak);
+			}
+			output.print("# TYPE webmanager_pool_blocks gauge\n");
+			for (uint8_t i = 0; i < pool->classes(); i++) {
+				output.printf("webmanager_pool_blocks{size=\"%u\"} %u\n", pool->sizeClass(i)->size, pool->sizeClass(i)->blocks);
+			}
+			output.print("# TYPE webmanager_pool_misses_total counter\n");
+			output.printf("webmanager_pool_misses_total %lu\n", (unsigned long)pool->misses());
+		}
+	});
+}
+
+// Reply not found
+void webManager::handleNotFound(WebRequest *request) {
+	// Handlers of earlier versions reply on the ESPAsyncWebServer request, so their status is not known and not counted
+	if (_NotFoundHandle == nullptr && _asyncNotFoundHandle != nullptr && request->asyncRequest() != nullptr) {
+		_asyncNotFoundHandle(request->asyncRequest());
+		return;
+	}
+	requestContext *context = trackRequest(request, _contentEntries);
+	noteResponse(context, 404, 0);
+	if (_NotFoundHandle != nullptr) {
+		// Counted with the status the handler sends, e.g. a redirect or a page of its own
+		notFoundRequest noted(request, context);
+		_NotFoundHandle(&noted);
+	} else {
+		noteResponse(context, 404, 9);
+		request->send(404, "text/plain", "Not found", 9);
+	}
+}
+
+// Process web content, and add its route
+void webManager::processWebEntry(const webContentEntry *entry, webEntryState *state) {
+	// Prepare the server response
 	switch (entry->contentType) {
-		case HTMLfile: onHTMLrequest(entry); break; // HTML content response
-		case RESfile: onResourceRequest(entry); break; // Resource file response
-		case API: onAPIrequest(entry); break;
+		case HTMLfile: onHTMLrequest(entry, state); break; // HTML content response
+		case RESfile: onResourceRequest(entry, state); break; // Resource file response
+		case API: onAPIrequest(entry, state); break;
+		case BinaryAPI: onBinaryAPIrequest(entry, state); break;
+		case BUNDLEfile: onBundleRequest(entry, state); break;
 
 		// TODO: add more response types.
 	}
 }
 
-// Send HTML page on request
-void webManager::onHTMLrequest(const webContentEntry *entry) {
+// Find the web content entry of a request path and method, -1 if none
+int16_t webManager::findEntry(const char *path, size_t length, uint8_t method) {
+	return _routes->match(path, length, method);
+}
+
+// Serve a request for web content entry index
+void webManager::handleEntry(WebRequest *request, uint8_t index) {
+	const webContentEntry *entry = &_webContent[index];
+	webEntryState *state = &_entryStates[index];
+	// Admission control rejects before any work is done for the request
+	if (_admission != nullptr && _admission->admit(entry->contentType, request->clientAddress(), ESP.getFreeHeap()) != admitted) {
+		rejectRequest(request, index);
+		return;
+	}
+	requestContext *context = trackRequest(request, state->route);
+	if (_admission != nullptr) {
+		// An untracked request could not be counted as finished, so it is rejected as well
+		if (context == nullptr) {
+			rejectRequest(request, index);
+			return;
+		}
+		_admission->started(entry->contentType);
+		context->admitted = true;
+	}
+	switch (entry->contentType) {
+		case HTMLfile: handleHTMLrequest(request, context, entry, state); break;
+		case RESfile: sendResource(request, context, entry->fileName, state); break;
+		case API: handleAPIrequest(request, context, entry); break;
+		case BinaryAPI: handleBinaryAPIrequest(request, context, entry); break;
+		case BUNDLEfile: sendBundle(request, context, state->bundleFile); break;
+	}
+}
+
+// HTML request responder
+void webManager::onHTMLrequest(const webContentEntry *entry, webEntryState *state) {
 	// Get the fileName to pass on request
 	const char *fileName = entry->fileName;
-	// Send HTML response, with processor enabled
-	_server->on(entry->webPath, entry->methods, [this,fileName](AsyncWebServerRequest *request){
-		request->send(SPIFFS, fileName, String(), false, this->_htmlProcessor);
+	// Parse the template once, if enabled. Placeholders are resolved against the API keywords
+	if (_templateCache && api != nullptr && _htmlProcessor != nullptr) {
+		state->htmlTemplate.load(SPIFFS, fileName, api);
+	}
+	// Add the HTML page route
+	_routes->add(entry->webPath, entry->methods, state->route);
+}
+
+// Send HTML response, with processor enabled
+void webManager::handleHTMLrequest(WebRequest *request, requestContext *context, const webContentEntry *entry, webEntryState *state) {
+	if (state->htmlTemplate.loaded()) {
+		sendTemplate(request, context, &state->htmlTemplate);
+		return;
+	}
+	if (_templateStreaming && _htmlProcessor != nullptr) {
+		streamTemplate(request, context, entry->fileName);
+		return;
+	}
+	// Processed size is not known up front, so bytes are not counted
+	cachedFile *file = acquireCached(context, entry->fileName);
+	if (file != nullptr) {
+		request->sendBuffer(200, "text/html", file->data, file->size, false, _htmlProcessor);
+		return;
+	}
+	File page = SPIFFS.open(entry->fileName, "r");
+	if (page) {
+		request->sendFile(page, "text/html", _htmlProcessor);
+		return;
+	}
+	// A page only stored compressed is sent as it is, a compressed template can not be processed
+	String gzipFileName = String(entry->fileName) + ".gz";
+	page = SPIFFS.open(gzipFileName, "r");
+	if (page) {
+		request->addHeader("Content-Encoding", "gzip");
+		request->sendFile(page, "text/html");
+		return;
+	}
+	noteResponse(context, 404, 0);
+	request->send(404, "text/plain", "Not found", 9);
+}
+
+// Send pre-parsed HTML template
+void webManager::sendTemplate(WebRequest *request, requestContext *context, WebTemplate *htmlTemplate) {
+	// Render progress, owned by the response
+	templateState state;
+	htmlProcessor processor = _htmlProcessor;
+	// Stream the page in chunks, copying static spans and formatting only the values
+	// The context outlives the response, as it is only freed on disconnect
+	request->sendChunked(200, "text/html", [htmlTemplate,state,processor,context](uint8_t *buffer, size_t maxLen, size_t index) mutable -> size_t {
+		size_t length = htmlTemplate->render(&state, buffer, maxLen, processor);
+		if (context != nullptr) {
+			context->bytes += length;
+		}
+		return length;
+	});
+}
+
+// Stream HTML page from SPIFFS
+void webManager::streamTemplate(WebRequest *request, requestContext *context, const char *fileName) {
+	// Render progress and file handle, owned by the response and freed with it
+	std::shared_ptr<WebTemplateStream> stream(new WebTemplateStream(SPIFFS, fileName, api));
+	if (!stream->opened()) {
+		noteResponse(context, 404, 0);
+		request->send(404, "text/plain", "Not found", 9);
+		return;
+	}
+	htmlProcessor processor = _htmlProcessor;
+	request->sendChunked(200, "text/html", [stream,processor,context](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+		size_t length = stream->render(buffer, maxLen, processor);
+		if (context != nullptr) {
+			context->bytes += length;
+		}
+		return length;
 	});
 }
 
 // Resource request responder
-void webManager::onResourceRequest(const webContentEntry *entry) {
+void webManager::onResourceRequest(const webContentEntry *entry, webEntryState *state) {
 	// Get the fileName to pass on request
 	const char *fileName = entry->fileName;
-	// Get filename from pageLookup
-	String contentType = fileName;
-	// Get extension of filename
-	contentType = contentType.substring(contentType.lastIndexOf(".") + 1, contentType.length());
-	// Send simple text response
-	_server->on(entry->webPath, entry->methods, [fileName, contentType](AsyncWebServerRequest *request){
-		// Pass back resource
-		request->send(SPIFFS, fileName);
-	});
+	// Work out MIME type, compressed sibling and ETag once
+	state->mimeType = mimeTypeOf(fileName);
+	state->gzipFileName = String(fileName) + ".gz";
+	state->plain = SPIFFS.exists(fileName);
+	state->gzip = SPIFFS.exists(state->gzipFileName);
+	state->etag = hashFile(state->plain ? fileName : state->gzipFileName.c_str());
+	state->size = fileSize(fileName);
+	state->gzipSize = fileSize(state->gzipFileName.c_str());
+	webLogDebug("webManager::onResourceRequest(), %s is %s%s", fileName, state->mimeType, state->gzip ? ", with gzip sibling" : "");
+	// Add the resource file route
+	_routes->add(entry->webPath, entry->methods, state->route);
+}
+
+// Send resource file, with ETag validation and gzip encoding when possible
+void webManager::sendResource(WebRequest *request, requestContext *context, const char *fileName, webEntryState *state) {
+	// Use the compressed file if the client accepts it, or if it is the only one
+	const char *acceptEncoding = request->header("Accept-Encoding");
+	bool gzip = state->gzip && (!state->plain || (acceptEncoding != nullptr && strstr(acceptEncoding, "gzip") != nullptr));
+	// Each encoding is a separate representation, and gets its own ETag
+	char etag[16];
+	snprintf(etag, sizeof(etag), gzip ? "\"%08lx-gz\"" : "\"%08lx\"", (unsigned long)state->etag);
+	const char *ifNoneMatch = request->header("If-None-Match");
+	if (ifNoneMatch != nullptr && strstr(ifNoneMatch, etag) != nullptr) {
+		// Client copy is up to date
+		request->addHeader("ETag", etag);
+		if (state->gzip && state->plain) {
+			request->addHeader("Vary", "Accept-Encoding");
+		}
+		noteResponse(context, 304, 0);
+		request->send(304, nullptr, nullptr, 0);
+		return;
+	}
+	// Send from the file cache when possible, else from SPIFFS
+	const char *sendFileName = gzip ? state->gzipFileName.c_str() : fileName;
+	cachedFile *cached = acquireCached(context, sendFileName);
+	File file;
+	if (cached == nullptr) {
+		file = SPIFFS.open(sendFileName, "r");
+		// The file is missing, or was removed after begin()
+		if (!file) {
+			noteResponse(context, 404, 0);
+			request->send(404, "text/plain", "Not found", 9);
+			return;
+		}
+	}
+	if (gzip) {
+		request->addHeader("Content-Encoding", "gzip");
+	}
+	request->addHeader("ETag", etag);
+	if (state->gzip && state->plain) {
+		request->addHeader("Vary", "Accept-Encoding");
+	}
+	noteResponse(context, 200, gzip ? state->gzipSize : state->size);
+	if (cached != nullptr) {
+		// Send straight from the cached data, without copying
+		request->sendBuffer(200, state->mimeType, cached->data, cached->size);
+	} else {
+		request->sendFile(file, state->mimeType);
+	}
+}
+
+// Bundle file request responder
+void webManager::onBundleRequest(const webContentEntry *entry, webEntryState *state) {
+	// Look the file up once
+	state->bundleFile = nullptr;
+	for (uint16_t i = 0; i < _bundleFiles && state->bundleFile == nullptr; i++) {
+		if (strcmp(_bundle[i].fileName, entry->fileName) == 0) {
+			state->bundleFile = &_bundle[i];
+		}
+	}
+	if (state->bundleFile == nullptr) {
+		webLogError("webManager::onBundleRequest(), %s is not in the bundle", entry->fileName);
+		return;
+	}
+	// Add the bundle file route
+	_routes->add(entry->webPath, entry->methods, state->route);
+}
+
+// Send bundle file from flash, with ETag validation
+void webManager::sendBundle(WebRequest *request, requestContext *context, const webBundleFile *file) {
+	char etag[16];
+	snprintf(etag, sizeof(etag), file->gzip ? "\"%08lx-gz\"" : "\"%08lx\"", (unsigned long)file->etag);
+	request->addHeader("ETag", etag);
+	const char *ifNoneMatch = request->header("If-None-Match");
+	if (ifNoneMatch != nullptr && strstr(ifNoneMatch, etag) != nullptr) {
+		// Client copy is up to date
+		noteResponse(context, 304, 0);
+		request->send(304, nullptr, nullptr, 0);
+	} else {
+		// Sent straight from flash, without copying
+		if (file->gzip) {
+			request->addHeader("Content-Encoding", "gzip");
+		}
+		noteResponse(context, 200, file->size);
+		request->sendBuffer(200, file->mimeType, file->data, file->size);
+	}
+}
+
+// Get a file from the file cache
+cachedFile *webManager::acquireCached(requestContext *context, const char *fileName) {
+	// The file is released when the tracked request finishes, so untracked requests can not pin it
+	if (_fileCache == nullptr || context == nullptr) {
+		return nullptr;
+	}
+	cachedFile *file = _fileCache->acquire(SPIFFS, fileName);
+	if (file == nullptr) {
+		return nullptr;
+	}
+	// Keep the file in the cache until the response is sent
+	context->file = file;
+	return file;
+}
+
+// Send text reply, from a buffer owned by the request
+void webManager::sendText(WebRequest *request, requestContext *context, uint16_t code, const char *text, size_t length) {
+	uint8_t *body = allocateBody(context, length + 1);
+	if (body != nullptr) {
+		memcpy(body, text, length);
+	}
+	sendData(request, context, code, "text/plain", body, length);
+}
+
+// Get a reply body buffer
+uint8_t *webManager::allocateBody(requestContext *context, size_t size) {
+	// Pooled buffers go back to the pool when the tracked request finishes, one per request
+	if (_pool == nullptr || context == nullptr || context->buffer != nullptr) {
+		return (uint8_t*)malloc(size);
+	}
+	context->buffer = (uint8_t*)_pool->allocate(size);
+	return context->buffer;
+}
+
+// Release a reply body buffer that will not be sent
+void webManager::releaseBody(requestContext *context, uint8_t *body) {
+	if (context != nullptr && body != nullptr && context->buffer == body) {
+		_pool->release(body);
+		context->buffer = nullptr;
+	} else {
+		free(body);
+	}
+}
+
+// Send reply from a buffer from allocateBody(), which the request takes over
+void webManager::sendData(WebRequest *request, requestContext *context, uint16_t code, const char *contentType, uint8_t *body, size_t length) {
+	if (body == nullptr) {
+		noteResponse(context, 500, 0);
+		request->send(500, nullptr, nullptr, 0);
+		return;
+	}
+	noteResponse(context, code, length);
+	// A heap buffer is freed when the request is done, so it lives exactly as long as the response.
+	// A pooled buffer is released by finishRequest() instead
+	request->sendBuffer(code, contentType, body, length, context == nullptr || context->buffer != body);
 }
 
 // API request responder
-void webManager::onAPIrequest(const webContentEntry *entry) {
-	// Prepare webPath for API request, prepare buffer
-	char apiPath[strlen(entry->webPath) + 2];
-	// Copy webpath to buffer
-	strcpy(apiPath, entry->webPath);
-	// Add slash and wildcard
-	strcat(apiPath, "/*");
-	// HTML API request route
-	_server->on(apiPath, entry->methods, [entry,this](AsyncWebServerRequest *request){
-		// Get relative URL form the request
-		String requestURL = request->url().c_str();
-		// Remove API url part
-		requestURL = requestURL.substring(strlen(entry->webPath) + 1);
-		// Prepare API reply
-		apiResponse reply;
-		// Handle the API request, check if using custom handler
-		if (this->usingCustomAPIHandler()) {
-			// Execute custom API handler
-			reply = this->_apiCallback(&requestURL);
-		} else {
-			// Execute default API handler
-			reply = this->api->apiHandler(&requestURL);
+void webManager::onAPIrequest(const webContentEntry *entry, webEntryState *state) {
+	// The API path matches anything below it
+	state->routePath = String(entry->webPath) + "/*";
+	_routes->add(state->routePath.c_str(), entry->methods, state->route);
+}
+
+// Handle API request
+void webManager::handleAPIrequest(WebRequest *request, requestContext *context, const webContentEntry *entry) {
+	// Relative URL, viewed in place in the request URL (after the API path and slash)
+	const char *requestURL = request->url().c_str() + strlen(entry->webPath) + 1;
+	// Handle the API request, check if using custom handler
+	if (usingCustomAPIHandler()) {
+		// Execute custom API handler, on a copy of the relative URL
+		String customURL = requestURL;
+		apiResponse reply = _apiCallback(&customURL);
+		sendText(request, context, reply.responseCode, reply.responseText.c_str(), reply.responseText.length());
+	} else if (strcmp(requestURL, apiSnapshotKeyword) == 0) {
+		// Snapshot request, one body for all (changed) keywords
+		sendSnapshot(request, context);
+	} else if (strcmp(requestURL, apiHistoryKeyword) == 0) {
+		// History request, one body with all points
+		sendHistory(request, context);
+	} else if (strcmp(requestURL, apiBatchKeyword) == 0) {
+		// Batch request, each query parameter is an item. Parameters without a value are gets
+		uint8_t count = request->params() < apiBatchMaxItems ? request->params() : apiBatchMaxItems;
+		apiBatchItem items[apiBatchMaxItems];
+		for (uint8_t i = 0; i < count; i++) {
+			const char *value = request->paramValue(i);
+			items[i] = {request->paramName(i), *value != '\0' ? value : nullptr};
 		}
-		// Send back a replay, 200 if ok
-		request->send(reply.responseCode, "text/plain",reply.responseText);
+		apiResponse reply = api->batchHandler(items, count);
+		sendText(request, context, reply.responseCode, reply.responseText.c_str(), reply.responseText.length());
+	} else {
+		// Execute default API handler, without intermediate Strings. The reply is copied under the value lock
+		valueLock lock(api);
+		char buffer[valueTextSize];
+		apiReply reply = api->requestHandler(requestURL, buffer);
+		sendText(request, context, reply.responseCode, reply.text, reply.length);
+	}
+}
+
+// Send snapshot of all keywords, or those changed since a generation
+void webManager::sendSnapshot(WebRequest *request, requestContext *context) {
+	uint32_t generation = api->generation();
+	char etag[16];
+	snprintf(etag, sizeof(etag), "\"%lu\"", (unsigned long)generation);
+	request->addHeader("ETag", etag);
+	request->addHeader("Cache-Control", "no-cache");
+	const char *ifNoneMatch = request->header("If-None-Match");
+	if (ifNoneMatch != nullptr && strcmp(ifNoneMatch, etag) == 0) {
+		// Nothing changed since the client's copy
+		noteResponse(context, 304, 0);
+		request->send(304, nullptr, nullptr, 0);
+	} else {
+		// Changes made while building the body may be included, the client gets them again with the next since
+		const char *since = request->param("since");
+		String values = api->changedValues(since != nullptr ? strtoul(since, nullptr, 10) : 0);
+		noteResponse(context, 200, values.length());
+		request->send(200, "text/plain", values.c_str(), values.length());
+	}
+}
+
+// Send history of a keyword
+void webManager::sendHistory(WebRequest *request, requestContext *context) {
+	const char *keyword = request->param("keyword");
+	if (keyword == nullptr) {
+		sendText(request, context, 400, "Bad request", 11);
+		return;
+	}
+	WebHistory *history = api->history(keyword);
+	if (history == nullptr) {
+		sendText(request, context, 404, "No history", 10);
+		return;
+	}
+	// The window is clamped to the history, before it is converted to ms, and points to the most a reply has
+	uint32_t windowLength;
+	uint32_t pointCount;
+	if (!countParam(request->param("window"), 3600, history->span(), &windowLength) || !countParam(request->param("points"), 60, historyMaxPoints, &pointCount)) {
+		sendText(request, context, 400, "Bad request", 11);
+		return;
+	}
+	request->sendPrinted(200, "text/plain", [history,windowLength,pointCount,context](Print &output){
+		noteResponse(context, 200, history->print(output, windowLength * 1000, pointCount, millis()));
 	});
+}
+
+// Binary API request responder
+void webManager::onBinaryAPIrequest(const webContentEntry *entry, webEntryState *state) {
+	// Needs the API keywords as schema
+	if (api == nullptr) {
+		return;
+	}
+	// The binary API path matches anything below it
+	state->routePath = String(entry->webPath) + "/*";
+	_routes->add(state->routePath.c_str(), entry->methods, state->route);
+}
+
+// Handle binary API request. The request is the keyword ids as hex bytes ("/bin/00010a"), empty for all keywords,
+// or "schema" for the "id type name" lines mapping names to ids
+void webManager::handleBinaryAPIrequest(WebRequest *request, requestContext *context, const webContentEntry *entry) {
+	// Relative URL, viewed in place in the request URL (after the path and slash)
+	const char *requestURL = request->url().c_str() + strlen(entry->webPath) + 1;
+	if (strcmp(requestURL, apiSchemaKeyword) == 0) {
+		String schema = api->binarySchema();
+		sendText(request, context, 200, schema.c_str(), schema.length());
+		return;
+	}
+	// Decode the keyword ids
+	size_t hexLength = strlen(requestURL);
+	if (hexLength % 2 != 0 || hexLength / 2 > 255) {
+		sendText(request, context, 400, "Bad request", 11);
+		return;
+	}
+	uint8_t count = hexLength / 2;
+	uint8_t ids[255];
+	for (uint8_t i = 0; i < count; i++) {
+		char hex[3] = {requestURL[i * 2], requestURL[i * 2 + 1], '\0'};
+		char *end;
+		ids[i] = strtoul(hex, &end, 16);
+		if (*end != '\0') {
+			sendText(request, context, 400, "Bad request", 11);
+			return;
+		}
+	}
+	// Size the frame, then fill it
+	uint8_t probe[64];
+	size_t length = api->binaryValues(ids, count, probe, sizeof(probe));
+	uint8_t *body = allocateBody(context, length);
+	if (body != nullptr) {
+		if (length <= sizeof(probe)) {
+			memcpy(body, probe, length);
+		} else {
+			// A string value that grew in between does not fit, and is not sent half
+			size_t filled = api->binaryValues(ids, count, body, length);
+			if (filled > length) {
+				releaseBody(context, body);
+				body = nullptr;
+			}
+			length = filled;
+		}
+	}
+	sendData(request, context, 200, "application/octet-stream", body, length);
+}
+
+//*************************************************************
+// Dispatcher
+//*************************************************************
+
+// Constructor
+webDispatcher::webDispatcher(webManager *manager) : _manager(manager) {}
+
+// Check if the request is for web content, the log or the metrics
+bool webDispatcher::canHandle(const char *path, size_t length, uint8_t method) {
+	if (_manager->findEntry(path, length, method) >= 0) {
+		return true;
+	}
+	return method == HTTP_GET && ((_manager->_logPath != nullptr && strcmp(path, _manager->_logPath) == 0) || (_manager->_metrics != nullptr && strcmp(path, _manager->_metricsPath) == 0));
+}
+
+// Headers used for ETag validation and gzip encoding
+const char *const *webDispatcher::headers() {
+	static const char *const names[] = {"If-None-Match", "Accept-Encoding", nullptr};
+	return names;
+}
+
+// Serve the request
+void webDispatcher::handleRequest(WebRequest *request) {
+	// Matched again, as other requests may be matched between canHandle() and handleRequest()
+	const String &url = request->url();
+	int16_t index = _manager->findEntry(url.c_str(), url.length(), request->method());
+	if (index >= 0) {
+		_manager->handleEntry(request, index);
+	} else if (request->method() == HTTP_GET && _manager->_logPath != nullptr && url == _manager->_logPath) {
+		_manager->sendLog(request);
+	} else if (request->method() == HTTP_GET && _manager->_metrics != nullptr && url == _manager->_metricsPath) {
+		_manager->sendMetrics(request);
+	} else {
+		_manager->handleNotFound(request);
+	}
 }
\ No newline at end of file
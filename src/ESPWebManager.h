@@ -38,25 +38,82 @@
 #include "ESPAsyncWebServer.h"
 #include "SPIFFS.h"
 #include "WebAPI.h"
+#include "WebTemplate.h"
+#include "WebFileCache.h"
+#include "WebLog.h"
+#include "WebMetrics.h"
+#include "WebStartup.h"
+#include "WebRoutes.h"
+#include "WebStore.h"
+#include "WebBundle.h"
+#include "WebAdmission.h"
+#include "WebPool.h"
+#include "WebSocketAPI.h"
+#include "WebTransport.h"
+#include "WebAsyncTransport.h"
 
-#define useVerboseSerial true
 #define defaultWebPort 80
+// Default time startWIFIclient() waits for a connection, in ms
+#define defaultWiFiTimeout 20000
+// Default path of the push event stream
+#define defaultPushPath "/events"
+// Default interval between push events, in ms
+#define defaultPushInterval 100
+// Default path of the WebSocket API
+#define defaultSocketPath "/ws"
+// Default path of the recent log lines
+#define defaultLogPath "/log"
+// Maximum number of items in an API batch request
+#define apiBatchMaxItems 64
+// Default path of the metrics route
+#define defaultMetricsPath "/metrics"
+// Maximum number of requests tracked at once (the async TCP stack serves at most this many connections)
+#define maxTrackedRequests 16
 
 // Content types for web
 typedef enum {
   	HTMLfile, // Content is a HTML file, and should be send as HTML string with processor enabled (to allow updating variable states)
   	RESfile, // Content is a resources file and should be passed as text formatted as according to the file extension
-  	API // Content (or rather webpath) is an api interface, and should reply with a response code and a short text message
+  	API, // Content (or rather webpath) is an api interface, and should reply with a response code and a short text message
+  	BinaryAPI, // Content (or rather webpath) is a binary api interface, replying with packed keyword values (see WebAPI::binaryValues())
+  	BUNDLEfile // Content is a file in the compiled-in asset bundle (see setBundle()), fileName is its path in the data directory. Sent as is, without processor
 } contentTypes; 
 
 // Struct template for managing webpages
 struct webContentEntry {
-	const char *webPath; // The path to type in a browser to access the content
+	const char *webPath; // The path to type in a browser to access the content. Also "/path/*", "/prefix*" or "/*.ext", as ESPAsyncWebServer
 	const char *fileName; // The (path and) filename to the file, which SPIFFS is to access
 	const uint8_t contentType; // The content type
 	const WebRequestMethodComposite methods; // Methods allowed for the web content, normally GET for HTML and resource files.
 };
 
+// Runtime state kept for each web content entry
+struct webEntryState {
+	WebTemplate htmlTemplate; // Pre-parsed HTML template, for HTMLfile entries when the template cache is enabled
+	const char *mimeType; // MIME type from the file extension, for RESfile entries
+	uint32_t etag; // Hash of the file content, sent as strong ETag
+	bool plain; // The uncompressed file exists
+	bool gzip; // A pre-compressed .gz sibling exists
+	String gzipFileName; // File name of the .gz sibling
+	size_t size; // Size of the file
+	size_t gzipSize; // Size of the .gz sibling
+	uint8_t route; // Index of the entry, used for routing and metrics
+	String routePath; // Route path, for API entries (webPath with "/*" added)
+	const webBundleFile *bundleFile; // Bundle file, for BUNDLEfile entries
+};
+
+// A request in flight, from a fixed pool of slots so tracking needs no allocation
+struct requestContext {
+	bool active; // The slot tracks a request
+	uint8_t route; // Route index, for metrics
+	uint16_t code; // Response code
+	size_t bytes; // Response body bytes, where the size is known
+	uint32_t start; // Time the request was received, in us
+	cachedFile *file; // Cached file being sent, released when the request is done
+	bool admitted; // Counted as in flight by admission control
+	uint8_t *buffer; // Pooled response body, released when the request is done
+};
+
 // Callback function typedef (will return an apiResponse struct, is named apiCallback (and is a pointer to a function), take a String pointer as input)
 typedef apiResponse (*apiCallback)(String *);
 
@@ -64,10 +121,33 @@ typedef apiResponse (*apiCallback)(String *);
 typedef String (*htmlProcessor)(const String &);
 
 // Callback function typedef for HandleNotFound function.
-typedef void (*NotFoundHandle)(AsyncWebServerRequest *);
+typedef void (*NotFoundHandle)(WebRequest *);
+// Callback function typedef for HandleNotFound function of earlier versions, taking the ESPAsyncWebServer request.
+// Only called over ESPAsyncWebServer, other transports reply not found
+typedef void (*AsyncNotFoundHandle)(AsyncWebServerRequest *);
+
+class webManager;
+
+// Single handler for all requests of the transport, dispatching web content through the route index
+class webDispatcher : public WebRequestHandler {
+	public:
+		// Constructor
+		webDispatcher(webManager *manager);
+		// Check if the request is for web content, the log or the metrics
+		bool canHandle(const char *path, size_t length, uint8_t method) override;
+		// Headers used for ETag validation and gzip encoding
+		const char *const *headers() override;
+		// Serve the request, or reply not found
+		void handleRequest(WebRequest *request) override;
+
+	private:
+		// Web manager owning the content
+		webManager *_manager;
+};
 
 class webManager {
 	friend class WebAPI;
+	friend class webDispatcher;
 
 	public:
 		// Constructor with API disabled
@@ -75,8 +155,8 @@ class webManager {
 		// Constructor with API enabled
 		webManager(const webContentEntry *webContent, const uint8_t contentEntries, apiKeyword *apiKeywords, const uint8_t keywords);
 
-		// Generic function for starting WiFi in station mode
-		static uint8_t startWIFIclient(const char* ssid, const char* password);
+		// Generic function for starting WiFi in station mode, waits at most timeout ms for a connection
+		static uint8_t startWIFIclient(const char* ssid, const char* password, uint32_t timeout = defaultWiFiTimeout);
 		// Generic function for starting SPIFFS
 		static uint8_t startSPIFFS();
 		// Generic function for starting MDNS responder
@@ -94,38 +174,227 @@ class webManager {
 
 		// Set Handle Not found callback
 		void setNotFoundHandle(NotFoundHandle callback);
+		// Set Handle Not found callback of earlier versions, taking the ESPAsyncWebServer request
+		void setNotFoundHandle(AsyncNotFoundHandle callback);
+
+		// Enable parsing HTML files once at begin(), instead of on every request. Needs the API and a HTML processor
+		void setTemplateCache(bool enable);
+		// Enable streaming HTML pages from SPIFFS in chunks, expanding placeholders with fixed memory per response
+		// (used when the template cache is off). Needs a HTML processor
+		void setTemplateStreaming(bool enable);
+		// Set the compiled-in asset bundle, generated by extras/webbundle.py, for BUNDLEfile entries. Call before begin()
+		void setBundle(const webBundleFile *files, uint16_t count);
+		// Enable in-RAM cache of hot files, holding at most budget bytes (PSRAM when present)
+		void setFileCache(size_t budget, uint8_t maxFiles = defaultCacheFiles);
+		// Get the file cache (for hit/miss/eviction counters), nullptr if not enabled
+		WebFileCache *fileCache();
+		// Enable a pool of fixed size buffers for API reply bodies, allocated once so replies do not fragment the heap.
+		// Takes the given number of 128, 512 and 2048 byte blocks. Call before begin()
+		void enableBufferPool(uint8_t small = defaultPoolSmallBlocks, uint8_t medium = defaultPoolMediumBlocks, uint8_t large = defaultPoolLargeBlocks);
+		// Get the buffer pool (for block usage and miss counters), nullptr if not enabled
+		WebPool *bufferPool();
+
+		// Enable push of keyword changes as Server-Sent Events ("update" events with "keyword=value&keyword=value" data).
+		// Changes are coalesced into one event per flushInterval ms. Call before begin()
+		void enablePushEvents(const char *path = defaultPushPath, uint16_t flushInterval = defaultPushInterval);
+
+		// Enable the keyword API over a WebSocket, where clients subscribe to keywords and prefix groups ("sub LED* Temp")
+		// and set them ("set LED1State=1") on one connection. Changes of subscribed keywords are sent as one frame per
+		// client per flushInterval ms. Call before begin()
+		void enableSocketAPI(const char *path = defaultSocketPath, uint16_t flushInterval = defaultPushInterval);
+
+		// Lock String and char array values of the API, to write bound strings from the application while the server runs,
+		// e.g. manager.lockValues(); status = "Running"; manager.unlockValues();. Recursive, does nothing without the API
+		void lockValues();
+		// Unlock String and char array values of the API
+		void unlockValues();
+
+		// Defer keyword sets to poll(), so values are written and callbacks run from loop() instead of the web server task.
+		// Set requests are replied to at once, and refused with 503 when queueSize sets are waiting. Call before begin()
+		void enableDeferredSets(uint8_t queueSize = defaultSetQueueSize);
+
+		// Store persistent keywords (see persistentKeyword()) in a log file on SPIFFS. Values are restored by begin(),
+		// before any request is served, and changes are written in batches every interval ms by poll(). Call before begin()
+		void enablePersistence(const char *fileName = defaultStoreFile, uint32_t interval = defaultStoreInterval);
+		// Get the keyword store (for write counters), nullptr if not enabled
+		WebStore *store();
+
+		// Enable a route returning the recent log lines. Call before begin()
+		void enableLogRoute(const char *path = defaultLogPath);
+		// Set where poll() prints log lines, nullptr to only keep them for the log route
+		void setLogOutput(Print *output);
+
+		// Enable request metrics, exported on path in the Prometheus text format. Call before begin()
+		void enableMetrics(const char *path = defaultMetricsPath);
+		// Get the metrics, nullptr if not enabled
+		WebMetrics *metrics();
+
+		// Keep a history of a numeric keyword, sampled by poll() and queried with /api/history?keyword=Name&window=s&points=n.
+		// The history holds its own storage, e.g. keywordHistory<360> history(10000). Returns false if the keyword is unknown or not a number
+		bool addHistory(const char *keyword, WebHistory &history);
+
+		// Get admission control, created on first use, to cap requests in flight per content type, rate limit clients
+		// and set a free heap floor. Rejected requests get a 503 with Retry-After. Set limits before begin()
+		WebAdmission *admission();
+
+		// Serve requests over transport instead of ESPAsyncWebServer, such as a host server for tests. The transport must
+		// outlive the web manager. Push events and the WebSocket API need ESPAsyncWebServer. Call before begin()
+		void setTransport(WebTransport *transport);
 
 		// Start the web manager
 		void begin(uint16_t webPort = defaultWebPort);
 
+		// Set callback for startup phase changes, called from start() and poll()
+		void onStartup(startupCallback callback);
+		// Start without blocking, instead of startSPIFFS(), startWIFIclient(), startMDNS() and begin(). WiFi connects in the
+		// background while SPIFFS is mounted and the routes are built, then MDNS starts if a hostname is given.
+		// Lost connections are retried with backoff, so ssid, password and hostname must stay valid. poll() drives the startup, so call it from loop()
+		void start(const char *ssid, const char *password, const char *hostname = nullptr, uint16_t webPort = defaultWebPort);
+		// Get the startup state (phase states and durations), nullptr if start() was not used
+		WebStartup *startup();
+
+		// Service periodic work, such as advancing startup, applying deferred sets, sending push events and printing log lines. Call from loop()
+		void poll();
+
 	private:
 		// Webcontent entri struct
 		const webContentEntry *_webContent;
 		// Number of web entries
 		const uint8_t _contentEntries;
 
-		// Web server pointer
-		AsyncWebServer *_server;
+		// Transport requests are served over
+		WebTransport *_transport = nullptr;
+		// The ESPAsyncWebServer transport, when used
+		WebAsyncTransport *_asyncTransport = nullptr;
+		// Handler of the requests of the transport
+		webDispatcher *_dispatcher = nullptr;
+
+		// Runtime state for each web content entry
+		webEntryState *_entryStates = nullptr;
+		// Route index of the web content entries
+		WebRoutes *_routes = nullptr;
 
 		// API class pointer
-		WebAPI *api;
+		WebAPI *api = nullptr;
 		// Custom callback pointer for API request handler
 		apiCallback _apiCallback = nullptr;
 
 		// Callback pointer for not found handler
 		NotFoundHandle _NotFoundHandle = nullptr;
+		// Callback pointer for not found handler of earlier versions
+		AsyncNotFoundHandle _asyncNotFoundHandle = nullptr;
 
 		// Callback pointer for HTML processor
 		htmlProcessor _htmlProcessor = nullptr;
 
-		// Process web content, and assign proper handler
-		void processWebEntry(const webContentEntry *entry);
+		// Use pre-parsed HTML templates
+		bool _templateCache = false;
+		// Stream HTML pages with fixed memory
+		bool _templateStreaming = false;
+		// In-RAM file cache
+		WebFileCache *_fileCache = nullptr;
+		// Pool of reply buffers
+		WebPool *_pool = nullptr;
+		// Compiled-in asset bundle
+		const webBundleFile *_bundle = nullptr;
+		// Number of files in the bundle
+		uint16_t _bundleFiles = 0;
+
+		// Push event stream
+		AsyncEventSource *_events = nullptr;
+		// Interval between push events, in ms
+		uint16_t _pushInterval = defaultPushInterval;
+		// Time of last push event
+		uint32_t _lastPush = 0;
+		// Change generation sent in the last push event
+		uint32_t _pushedGeneration = 0;
+
+		// WebSocket API
+		WebSocketAPI *_socketAPI = nullptr;
+
+		// Persistent keyword store
+		WebStore *_store = nullptr;
+		// File of the keyword store, nullptr if not enabled
+		const char *_storeFile = nullptr;
+		// Interval between writes of the keyword store, in ms
+		uint32_t _storeInterval = defaultStoreInterval;
+
+		// Path of the log route
+		const char *_logPath = nullptr;
+		// Output for log lines
+		Print *_logOutput = &Serial;
+
+		// Startup state machine, when started with start()
+		WebStartup *_startup = nullptr;
+		// Callback for startup phase changes
+		startupCallback _startupCallback = nullptr;
+
+		// Request metrics
+		WebMetrics *_metrics = nullptr;
+		// Path of the metrics route
+		const char *_metricsPath = nullptr;
+		// Admission control, nullptr if not used
+		WebAdmission *_admission = nullptr;
+		// Tracking slots for requests in flight
+		requestContext _requests[maxTrackedRequests] = {};
+
+		// Process web content, and add its route
+		void processWebEntry(const webContentEntry *entry, webEntryState *state);
+		// Find the web content entry of a request path and method, -1 if none
+		int16_t findEntry(const char *path, size_t length, uint8_t method);
+		// Serve a request for web content entry index
+		void handleEntry(WebRequest *request, uint8_t index);
+
+		// Start tracking a request until it disconnects, nullptr if all slots are in use
+		requestContext *trackRequest(WebRequest *request, uint8_t route);
+		// Finish a tracked request, record metrics and release its resources
+		void finishRequest(requestContext *context);
+		// Reject a request for web content entry index with 503 and Retry-After
+		void rejectRequest(WebRequest *request, uint8_t index);
 
 		// HTML request responder
-		void onHTMLrequest(const webContentEntry *entry);
+		void onHTMLrequest(const webContentEntry *entry, webEntryState *state);
+		// Send HTML page
+		void handleHTMLrequest(WebRequest *request, requestContext *context, const webContentEntry *entry, webEntryState *state);
+		// Send pre-parsed HTML template
+		void sendTemplate(WebRequest *request, requestContext *context, WebTemplate *htmlTemplate);
+		// Stream HTML page from SPIFFS, expanding placeholders on the way
+		void streamTemplate(WebRequest *request, requestContext *context, const char *fileName);
 		// Resource request responder
-		void onResourceRequest(const webContentEntry *entry);
+		void onResourceRequest(const webContentEntry *entry, webEntryState *state);
+		// Send resource file, with ETag validation and gzip encoding when possible
+		void sendResource(WebRequest *request, requestContext *context, const char *fileName, webEntryState *state);
+		// Bundle file request responder
+		void onBundleRequest(const webContentEntry *entry, webEntryState *state);
+		// Send bundle file from flash, with ETag validation
+		void sendBundle(WebRequest *request, requestContext *context, const webBundleFile *file);
+		// Get a file from the file cache, held until the tracked request finishes. nullptr on a cache miss the cache can not hold or an untracked request
+		cachedFile *acquireCached(requestContext *context, const char *fileName);
 		// API request responder
-		void onAPIrequest(const webContentEntry *entry);
+		void onAPIrequest(const webContentEntry *entry, webEntryState *state);
+		// Handle API request
+		void handleAPIrequest(WebRequest *request, requestContext *context, const webContentEntry *entry);
+		// Send snapshot of all keywords, or those changed since a generation, with the generation as ETag
+		void sendSnapshot(WebRequest *request, requestContext *context);
+		// Send history of a keyword, downsampled to points lines
+		void sendHistory(WebRequest *request, requestContext *context);
+		// Send text reply, from a buffer owned by the request
+		void sendText(WebRequest *request, requestContext *context, uint16_t code, const char *text, size_t length);
+		// Get a reply body buffer, from the pool when the request is tracked, else from the heap. nullptr if out of memory
+		uint8_t *allocateBody(requestContext *context, size_t size);
+		// Release a reply body buffer that will not be sent
+		void releaseBody(requestContext *context, uint8_t *body);
+		// Send the recent log lines
+		void sendLog(WebRequest *request);
+		// Send the metrics, in the Prometheus text format
+		void sendMetrics(WebRequest *request);
+		// Reply not found, with the not found handler if set
+		void handleNotFound(WebRequest *request);
+		// Send reply from a buffer from allocateBody(), which the request takes over
+		void sendData(WebRequest *request, requestContext *context, uint16_t code, const char *contentType, uint8_t *body, size_t length);
+		// Binary API request responder
+		void onBinaryAPIrequest(const webContentEntry *entry, webEntryState *state);
+		// Handle binary API request
+		void handleBinaryAPIrequest(WebRequest *request, requestContext *context, const webContentEntry *entry);
 };
 #endif
\ No newline at end of file
@@ -31,335 +31,993 @@
 #include "Arduino.h"
 #include "WebAPI.h"
 
+// Compare a (non null terminated) name against a keyword field, strcmp style
+static int compareName(const char *name, size_t length, const String &field) {
+	// Compare the common part of the two names
+	int result = strncmp(name, field.c_str(), length);
+	if (result != 0) {
+		return result;
+	}
+	// Equal up to length, the shorter name sorts first
+	return (field.length() > length) ? -1 : 0;
+}
+
+// Common replies
+static const apiReply replyOk = {200, "Ok", 2};
+static const apiReply replyBadValue = {400, "Bad value", 9};
+static const apiReply replyNotFound = {404, "Not found", 9};
+static const apiReply replyBusy = {503, "Busy", 4};
+
+// Clamp snprintf result to a formatted length in a valueTextSize buffer
+static size_t clampLength(int formatted) {
+	if (formatted < 0) {
+		return 0;
+	}
+	return (formatted >= valueTextSize) ? valueTextSize - 1 : formatted;
+}
+
+// Text formatting and parsing of each number type
+template <typename T>
+struct valueTraits;
+template <>
+struct valueTraits<bool> {
+	static int format(char *buffer, bool value) { return snprintf(buffer, valueTextSize, "%u", (unsigned int)value); }
+	static void parse(const char *text, char **end, bool *value) {
+		// Also accept true and false
+		if (strcmp(text, "true") == 0 || strcmp(text, "false") == 0) {
+			*value = (text[0] == 't');
+			*end = (char*)text + strlen(text);
+		} else {
+			*value = strtol(text, end, 10) != 0;
+		}
+	}
+};
+template <>
+struct valueTraits<uint32_t> {
+	static int format(char *buffer, uint32_t value) { return snprintf(buffer, valueTextSize, "%lu", (unsigned long)value); }
+	static void parse(const char *text, char **end, uint32_t *value) { *value = strtoul(text, end, 10); }
+};
+template <>
+struct valueTraits<int32_t> {
+	static int format(char *buffer, int32_t value) { return snprintf(buffer, valueTextSize, "%ld", (long)value); }
+	static void parse(const char *text, char **end, int32_t *value) { *value = strtol(text, end, 10); }
+};
+template <>
+struct valueTraits<int64_t> {
+	static int format(char *buffer, int64_t value) { return snprintf(buffer, valueTextSize, "%lld", (long long)value); }
+	static void parse(const char *text, char **end, int64_t *value) { *value = strtoll(text, end, 10); }
+};
+template <>
+struct valueTraits<uint64_t> {
+	static int format(char *buffer, uint64_t value) { return snprintf(buffer, valueTextSize, "%llu", (unsigned long long)value); }
+	static void parse(const char *text, char **end, uint64_t *value) { *value = strtoull(text, end, 10); }
+};
+template <>
+struct valueTraits<float> {
+	static int format(char *buffer, float value) { return snprintf(buffer, valueTextSize, "%.2f", value); }
+	static void parse(const char *text, char **end, float *value) { *value = strtof(text, end); }
+};
+template <>
+struct valueTraits<double> {
+	static int format(char *buffer, double value) { return snprintf(buffer, valueTextSize, "%.6g", value); }
+	static void parse(const char *text, char **end, double *value) { *value = strtod(text, end); }
+};
+
+// Format a number value
+template <typename T>
+static const char *formatNumber(const apiKeyword *keyword, char *buffer, size_t *length) {
+	*length = clampLength(valueTraits<T>::format(buffer, *(T*)keyword->valuePointer));
+	return buffer;
+}
+
+// Parse text as a number, the whole text must be a number
+template <typename T>
+static bool parseText(const char *text, T *value) {
+	char *end;
+	if (text[0] == '\0') {
+		return false;
+	}
+	valueTraits<T>::parse(text, &end, value);
+	return *end == '\0';
+}
+
+// Store a word-sized value with a single atomic store, so a reader on the other core never sees a torn value
+template <typename T>
+static typename std::enable_if<(sizeof(T) <= sizeof(uint32_t))>::type storeValue(void *target, T value) {
+	__atomic_store((T*)target, &value, __ATOMIC_RELEASE);
+}
+// Store a larger value, with a plain store
+template <typename T>
+static typename std::enable_if<(sizeof(T) > sizeof(uint32_t))>::type storeValue(void *target, T value) {
+	*(T*)target = value;
+}
+
+// Parse a number value into target, only validate it if target is nullptr
+template <typename T>
+static bool parseNumber(const apiKeyword *keyword, const char *text, void *target) {
+	T value;
+	if (!parseText(text, &value)) {
+		return false;
+	}
+	if (target != nullptr) {
+		storeValue<T>(target, value);
+	}
+	return true;
+}
+
+// Check if text is the current number value
+template <typename T>
+static bool equalsNumber(const apiKeyword *keyword, const char *text) {
+	T value;
+	return parseText(text, &value) && value == *(T*)keyword->valuePointer;
+}
+
+// Format a String value, returned without copying
+static const char *formatString(const apiKeyword *keyword, char *buffer, size_t *length) {
+	String *value = (String*)keyword->valuePointer;
+	*length = value->length();
+	return value->c_str();
+}
+
+// Parse a String value
+static bool parseString(const apiKeyword *keyword, const char *text, void *target) {
+	if (target != nullptr) {
+		*(String*)target = text;
+	}
+	return true;
+}
+
+// Check if text is the current String value
+static bool equalsString(const apiKeyword *keyword, const char *text) {
+	return strcmp(((String*)keyword->valuePointer)->c_str(), text) == 0;
+}
+
+// Format a char array value, returned without copying
+static const char *formatChars(const apiKeyword *keyword, char *buffer, size_t *length) {
+	const char *value = (const char*)keyword->valuePointer;
+	*length = strnlen(value, keyword->valueSize);
+	return value;
+}
+
+// Parse a char array value, truncated to fit
+static bool parseChars(const apiKeyword *keyword, const char *text, void *target) {
+	if (target != nullptr) {
+		strlcpy((char*)target, text, keyword->valueSize);
+	}
+	return true;
+}
+
+// Check if text is the current char array value, after truncation
+static bool equalsChars(const apiKeyword *keyword, const char *text) {
+	const char *value = (const char*)keyword->valuePointer;
+	size_t length = strnlen(value, keyword->valueSize);
+	return strncmp(value, text, length) == 0 && (text[length] == '\0' || length == (size_t)keyword->valueSize - 1);
+}
+
+// Read an enum value, as an integer
+static int32_t readEnum(const apiKeyword *keyword) {
+	switch (keyword->valueSize) {
+		case 1: return *(int8_t*)keyword->valuePointer;
+		case 2: return *(int16_t*)keyword->valuePointer;
+		case 4: return *(int32_t*)keyword->valuePointer;
+	}
+	return 0;
+}
+
+// Format an enum value, as its integer value
+static const char *formatEnum(const apiKeyword *keyword, char *buffer, size_t *length) {
+	*length = clampLength(valueTraits<int32_t>::format(buffer, readEnum(keyword)));
+	return buffer;
+}
+
+// Parse an enum value, from its integer value
+static bool parseEnum(const apiKeyword *keyword, const char *text, void *target) {
+	int32_t value;
+	if (!parseText(text, &value)) {
+		return false;
+	}
+	if (keyword->valueSize != 1 && keyword->valueSize != 2 && keyword->valueSize != 4) {
+		return false;
+	}
+	switch (target != nullptr ? keyword->valueSize : 0) {
+		case 1: storeValue<int8_t>(target, value); break;
+		case 2: storeValue<int16_t>(target, value); break;
+		case 4: storeValue<int32_t>(target, value); break;
+	}
+	return true;
+}
+
+// Check if text is the current enum value
+static bool equalsEnum(const apiKeyword *keyword, const char *text) {
+	int32_t value;
+	return parseText(text, &value) && value == readEnum(keyword);
+}
+
+// Text format, parse and compare functions of a value type
+struct valueHandler {
+	const char *(*format)(const apiKeyword *keyword, char *buffer, size_t *length);
+	bool (*parse)(const apiKeyword *keyword, const char *text, void *target);
+	bool (*equals)(const apiKeyword *keyword, const char *text);
+};
+
+// Value handlers, indexed by value type. Generated per type, so no per-call type switch is needed
+static const valueHandler valueHandlers[valueTypeCount] = {
+	{formatNumber<bool>, parseNumber<bool>, equalsNumber<bool>}, // pBOOL
+	{formatNumber<uint32_t>, parseNumber<uint32_t>, equalsNumber<uint32_t>}, // pUINT
+	{formatNumber<int32_t>, parseNumber<int32_t>, equalsNumber<int32_t>}, // pINT
+	{formatNumber<float>, parseNumber<float>, equalsNumber<float>}, // pFLOAT
+	{formatString, parseString, equalsString}, // pSTRING
+	{formatNumber<int64_t>, parseNumber<int64_t>, equalsNumber<int64_t>}, // pINT64
+	{formatNumber<uint64_t>, parseNumber<uint64_t>, equalsNumber<uint64_t>}, // pUINT64
+	{formatNumber<double>, parseNumber<double>, equalsNumber<double>}, // pDOUBLE
+	{formatChars, parseChars, equalsChars}, // pCHARS
+	{formatEnum, parseEnum, equalsEnum} // pENUM
+};
+
+// Append text to out, URL encoding the characters that separate keywords and values
+static void appendEncoded(String *out, const char *text, size_t length) {
+	static const char hex[] = "0123456789ABCDEF";
+	for (size_t i = 0; i < length; i++) {
+		char c = text[i];
+		if (c == '%' || c == '&' || c == '=' || c == '\n' || c == '\r') {
+			*out += '%';
+			*out += hex[(uint8_t)c >> 4];
+			*out += hex[(uint8_t)c & 0x0F];
+		} else {
+			*out += c;
+		}
+	}
+}
+
+// Write value little-endian to buffer, if it fits within size bytes. Returns the length it needs
+static size_t writeLittleEndian(uint8_t *buffer, size_t size, uint64_t value, size_t length) {
+	if (length <= size) {
+		for (size_t i = 0; i < length; i++) {
+			buffer[i] = (uint8_t)(value >> (8 * i));
+		}
+	}
+	return length;
+}
+
+// Read a little-endian value of length bytes
+static uint64_t readLittleEndian(const uint8_t *data, size_t length) {
+	uint64_t value = 0;
+	for (size_t i = 0; i < length; i++) {
+		value |= (uint64_t)data[i] << (8 * i);
+	}
+	return value;
+}
+
 //*************************************************************
 // Public functions
 //*************************************************************
 
 // Constructor
-WebAPI::WebAPI(apiKeyword *apiKeywords, const uint8_t keywords) : _apiKeywords(apiKeywords), _keywords(keywords){}
+WebAPI::WebAPI(apiKeyword *apiKeywords, const uint8_t keywords) : _apiKeywords(apiKeywords), _keywords(keywords){
+	// Build the lookup indexes once, so lookups are O(log n) and allocation free
+	_keywordIndex = new uint8_t[_keywords];
+	_placeholderIndex = new uint8_t[_keywords];
+	buildIndex(_keywordIndex, &apiKeyword::requestKeyword);
+	buildIndex(_placeholderIndex, &apiKeyword::htmlPlaceholder);
+	// Runtime state, nothing has changed yet
+	_states = new keywordState[_keywords];
+	for (uint8_t i = 0; i < _keywords; i++) {
+		_states[i].modified.store(0, std::memory_order_relaxed);
+		_states[i].lastCallback = 0;
+		_states[i].due = 0;
+		_states[i].pending = false;
+		_states[i].dirty = false;
+		_states[i].history = nullptr;
+		_states[i].historySeen = 0;
+		_states[i].changeMin = FLT_MAX;
+		_states[i].changeMax = -FLT_MAX;
+	}
+}
+
+// Destructor
+WebAPI::~WebAPI() {
+	delete[] _keywordIndex;
+	delete[] _placeholderIndex;
+	delete[] _states;
+	delete[] _setQueue;
+}
 
 // Default API request handler
 apiResponse WebAPI::apiHandler(String *requestURL) {
-	#ifdef useVerboseSerial
-		Serial.print("WebAPI::apiHandler(), API request on URL: ");
-		Serial.println(*requestURL);
-	#endif
-	// Get index of equals sign (request to set value)
-	int16_t equalsIndex = requestURL->indexOf("=");
+	valueLock lock(this);
+	char buffer[valueTextSize];
+	apiReply reply = requestHandler(requestURL->c_str(), buffer);
+	// Copy reply text into a response object
+	apiResponse response = {reply.responseCode, String()};
+	response.responseText.concat(reply.text, reply.length);
+	return response;
+}
+
+// Allocation free API request handler
+apiReply WebAPI::requestHandler(const char *request, char *buffer) {
+	webLogDebug("WebAPI::requestHandler(), API request on URL: %s", request);
+	// Find equals sign (request to set value)
+	const char *equals = strchr(request, '=');
 	// Check for request method
-	if (requestURL->indexOf("=") >= 0) {
-		// Get value
-		String value = requestURL->substring(equalsIndex + 1);
-		// Get keyword
-		*requestURL = requestURL->substring(0, equalsIndex);
-		// Set request
-		return apiSet(requestURL, &value);
+	if (equals != nullptr) {
+		// Set request, the value is the rest of the request
+		return apiSet(request, equals - request, equals + 1);
 	} else {
 		// Get request
-		return apiGet(requestURL);
+		return apiGet(request, strlen(request), buffer);
 	}
 }
 
 // Default API based HTML processor
 String WebAPI::htmlProcessor(const String &var) {
-	#ifdef useVerboseSerial
-		Serial.print("WebAPI::htmlProcessor(), Processor on: ");
-		Serial.println(var);
-	#endif
+	webLogDebug("WebAPI::htmlProcessor(), Processor on: %s", var.c_str());
 	// Get index of placeholder in keywords struct array
 	int16_t index = findPlaceholderIndex(var);
 	// Check if keywords was found
 	if (index >= 0) {
-		// Return processed string
-		return processPlaceholderByType(index);
+		// Return value as string
+		valueLock lock(this);
+		char buffer[valueTextSize];
+		size_t length;
+		const char *text = valueText(index, buffer, &length);
+		String value;
+		value.concat(text, length);
+		return value;
 	}
 	// If not found, return empty string object
 	return String();
 }
 
+// Batch request handler
+apiResponse WebAPI::batchHandler(const apiBatchItem *items, uint8_t count) {
+	webLogDebug("WebAPI::batchHandler(), Batch request with items: %u", count);
+	// Keywords set in this batch, callbacks run once for each
+	uint8_t changed[32] = {0};
+	valueLock lock(this);
+	char buffer[valueTextSize];
+	String reply;
+	reply.reserve(count * 16);
+	for (uint8_t i = 0; i < count; i++) {
+		int16_t index = findKeywordIndex(items[i].keyword, strlen(items[i].keyword));
+		reply += items[i].keyword;
+		if (index < 0) {
+			reply += ":404:Not found\n";
+		} else if (items[i].value == nullptr) {
+			// Get request
+			size_t length;
+			const char *text = valueText(index, buffer, &length);
+			reply += ":200:";
+			reply.concat(text, length);
+			reply += "\n";
+		} else {
+			// Set request, callback is deferred to the end of the batch. In deferred mode the set is only queued, and
+			// poll() runs the callbacks of the batch once
+			uint32_t generation = _generation.load(std::memory_order_relaxed);
+			apiReply itemReply = setValueByType(index, items[i].value, false);
+			if (_generation.load(std::memory_order_relaxed) != generation) {
+				changed[index / 8] |= 1 << (index % 8);
+			}
+			reply += ":";
+			reply += itemReply.responseCode;
+			reply += ":";
+			reply.concat(itemReply.text, itemReply.length);
+			reply += "\n";
+		}
+	}
+	// Run each callback once
+	runCallbacks(changed);
+	if (_setQueue != nullptr) {
+		endBatch();
+	}
+	return {200, reply};
+}
+
+// Defer sets to poll()
+void WebAPI::enableDeferredSets(uint8_t queueSize) {
+	if (_setQueue != nullptr || queueSize == 0 || queueSize == 255) {
+		return;
+	}
+	// One slot is kept empty, to tell a full queue from an empty one
+	_setQueueSize = queueSize + 1;
+	_setQueue = new queuedSet[_setQueueSize];
+}
+
+// Apply queued sets and run their callbacks
+uint8_t WebAPI::poll() {
+	uint8_t applied = 0;
+	// Keywords changed by the batch being applied, their callbacks run once after its last set
+	uint8_t changed[32] = {0};
+	bool anyChanged = false;
+	uint8_t tail = _setTail.load(std::memory_order_relaxed);
+	// Acquire pairs with the producer's release, so the slot content is complete. Batches are published whole
+	while (tail != _setHead.load(std::memory_order_acquire)) {
+		queuedSet *set = &_setQueue[tail];
+		// Already validated when queued
+		if (!unchanged(set->index, set->text.c_str())) {
+			writeValue(set->index, set->text.c_str());
+			webLogDebug("WebAPI::poll(), Set keyword index %u to: %s", set->index, set->text.c_str());
+			recordChange(set->index);
+			changed[set->index / 8] |= 1 << (set->index % 8);
+			anyChanged = true;
+		}
+		if (set->endsBatch && anyChanged) {
+			runCallbacks(changed);
+			memset(changed, 0, sizeof(changed));
+			anyChanged = false;
+		}
+		// Hand the slot back to the producer
+		tail = (tail + 1) % _setQueueSize;
+		_setTail.store(tail, std::memory_order_release);
+		applied++;
+	}
+	// Run callbacks held back by a set policy, once due
+	uint32_t now = millis();
+	for (uint8_t i = 0; i < _keywords; i++) {
+		keywordState *state = &_states[i];
+		if (state->pending.load(std::memory_order_acquire) && (int32_t)(now - state->due) >= 0) {
+			state->pending.store(false, std::memory_order_release);
+			state->lastCallback = now;
+			_apiKeywords[i].callback();
+		}
+	}
+	sampleHistories(now);
+	return applied;
+}
+
+// Keep a history of a numeric keyword
+bool WebAPI::addHistory(const char *keyword, WebHistory &history) {
+	int16_t index = findKeywordIndex(keyword, strlen(keyword));
+	float value;
+	if (index < 0 || !numberValue(index, &value)) {
+		return false;
+	}
+	_states[index].history = &history;
+	return true;
+}
+
+// Get the history of keyword
+WebHistory *WebAPI::history(const char *keyword) {
+	int16_t index = findKeywordIndex(keyword, strlen(keyword));
+	return (index < 0) ? nullptr : _states[index].history;
+}
+
+// Number of keywords
+uint8_t WebAPI::keywords() {
+	return _keywords;
+}
+
+// Request keyword of keyword index
+const char *WebAPI::keywordName(uint8_t index) {
+	return _apiKeywords[index].requestKeyword.c_str();
+}
+
+// Change generation
+uint32_t WebAPI::generation() {
+	// Acquire pairs with the release in recordChange(), so the changes up to the generation are seen
+	return _generation.load(std::memory_order_acquire);
+}
+
+// Generation of the last change of keyword index
+uint32_t WebAPI::modifiedGeneration(uint8_t index) {
+	return _states[index].modified.load(std::memory_order_acquire);
+}
+
+// All keywords, as URL encoded "keyword=value&keyword=value"
+String WebAPI::allValues() {
+	String values;
+	for (uint8_t i = 0; i < _keywords; i++) {
+		appendValue(&values, i);
+	}
+	return values;
+}
+
+// Keywords changed after generation since, as URL encoded "keyword=value&keyword=value"
+String WebAPI::changedValues(uint32_t since) {
+	// Generation 0 is before the first set, so every keyword is new to the client
+	if (since == 0) {
+		return allValues();
+	}
+	String values;
+	// Nothing changed, skip the scan
+	if (since >= _generation.load(std::memory_order_acquire)) {
+		return values;
+	}
+	for (uint8_t i = 0; i < _keywords; i++) {
+		if (_states[i].modified.load(std::memory_order_acquire) > since) {
+			appendValue(&values, i);
+		}
+	}
+	return values;
+}
+
+// Add the keywords changed after generation since to set
+void WebAPI::changedKeywords(uint32_t since, keywordSet *set) {
+	if (since >= _generation.load(std::memory_order_acquire)) {
+		return;
+	}
+	for (uint8_t i = 0; i < _keywords; i++) {
+		if (_states[i].modified.load(std::memory_order_acquire) > since) {
+			set->words[i / 32] |= 1UL << (i % 32);
+		}
+	}
+}
+
+// Add the keywords matching pattern to set
+uint8_t WebAPI::matchKeywords(const char *pattern, size_t length, keywordSet *set) {
+	bool prefix = length > 0 && pattern[length - 1] == '*';
+	if (!prefix) {
+		int16_t index = findKeywordIndex(pattern, length);
+		if (index < 0) {
+			return 0;
+		}
+		set->words[index / 32] |= 1UL << (index % 32);
+		return 1;
+	}
+	// Prefix group, matched on the request keywords
+	uint8_t matches = 0;
+	for (uint8_t i = 0; i < _keywords; i++) {
+		if (strncmp(_apiKeywords[i].requestKeyword.c_str(), pattern, length - 1) == 0) {
+			set->words[i / 32] |= 1UL << (i % 32);
+			matches++;
+		}
+	}
+	return matches;
+}
+
+// Keywords in set, as URL encoded "keyword=value&keyword=value"
+String WebAPI::selectedValues(const keywordSet *set) {
+	String values;
+	// Only the set bits are visited
+	for (uint8_t word = 0; word < keywordSetWords; word++) {
+		uint32_t bits = set->words[word];
+		while (bits != 0) {
+			uint8_t index = word * 32 + __builtin_ctz(bits);
+			bits &= bits - 1;
+			if (index < _keywords) {
+				appendValue(&values, index);
+			}
+		}
+	}
+	return values;
+}
+
+// Binary frame of keyword values
+size_t WebAPI::binaryValues(const uint8_t *ids, uint8_t count, uint8_t *buffer, size_t size) {
+	uint8_t items = (count == 0) ? _keywords : count;
+	size_t length = writeLittleEndian(buffer, size, _generation.load(std::memory_order_acquire), 4);
+	length += writeLittleEndian(buffer + length, (length < size) ? size - length : 0, items, 1);
+	for (uint8_t i = 0; i < items; i++) {
+		uint8_t id = (count == 0) ? i : ids[i];
+		bool known = id < _keywords && _apiKeywords[id].valueType < valueTypeCount;
+		length += writeLittleEndian(buffer + length, (length < size) ? size - length : 0, id, 1);
+		length += writeLittleEndian(buffer + length, (length < size) ? size - length : 0, known ? _apiKeywords[id].valueType : binaryUnknownType, 1);
+		if (known) {
+			length += binaryValue(id, buffer + length, (length < size) ? size - length : 0);
+		}
+	}
+	return length;
+}
+
+// Schema of the binary frame
+String WebAPI::binarySchema() {
+	String schema;
+	schema.reserve(_keywords * 16);
+	for (uint8_t i = 0; i < _keywords; i++) {
+		schema += i;
+		schema += ' ';
+		schema += _apiKeywords[i].valueType;
+		schema += ' ';
+		schema += _apiKeywords[i].requestKeyword;
+		schema += '\n';
+	}
+	return schema;
+}
+
+// Find index of HTML placeholder, from a (non null terminated) name
+int16_t WebAPI::placeholderIndex(const char *placeholder, size_t length) {
+	return searchIndex(_placeholderIndex, &apiKeyword::htmlPlaceholder, placeholder, length);
+}
+
+// Get value of keyword as text, numbers are formatted into buffer, strings are returned without copying
+const char *WebAPI::valueText(uint8_t index, char *buffer, size_t *length) {
+	const apiKeyword *keyword = &_apiKeywords[index];
+	if (keyword->valueType >= valueTypeCount) {
+		*length = 0;
+		return "";
+	}
+	return valueHandlers[keyword->valueType].format(keyword, buffer, length);
+}
+
+// Lock String and char array values
+void WebAPI::lockValues() {
+	_valueLock.lock();
+}
+
+// Unlock String and char array values
+void WebAPI::unlockValues() {
+	_valueLock.unlock();
+}
+
 //*************************************************************
 // Private functions
 //*************************************************************
 
 // GET responder
-apiResponse WebAPI::apiGet(String *keyword) {
+apiReply WebAPI::apiGet(const char *keyword, size_t length, char *buffer) {
 	// Get index of keyword in keywords struct array
-	int16_t index = findKeywordIndex(keyword);
+	int16_t index = findKeywordIndex(keyword, length);
 	// Check if keywords was found
 	if (index >= 0) {
-		#ifdef useVerboseSerial
-			apiResponse reply = getValueByType(index);
-			Serial.print("WebAPI::apiGet(), Reply code: ");
-			Serial.print(reply.responseCode);
-			Serial.print(" , with reply: ");
-			Serial.println(reply.responseText);
-			return reply;
-		#else
-			// Get value by type
-			return getValueByType(index);
-		#endif
+		// Get value as text
+		apiReply reply = {200, nullptr, 0};
+		reply.text = valueText(index, buffer, &reply.length);
+		webLogDebug("WebAPI::apiGet(), Reply code: %u , with reply: %.*s", reply.responseCode, (int)reply.length, reply.text);
+		return reply;
 	}
 	// If not found, return error code
-	return {404, "Not found"};
+	return replyNotFound;
 }
 
 // POST responde
-apiResponse WebAPI::apiSet(String *keyword, String *value) {
+apiReply WebAPI::apiSet(const char *keyword, size_t length, const char *value) {
 	// Get index of keyword in keywords struct array
-	int16_t index = findKeywordIndex(keyword);
+	int16_t index = findKeywordIndex(keyword, length);
 	// Check if keywords was found
 	if (index >= 0) {
-		#ifdef useVerboseSerial
-			apiResponse reply = setValueByType(index, value);
-			Serial.print("WebAPI::apiSet(), Reply code: ");
-			Serial.print(reply.responseCode);
-			Serial.print(" , with reply: ");
-			Serial.println(reply.responseText);
-			return reply;
-		#else
-			// Set value by type
-			return setValueByType(index, value);
-		#endif
+		// Set value by type
+		apiReply reply = setValueByType(index, value);
+		webLogDebug("WebAPI::apiSet(), Reply code: %u , with reply: %s", reply.responseCode, reply.text);
+		return reply;
 	}
 	// If not found, return error code
-	return {404, "Not found"};
+	return replyNotFound;
 }
 
-// Find keyword in keywords list
-int16_t WebAPI::findKeywordIndex(String *keyword) {
-	#ifdef useVerboseSerial
-		Serial.print("WebAPI::findKeywordIndex(), Looking for keyword: ");
-		Serial.println(*keyword);
-	#endif
-	// Loop through all API keywords
+// Build lookup index, sorted by the given keyword field
+void WebAPI::buildIndex(uint8_t *index, String apiKeyword::*field) {
+	// Insertion sort, only run once at construction
 	for (uint8_t i = 0; i < _keywords; i++) {
-		// Check if keywords is in requestURL
-		if (keyword->indexOf(_apiKeywords[i].requestKeyword) >= 0) {
-			#ifdef useVerboseSerial
-				Serial.print("WebAPI::findKeywordIndex(), Found keyword with index: ");
-				Serial.println(i);
-			#endif
-			return i;
+		uint8_t j = i;
+		while (j > 0 && (_apiKeywords[index[j - 1]].*field).compareTo(_apiKeywords[i].*field) > 0) {
+			index[j] = index[j - 1];
+			j--;
+		}
+		index[j] = i;
+	}
+}
+
+// Binary search lookup index for an exact match of name
+int16_t WebAPI::searchIndex(const uint8_t *index, String apiKeyword::*field, const char *name, size_t length) {
+	int16_t low = 0;
+	int16_t high = (int16_t)_keywords - 1;
+	while (low <= high) {
+		int16_t middle = (low + high) / 2;
+		int result = compareName(name, length, _apiKeywords[index[middle]].*field);
+		if (result == 0) {
+			return index[middle];
+		} else if (result < 0) {
+			high = middle - 1;
+		} else {
+			low = middle + 1;
 		}
 	}
-	#ifdef useVerboseSerial
-		Serial.println("WebAPI::findKeywordIndex(), Keyword not found.");
-	#endif
 	// If not found return -1
 	return -1;
 }
 
+// Find keyword in keywords list, from a (non null terminated) name
+int16_t WebAPI::findKeywordIndex(const char *keyword, size_t length) {
+	// Exact match lookup in the sorted keyword index
+	int16_t index = searchIndex(_keywordIndex, &apiKeyword::requestKeyword, keyword, length);
+	webLogDebug("WebAPI::findKeywordIndex(), Keyword %.*s has index: %d", (int)length, keyword, index);
+	return index;
+}
+
 // Find htmlPlaceholder in keywords list
 int16_t WebAPI::findPlaceholderIndex(const String &placeholder) {
-	#ifdef useVerboseSerial
-		Serial.print("WebAPI::findPlaceholderIndex(), Looking for HTML placeholder: ");
-		Serial.println(placeholder);
-	#endif
-	// Loop through all API keywords
-	for (uint8_t i = 0; i < _keywords; i++) {
-		// Check if placeholder is in requestURL
-		if (placeholder.indexOf(_apiKeywords[i].htmlPlaceholder) >= 0) {
-			#ifdef useVerboseSerial
-				Serial.print("WebAPI::findPlaceholderIndex(), Found HTML placeholder with index: ");
-				Serial.print(i);
-				Serial.print(" , and value: ");
-				switch (_apiKeywords[i].valueType) {
-					case pBOOL: {
-						Serial.println(String(*(bool*)_apiKeywords[i].valuePointer));
-					} break;
-					case pUINT: {
-						Serial.println(String(*(uint32_t*)_apiKeywords[i].valuePointer));
-					} break;
-					case pINT: {
-						Serial.println(String(*(int32_t*)_apiKeywords[i].valuePointer));
-					} break;
-					case pFLOAT: {
-						Serial.println(String(*(float*)_apiKeywords[i].valuePointer));
-					} break;
-					case pSTRING: {
-						Serial.println(String(*(String*)_apiKeywords[i].valuePointer));
-					} break;
-					/*
-					case FLOAT: {
-						Serial.println(String(_apiKeywords[i].keyValue.floatValue));
-					} break;
-					case INT: {
-						Serial.println(String(_apiKeywords[i].keyValue.intValue));
-					} break;
-					case UINT: {
-						Serial.println(String(_apiKeywords[i].keyValue.uintValue));
-					} break;
-					case CHARA: {
-						Serial.println(String(_apiKeywords[i].keyValue.charArrayValue));
-					} break;
-					case BOOL: {
-						Serial.println(String(_apiKeywords[i].keyValue.boolValue));
-					} break;
-					*/
-				}
-			#endif
-			return i;
+	// Exact match lookup in the sorted placeholder index
+	int16_t i = searchIndex(_placeholderIndex, &apiKeyword::htmlPlaceholder, placeholder.c_str(), placeholder.length());
+	webLogDebug("WebAPI::findPlaceholderIndex(), HTML placeholder %s has index: %d", placeholder.c_str(), i);
+	return i;
+}
+
+// Write the binary value of keyword index to buffer
+size_t WebAPI::binaryValue(uint8_t index, uint8_t *buffer, size_t size) {
+	const apiKeyword *keyword = &_apiKeywords[index];
+	void *value = keyword->valuePointer;
+	switch (keyword->valueType) {
+		case pBOOL: return writeLittleEndian(buffer, size, *(bool*)value, 1);
+		case pUINT: return writeLittleEndian(buffer, size, *(uint32_t*)value, 4);
+		case pINT: return writeLittleEndian(buffer, size, (uint32_t)*(int32_t*)value, 4);
+		case pINT64: return writeLittleEndian(buffer, size, (uint64_t)*(int64_t*)value, 8);
+		case pUINT64: return writeLittleEndian(buffer, size, *(uint64_t*)value, 8);
+		case pFLOAT: {
+			uint32_t bits;
+			memcpy(&bits, value, 4);
+			return writeLittleEndian(buffer, size, bits, 4);
+		}
+		case pDOUBLE: {
+			uint64_t bits;
+			memcpy(&bits, value, 8);
+			return writeLittleEndian(buffer, size, bits, 8);
+		}
+		case pENUM: return writeLittleEndian(buffer, size, (uint32_t)readEnum(keyword), 4);
+		case pSTRING:
+		case pCHARS: {
+			valueLock lock(this);
+			char text[valueTextSize];
+			size_t length;
+			const char *chars = valueText(index, text, &length);
+			if (length > 0xFFFF) {
+				length = 0xFFFF;
+			}
+			if (length + 2 <= size) {
+				writeLittleEndian(buffer, size, length, 2);
+				memcpy(buffer + 2, chars, length);
+			}
+			return length + 2;
 		}
 	}
-	#ifdef useVerboseSerial
-		Serial.println("WebAPI::findPlaceholderIndex(), HTML placeholder not found.");
-	#endif
-	// If not found return -1
-	return -1;
+	return 0;
 }
 
-// Get value, based on type
-apiResponse WebAPI::getValueByType(uint8_t index) {
-	switch (_apiKeywords[index].valueType) {
-		case pBOOL: {
-			return {200, String(*(bool*)_apiKeywords[index].valuePointer)};
-		} break;
-		case pUINT: {
-			return {200, String(*(uint32_t*)_apiKeywords[index].valuePointer)};
-		} break;
-		case pINT: {
-			return {200, String(*(int32_t*)_apiKeywords[index].valuePointer)};
-		} break;
+// Set keyword index from its binary value
+bool WebAPI::setBinaryValue(uint8_t index, const uint8_t *data, size_t length) {
+	const apiKeyword *keyword = &_apiKeywords[index];
+	void *value = keyword->valuePointer;
+	// Numbers have a fixed length, strings an uint16 length before the text
+	size_t expected = 0;
+	switch (keyword->valueType) {
+		case pBOOL: expected = 1; break;
+		case pUINT: case pINT: case pFLOAT: case pENUM: expected = 4; break;
+		case pINT64: case pUINT64: case pDOUBLE: expected = 8; break;
+		case pSTRING: case pCHARS: expected = (length >= 2) ? readLittleEndian(data, 2) + 2 : 2; break;
+	}
+	if (expected == 0 || length != expected) {
+		return false;
+	}
+	uint64_t bits = (keyword->valueType == pSTRING || keyword->valueType == pCHARS) ? 0 : readLittleEndian(data, length);
+	switch (keyword->valueType) {
+		case pBOOL: storeValue<bool>(value, bits != 0); break;
+		case pUINT: case pINT: storeValue<uint32_t>(value, bits); break;
+		case pINT64: case pUINT64: storeValue<uint64_t>(value, bits); break;
 		case pFLOAT: {
-			return {200, String(*(float*)_apiKeywords[index].valuePointer)};
-		} break;
-		case pSTRING: {
-			return {200, String(*(String*)_apiKeywords[index].valuePointer)};
+			uint32_t word = bits;
+			float number;
+			memcpy(&number, &word, 4);
+			storeValue<float>(value, number);
 		} break;
-		/*
-		case FLOAT: {
-			return {200, String(_apiKeywords[index].keyValue.floatValue)};
+		case pDOUBLE: {
+			double number;
+			memcpy(&number, &bits, 8);
+			storeValue<double>(value, number);
 		} break;
-		case INT: {
-			return {200, String(_apiKeywords[index].keyValue.intValue)};
+		case pENUM: {
+			int32_t number = (int32_t)bits;
+			switch (keyword->valueSize) {
+				case 1: storeValue<int8_t>(value, number); break;
+				case 2: storeValue<int16_t>(value, number); break;
+				case 4: storeValue<int32_t>(value, number); break;
+				default: return false;
+			}
 		} break;
-		case UINT: {
-			return {200, String(_apiKeywords[index].keyValue.uintValue)};
+		case pSTRING:
+		case pCHARS: {
+			// Copied through a terminated buffer, as the stored text is not null terminated
+			char *text = (char*)malloc(length - 1);
+			if (text == nullptr) {
+				return false;
+			}
+			memcpy(text, data + 2, length - 2);
+			text[length - 2] = '\0';
+			writeValue(index, text);
+			free(text);
 		} break;
-		case CHARA: {
-			return {200, String(_apiKeywords[index].keyValue.charArrayValue)};
-		} break;
-		case BOOL: {
-			return {200, String(_apiKeywords[index].keyValue.boolValue)};
-		} break;
-		*/
 	}
-	// If not found, return error code
-	return {404, "Not found"};
+	return true;
 }
 
-// Set value, based on type
-apiResponse WebAPI::setValueByType(uint8_t index, String *value) {
-	// Prepare response
-	apiResponse reply;
-	// Check value type
-	switch (_apiKeywords[index].valueType) {
-		case pBOOL: {
-			// Convert value to float
-			*(bool*)_apiKeywords[index].valuePointer = (bool)value->toInt();
-			reply = {200, "Ok"};
-		} break;
-		case pUINT: {
-			// Convert value to int64, cast to int32
-			*(uint32_t*)_apiKeywords[index].valuePointer = (int32_t)value->toInt();
-			reply = {200, "Ok"};
-		} break;
-		case pINT: {
-			// Convert value to int64, cast to uint32
-			*(int32_t*)_apiKeywords[index].valuePointer = (uint32_t)value->toInt();
-			reply = {200, "Ok"};
-		} break;
-		case pFLOAT: {
-			// Convert value to int64, cast to bool
-			*(float*)_apiKeywords[index].valuePointer = value->toFloat();
-			reply = {200, "Ok"};
-		} break;
-		case pSTRING: {
-			// Save string to string
-			*(String*)_apiKeywords[index].valuePointer = *value;
-			reply = {200, "Ok"};
-		} break;
-		/*
-		case FLOAT: {
-			// Convert value to float
-			_apiKeywords[index].keyValue.floatValue = value->toFloat();
-			reply = {200, "Ok"};
-		} break;
-		case INT: {
-			// Convert value to int64, cast to int32
-			_apiKeywords[index].keyValue.intValue = (int32_t)value->toInt();
-			reply = {200, "Ok"};
-		} break;
-		case UINT: {
-			// Convert value to int64, cast to uint32
-			_apiKeywords[index].keyValue.uintValue = (uint32_t)value->toInt();
-			reply = {200, "Ok"};
-		} break;
-		case CHARA: {
-			// Write stirng to char buffer
-			value->toCharArray(_apiKeywords[index].keyValue.charArrayValue, charArraySize);
-			reply = {200, "Ok"};
-		} break;
-		case BOOL: {
-			// Convert value to int64, cast to bool
-			_apiKeywords[index].keyValue.boolValue = (bool)value->toInt();
-			reply = {200, "Ok"};
-		} break;
-		default: {
-			reply = {404, "Not found"};
+// Append "keyword=value" of keyword index to values
+void WebAPI::appendValue(String *values, uint8_t index) {
+	valueLock lock(this);
+	char buffer[valueTextSize];
+	size_t length;
+	const char *text = valueText(index, buffer, &length);
+	if (values->length() > 0) {
+		*values += '&';
+	}
+	*values += _apiKeywords[index].requestKeyword;
+	*values += '=';
+	appendEncoded(values, text, length);
+}
+
+// Get the value of a number keyword as float
+bool WebAPI::numberValue(uint8_t index, float *value) {
+	const apiKeyword *keyword = &_apiKeywords[index];
+	switch (keyword->valueType) {
+		case pBOOL: *value = *(bool*)keyword->valuePointer; break;
+		case pUINT: *value = *(uint32_t*)keyword->valuePointer; break;
+		case pINT: *value = *(int32_t*)keyword->valuePointer; break;
+		case pFLOAT: *value = *(float*)keyword->valuePointer; break;
+		case pINT64: *value = *(int64_t*)keyword->valuePointer; break;
+		case pUINT64: *value = *(uint64_t*)keyword->valuePointer; break;
+		case pDOUBLE: *value = *(double*)keyword->valuePointer; break;
+		case pENUM: *value = readEnum(keyword); break;
+		default: return false;
+	}
+	return true;
+}
+
+// Sample the keyword histories
+void WebAPI::sampleHistories(uint32_t now) {
+	for (uint8_t i = 0; i < _keywords; i++) {
+		keywordState *state = &_states[i];
+		if (state->history == nullptr) {
+			continue;
+		}
+		state->history->advance(now);
+		// Each slot starts with the current value, on change histories also take every change
+		uint32_t modified = state->modified.load(std::memory_order_acquire);
+		bool changed = modified != state->historySeen;
+		if (state->history->wantsSample() || (changed && state->history->mode() == historyOnChange)) {
+			float value;
+			numberValue(i, &value);
+			state->history->sample(value, now);
+			state->historySeen = modified;
+		}
+		// Values set and overwritten between two polls still count for the slot minimum and maximum
+		if (state->history->mode() == historyOnChange) {
+			float low = state->changeMin.exchange(FLT_MAX, std::memory_order_relaxed);
+			float high = state->changeMax.exchange(-FLT_MAX, std::memory_order_relaxed);
+			if (low <= high) {
+				state->history->widen(low, high);
+			}
 		}
-		*/
 	}
-	#ifdef useVerboseSerial
-		if (reply.responseCode != 404 && _apiKeywords[index].callback != nullptr) {
-			Serial.println("WebAPI::setValueByType(), Running onChange callback");
-		} else {
-			Serial.println("WebAPI::setValueByType(), No (or invalid) callback given");
+}
+
+// Set value, based on type
+apiReply WebAPI::setValueByType(uint8_t index, const char *value, bool runCallback) {
+	const apiKeyword *keyword = &_apiKeywords[index];
+	// Unknown types are not found
+	if (keyword->valueType >= valueTypeCount) {
+		return replyNotFound;
+	}
+	// In deferred mode the value is validated, and applied by poll()
+	if (_setQueue != nullptr) {
+		if (!valueHandlers[keyword->valueType].parse(keyword, value, nullptr)) {
+			return replyBadValue;
 		}
-	#endif
-	if (reply.responseCode != 404 && _apiKeywords[index].callback != nullptr) {
-		_apiKeywords[index].callback();
+		return queueSet(index, value, runCallback);
 	}
-	// If not found, return error code
-	return reply;
+	// Sets of the current value are skipped, if the policy says so
+	if (unchanged(index, value)) {
+		return replyOk;
+	}
+	// Values that do not parse as the keyword type are rejected
+	if (!writeValue(index, value)) {
+		return replyBadValue;
+	}
+	webLogDebug("WebAPI::setValueByType(), Set keyword index %u to: %s", index, value);
+	recordChange(index);
+	if (runCallback) {
+		this->runCallback(index);
+	}
+	return replyOk;
 }
 
-// Process placeholder by type
-String WebAPI::processPlaceholderByType(uint8_t index) {
-	switch (_apiKeywords[index].valueType) {
-		case pBOOL: {
-			return String(*(bool*)_apiKeywords[index].valuePointer);
-		} break;
-		case pUINT: {
-			return String(*(uint32_t*)_apiKeywords[index].valuePointer);
-		} break;
-		case pINT: {
-			return String(*(int32_t*)_apiKeywords[index].valuePointer);
-		} break;
-		case pFLOAT: {
-			return String(*(float*)_apiKeywords[index].valuePointer);
-		} break;
-		case pSTRING: {
-			return String(*(String*)_apiKeywords[index].valuePointer);
-		} break;
-		/*
-		case FLOAT: {
-			return String(_apiKeywords[index].keyValue.floatValue);
-		} break;
-		case INT: {
-			return String(_apiKeywords[index].keyValue.intValue);
-		} break;
-		case UINT: {
-			return String(_apiKeywords[index].keyValue.uintValue);
-		} break;
-		case CHARA: {
-			return String(_apiKeywords[index].keyValue.charArrayValue);
-		} break;
-		case BOOL: {
-			return String(_apiKeywords[index].keyValue.boolValue);
-		} break;
-		*/
+// Queue a validated set for poll()
+apiReply WebAPI::queueSet(uint8_t index, const char *value, bool endsBatch) {
+	uint8_t head = _setNext;
+	uint8_t next = (head + 1) % _setQueueSize;
+	// Acquire pairs with the consumer's release, so the slot is no longer read
+	if (next == _setTail.load(std::memory_order_acquire)) {
+		webLogError("WebAPI::queueSet(), Set queue full, dropped set of keyword index %u", index);
+		return replyBusy;
+	}
+	// The slot text keeps its buffer between sets, so it only allocates to grow
+	_setQueue[head].index = index;
+	_setQueue[head].text = value;
+	_setQueue[head].endsBatch = endsBatch;
+	_setNext = next;
+	if (endsBatch) {
+		_setHead.store(next, std::memory_order_release);
+	}
+	return replyOk;
+}
+
+// Hand the sets queued by a batch to poll()
+void WebAPI::endBatch() {
+	if (_setNext == _setHead.load(std::memory_order_relaxed)) {
+		return;
+	}
+	// The last set is not visible to poll() yet, so it can still be marked
+	_setQueue[(_setNext + _setQueueSize - 1) % _setQueueSize].endsBatch = true;
+	_setHead.store(_setNext, std::memory_order_release);
+}
+
+// Check if value is the current value of a setOnChange keyword
+bool WebAPI::unchanged(uint8_t index, const char *value) {
+	const apiKeyword *keyword = &_apiKeywords[index];
+	if (keyword->policy != setOnChange) {
+		return false;
+	}
+	valueLock lock(this);
+	return valueHandlers[keyword->valueType].equals(keyword, value);
+}
+
+// Parse text into the variable of keyword index
+bool WebAPI::writeValue(uint8_t index, const char *text) {
+	const apiKeyword *keyword = &_apiKeywords[index];
+	// Numbers are written with single stores, strings reallocate their buffer
+	if (keyword->valueType != pSTRING && keyword->valueType != pCHARS) {
+		return valueHandlers[keyword->valueType].parse(keyword, text, keyword->valuePointer);
+	}
+	valueLock lock(this);
+	return valueHandlers[keyword->valueType].parse(keyword, text, keyword->valuePointer);
+}
+
+// Record a change of keyword index
+void WebAPI::recordChange(uint8_t index) {
+	// Sets on the web server task and poll() are serialized by the lock, so generations only grow. The keyword
+	// generation is stored before the API generation is published, with release after the value write, so a push that
+	// reads the generation first and then scans for newer keywords never skips a change
+	{
+		valueLock lock(this);
+		uint32_t generation = _generation.load(std::memory_order_relaxed) + 1;
+		_states[index].modified.store(generation, std::memory_order_release);
+		_generation.store(generation, std::memory_order_release);
+	}
+	// Persistent values are stored in batches by WebStore
+	if (_apiKeywords[index].persistent) {
+		_persistentChanges++;
+		_states[index].dirty.store(true, std::memory_order_release);
+	}
+	// On change histories keep the range of values set until poll() samples them
+	WebHistory *history = _states[index].history;
+	if (history != nullptr && history->mode() == historyOnChange) {
+		float value;
+		numberValue(index, &value);
+		float low = _states[index].changeMin.load(std::memory_order_relaxed);
+		while (value < low && !_states[index].changeMin.compare_exchange_weak(low, value, std::memory_order_relaxed)) {}
+		float high = _states[index].changeMax.load(std::memory_order_relaxed);
+		while (value > high && !_states[index].changeMax.compare_exchange_weak(high, value, std::memory_order_relaxed)) {}
+	}
+}
+
+// Run the callback of keyword index, or hold it back as its set policy says
+void WebAPI::runCallback(uint8_t index) {
+	const apiKeyword *keyword = &_apiKeywords[index];
+	keywordState *state = &_states[index];
+	if (keyword->callback == nullptr) {
+		return;
+	}
+	uint32_t now = millis();
+	switch (keyword->policy) {
+		case setMinInterval:
+			// Due at once if the interval has passed, else once it has. Run by poll(), so the callback never runs on two tasks at once
+			if (!state->pending.load(std::memory_order_acquire)) {
+				state->due = (now - state->lastCallback < keyword->policyInterval) ? state->lastCallback + keyword->policyInterval : now;
+				state->pending.store(true, std::memory_order_release);
+			}
+			return;
+		case setWindow:
+			// The first set opens the window, later sets only write the value
+			if (!state->pending.load(std::memory_order_acquire)) {
+				state->due = now + keyword->policyInterval;
+				state->pending.store(true, std::memory_order_release);
+			}
+			return;
+	}
+	state->lastCallback = now;
+	keyword->callback();
+}
+
+// Run the callback of each keyword marked in changed
+void WebAPI::runCallbacks(const uint8_t *changed) {
+	for (uint16_t index = 0; index < _keywords; index++) {
+		if (changed[index / 8] & (1 << (index % 8))) {
+			runCallback(index);
+		}
 	}
-	// If not found, return empty string object
-	return String();
 }
\ No newline at end of file
@@ -33,9 +33,12 @@
 #define _WebAPI_
 
 #include "Arduino.h"
-#include "ESPAsyncWebServer.h"
-
-#define useVerboseSerial true
+#include "WebLog.h"
+#include "WebHistory.h"
+#include <type_traits>
+#include <atomic>
+#include <cfloat>
+#include <mutex>
 
 // State types for the API manager
 typedef enum {
@@ -43,11 +46,25 @@ typedef enum {
 	pUINT,
 	pINT,
 	pFLOAT,
-	pSTRING
+	pSTRING,
+	pINT64,
+	pUINT64,
+	pDOUBLE,
+	pCHARS, // Fixed-size, null terminated char array
+	pENUM, // Enum, handled as an integer of valueSize bytes
+	valueTypeCount
 } valueTypes; 
 
-// Char array size
-#define charArraySize 4
+// Buffer size needed to format any number type as text
+#define valueTextSize 48
+
+// Policies for how sets of a keyword are coalesced, to bound the rate of callbacks
+typedef enum {
+	setAlways, // Every set writes the value and runs the callback
+	setOnChange, // Sets of the current value are skipped
+	setMinInterval, // The callback runs at most once per interval, from poll(). A set within the interval runs it when the interval ends
+	setWindow // The first set opens a window of interval, the callback runs once when it closes, with the last value written
+} setPolicies;
 
 // Callback function to use when variable changes
 typedef void (*onSetCallback)();
@@ -58,16 +75,83 @@ struct apiKeyword {
 	String htmlPlaceholder; // HTML placeholder to search for
 	uint8_t valueType; // The type of value that the keyword codes for 
 	void *valuePointer;
-	/*
-	union {
-		float_t floatValue;
-		int32_t intValue;
-		uint32_t uintValue;
-		char charArrayValue[charArraySize];
-		bool boolValue;
-	} keyValue;
-	*/
 	onSetCallback callback; // Function pointer to call on 
+	uint16_t valueSize; // Size of the value in bytes, needed for pCHARS and pENUM (set by bindKeyword)
+	uint8_t policy; // Set policy (setPolicies), setAlways if not given
+	uint16_t policyInterval; // Interval of setMinInterval and setWindow, in ms
+	bool persistent; // Value is stored in flash and restored at startup (see WebStore), false if not given
+};
+
+// Maps a variable type to its value type. Types without a mapping do not compile with bindKeyword
+template <typename T, typename Enable = void>
+struct keywordType;
+template <>
+struct keywordType<bool> { static const uint8_t type = pBOOL; };
+template <>
+struct keywordType<float> { static const uint8_t type = pFLOAT; };
+template <>
+struct keywordType<double> { static const uint8_t type = pDOUBLE; };
+template <>
+struct keywordType<String> { static const uint8_t type = pSTRING; };
+template <typename T>
+struct keywordType<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+	static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Only 32 and 64 bit integers can be bound to a keyword");
+	static const uint8_t type = (sizeof(T) == 8) ? (std::is_signed<T>::value ? pINT64 : pUINT64) : (std::is_signed<T>::value ? pINT : pUINT);
+};
+template <typename T>
+struct keywordType<T, typename std::enable_if<std::is_enum<T>::value>::type> {
+	static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4, "Enums bound to a keyword must be 1, 2 or 4 bytes");
+	static const uint8_t type = pENUM;
+};
+
+// Bind a variable to a keyword, the value type is taken from the variable type
+template <typename T>
+apiKeyword bindKeyword(const char *requestKeyword, const char *htmlPlaceholder, T &value, onSetCallback callback = nullptr, uint8_t policy = setAlways, uint16_t policyInterval = 0) {
+	return {requestKeyword, htmlPlaceholder, keywordType<T>::type, (void*)&value, callback, sizeof(T), policy, policyInterval};
+}
+
+// Bind a fixed-size char array to a keyword, set values are truncated to fit
+template <size_t N>
+apiKeyword bindKeyword(const char *requestKeyword, const char *htmlPlaceholder, char (&value)[N], onSetCallback callback = nullptr, uint8_t policy = setAlways, uint16_t policyInterval = 0) {
+	static_assert(N > 1 && N <= 65535, "Char arrays bound to a keyword must hold 2 to 65535 bytes");
+	return {requestKeyword, htmlPlaceholder, pCHARS, (void*)value, callback, N, policy, policyInterval};
+}
+
+// Default number of sets that can wait for poll(), in deferred mode
+#define defaultSetQueueSize 16
+
+// A set waiting to be applied by poll(), in deferred mode
+struct queuedSet {
+	uint8_t index; // Keyword index
+	String text; // Value text, already validated. Reused between sets, so it only allocates to grow
+	bool endsBatch; // Last set of its batch (or a single set), callbacks of the batch run after it
+};
+
+// Words in a keyword set, one bit for each of up to 256 keywords
+#define keywordSetWords 8
+
+// Set of keyword indexes, one bit per keyword
+struct keywordSet {
+	uint32_t words[keywordSetWords];
+};
+
+// Mark a keyword as persistent, e.g. persistentKeyword(bindKeyword("LED1State", "LED1STATE", bLED1State))
+inline apiKeyword persistentKeyword(apiKeyword keyword) {
+	keyword.persistent = true;
+	return keyword;
+}
+
+// Runtime state kept per keyword
+struct keywordState {
+	std::atomic<uint32_t> modified; // Generation of the last change, stored before the API generation is published
+	uint32_t lastCallback; // Time the callback last ran, in ms
+	uint32_t due; // Time a pending callback is due, in ms
+	std::atomic<bool> pending; // A callback is waiting for its interval or window to end, run by poll()
+	std::atomic<bool> dirty; // Persistent value changed since it was last stored
+	WebHistory *history; // History of the value, nullptr if none
+	uint32_t historySeen; // Generation last sampled into the history
+	std::atomic<float> changeMin; // Lowest value set since the last sample, of on change histories
+	std::atomic<float> changeMax; // Highest value set since the last sample, of on change histories
 };
 
 // API request response struct
@@ -76,7 +160,36 @@ struct apiResponse {
 	String responseText;
 };
 
+// Allocation free API request reply
+struct apiReply {
+	uint16_t responseCode;
+	const char *text; // Reply text, in the caller's buffer, a static string or the value string
+	size_t length; // Length of reply text
+};
+
+// Keyword of the schema request on a binary API, /bin/schema
+#define apiSchemaKeyword "schema"
+// Binary value type of an unknown keyword id, sent without a value
+#define binaryUnknownType 0xFF
+
+// Keyword for snapshot requests, /api/snapshot?since=42. ETag is the change generation
+#define apiSnapshotKeyword "snapshot"
+
+// Keyword for batch requests, /api/batch?A&B=3&C
+#define apiBatchKeyword "batch"
+
+// Keyword for history requests, /api/history?keyword=Temp&window=3600&points=60 (window in s)
+#define apiHistoryKeyword "history"
+
+// A single get (value is nullptr) or set, in a batch request
+struct apiBatchItem {
+	const char *keyword;
+	const char *value;
+};
+
 class WebAPI {
+	friend class WebStore;
+
 	public:
 		// Constructor
 		WebAPI(apiKeyword *apiKeywords, const uint8_t keywords);
@@ -88,32 +201,155 @@ class WebAPI {
 
 		// Default API request handler
 		apiResponse apiHandler(String *requestURL);
+		// Allocation free API request handler, request is "keyword" or "keyword=value".
+		// Number values are formatted into buffer (valueTextSize bytes), the reply is valid until the next call.
+		// String values are not copied, hold the value lock until the reply is used
+		apiReply requestHandler(const char *request, char *buffer);
 
 		// Default API based HTML processor
 		String htmlProcessor(const String &var);
 
+		// Batch request handler, resolves all items in one pass and replies with one "keyword:code:text" line per item.
+		// Sets are applied in order, and each keyword callback runs once after all sets
+		apiResponse batchHandler(const apiBatchItem *items, uint8_t count);
+
+		// Defer sets to poll(). Sets are validated and queued, and replied to at once. Values are written and
+		// callbacks run by poll(), so the application's variables are only written from the thread calling poll().
+		// Call before any request is served
+		void enableDeferredSets(uint8_t queueSize = defaultSetQueueSize);
+		// Apply queued sets and run their callbacks, and run callbacks held back by a set policy once due.
+		// Returns the number of sets applied. Call from the application loop
+		uint8_t poll();
+
+		// Number of keywords
+		uint8_t keywords();
+		// Request keyword of keyword index
+		const char *keywordName(uint8_t index);
+		// Change generation, increased on every set
+		uint32_t generation();
+		// Generation of the last change of keyword index
+		uint32_t modifiedGeneration(uint8_t index);
+		// All keywords, as URL encoded "keyword=value&keyword=value"
+		String allValues();
+		// Keywords changed after generation since, as URL encoded "keyword=value&keyword=value". All keywords if since is 0,
+		// including those never set or restored from the store
+		String changedValues(uint32_t since);
+		// Add the keywords changed after generation since to set
+		void changedKeywords(uint32_t since, keywordSet *set);
+		// Add the keywords matching pattern to set, a keyword or a prefix group ending in '*' ("LED*"). Returns the number of matches
+		uint8_t matchKeywords(const char *pattern, size_t length, keywordSet *set);
+		// Keywords in set, as URL encoded "keyword=value&keyword=value"
+		String selectedValues(const keywordSet *set);
+
+		// Keep a history of a numeric keyword, sampled by poll(). Returns false if the keyword is unknown or not a number
+		bool addHistory(const char *keyword, WebHistory &history);
+		// Get the history of keyword, nullptr if it has none
+		WebHistory *history(const char *keyword);
+
+		// Binary frame of keyword values, all keywords if count is 0. Little-endian layout:
+		// uint32 sequence (change generation), uint8 item count, then for each item uint8 id, uint8 value type and the value.
+		// Values are 1 byte (pBOOL), 4 bytes (pUINT, pINT, pFLOAT, pENUM as int32), 8 bytes (pINT64, pUINT64, pDOUBLE)
+		// or an uint16 length and the bytes (pSTRING, pCHARS). Unknown ids have type binaryUnknownType and no value.
+		// Writes at most size bytes to buffer, and returns the frame length (larger than size if it did not fit)
+		size_t binaryValues(const uint8_t *ids, uint8_t count, uint8_t *buffer, size_t size);
+		// Schema of the binary frame, one "id type name" line per keyword
+		String binarySchema();
+
+		// Find index of HTML placeholder, from a (non null terminated) name. Returns -1 if not found
+		int16_t placeholderIndex(const char *placeholder, size_t length);
+		// Get value of keyword as text, numbers are formatted into buffer (valueTextSize bytes), strings are returned without copying.
+		// Hold the value lock while using a string
+		const char *valueText(uint8_t index, char *buffer, size_t *length);
+
+		// Lock String and char array values. The library writes them under the lock, so a reader holding it never sees a String
+		// buffer being freed. Recursive, prefer a valueLock. The application writes bound strings under it too while the server runs
+		void lockValues();
+		// Unlock String and char array values
+		void unlockValues();
+
 	private:
 		// API keywords struct		
 		apiKeyword *_apiKeywords;
 		// Number of keywords
 		const uint8_t _keywords;
+		// Runtime state of each keyword
+		keywordState *_states;
+		// Change generation, published after the keyword generation and value it covers. Readers load it without the lock
+		std::atomic<uint32_t> _generation{0};
+		// Lock of String and char array values, as they can not be written with a single store
+		std::recursive_mutex _valueLock;
+
+		// Queued sets, in deferred mode. Single producer (web server task), single consumer (poll()) ring buffer
+		queuedSet *_setQueue = nullptr;
+		// Number of slots in the set queue
+		uint8_t _setQueueSize = 0;
+		// End of the sets handed to the consumer, only written by the producer
+		std::atomic<uint8_t> _setHead{0};
+		// Next slot to write, ahead of the head while a batch is queued. Producer only
+		uint8_t _setNext = 0;
+		// Next slot to read, only written by the consumer
+		std::atomic<uint8_t> _setTail{0};
 
 		// Get responder
-		apiResponse apiGet(String *keyword);
+		apiReply apiGet(const char *keyword, size_t length, char *buffer);
 		// Set responder
-		apiResponse apiSet(String *keyword, String *value);
+		apiReply apiSet(const char *keyword, size_t length, const char *value);
 
-		// Find keyword in keywords list
-		int16_t findKeywordIndex(String *keywordName);
+		// Keyword indexes sorted by requestKeyword (lookup index)
+		uint8_t *_keywordIndex;
+		// Keyword indexes sorted by htmlPlaceholder (lookup index)
+		uint8_t *_placeholderIndex;
+
+		// Build lookup index, sorted by the given keyword field
+		void buildIndex(uint8_t *index, String apiKeyword::*field);
+		// Binary search lookup index for an exact match of name
+		int16_t searchIndex(const uint8_t *index, String apiKeyword::*field, const char *name, size_t length);
+
+		// Find keyword in keywords list, from a (non null terminated) name
+		int16_t findKeywordIndex(const char *keywordName, size_t length);
 		// Find htmlPlaceholder in keywords list
 		int16_t findPlaceholderIndex(const String &placeholder);
 
-		// Get value, based on type
-		apiResponse getValueByType(uint8_t index);
+		// Write the binary value of keyword index to buffer (if it fits within size bytes), returns its length
+		size_t binaryValue(uint8_t index, uint8_t *buffer, size_t size);
+		// Set keyword index from its binary value, without running the callback. Returns false if the length does not match the type
+		bool setBinaryValue(uint8_t index, const uint8_t *data, size_t length);
+		// Changes of persistent keywords
+		uint32_t _persistentChanges = 0;
+
+		// Append "keyword=value" of keyword index to values, URL encoded and '&' separated
+		void appendValue(String *values, uint8_t index);
+		// Get the value of a number keyword as float, returns false if it is not a number
+		bool numberValue(uint8_t index, float *value);
+		// Sample the keyword histories
+		void sampleHistories(uint32_t now);
+
+		// Parse text into the variable of keyword index, strings under the value lock. Returns false if text does not parse
+		bool writeValue(uint8_t index, const char *text);
 		// Set value, based on type
-		apiResponse setValueByType(uint8_t index, String *value);
+		apiReply setValueByType(uint8_t index, const char *value, bool runCallback = true);
+		// Queue a validated set for poll(). Sets of a batch are held back until endBatch() publishes them together
+		apiReply queueSet(uint8_t index, const char *value, bool endsBatch);
+		// Hand the sets queued by a batch to poll(), which runs their callbacks once for each keyword
+		void endBatch();
+		// Check if value is the current value of a setOnChange keyword, so the set can be skipped
+		bool unchanged(uint8_t index, const char *value);
+		// Record a change of keyword index
+		void recordChange(uint8_t index);
+		// Run the callback of keyword index, or hold it back as its set policy says
+		void runCallback(uint8_t index);
+		// Run the callback of each keyword marked in changed, one bit per keyword
+		void runCallbacks(const uint8_t *changed);
+};
 
-		// Process placeholder by type
-		String processPlaceholderByType(uint8_t index);
+// Holds the value lock of a WebAPI while in scope, e.g. valueLock lock(&api); status = "Running";. Does nothing without an API.
+// With a webManager use manager.lockValues() and manager.unlockValues()
+class valueLock {
+	public:
+		valueLock(WebAPI *api) : _api(api) { if (_api != nullptr) _api->lockValues(); }
+		~valueLock() { if (_api != nullptr) _api->unlockValues(); }
+
+	private:
+		WebAPI *_api;
 };
 #endif
\ No newline at end of file
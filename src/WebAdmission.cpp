@@ -0,0 +1,141 @@
+/*
+ * WebAdmission is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+#include "WebAdmission.h"
+
+//*************************************************************
+// Public functions
+//*************************************************************
+
+// Constructor
+WebAdmission::WebAdmission() {}
+
+// Limit requests of type in flight
+void WebAdmission::setConcurrencyLimit(uint8_t type, uint8_t limit) {
+	if (type < admissionTypes) {
+		_limits[type] = limit;
+	}
+}
+
+// Limit requests per client address
+void WebAdmission::setRateLimit(uint16_t perSecond, uint16_t burst) {
+	_perSecond = perSecond;
+	_burst = (burst > 0) ? burst : 1;
+	memset(_clients, 0, sizeof(_clients));
+}
+
+// Reject requests while free heap is below bytes
+void WebAdmission::setHeapFloor(uint32_t bytes) {
+	_heapFloor = bytes;
+}
+
+// Set Retry-After sent with rejections
+void WebAdmission::setRetryAfter(uint16_t seconds) {
+	_retryAfter = seconds;
+}
+
+// Check if a request may be served
+uint8_t WebAdmission::admit(uint8_t type, uint32_t address, uint32_t freeHeap) {
+	uint8_t result = admitted;
+	// Cheapest checks first, and the rate limit last so rejected requests do not use tokens
+	if (_heapFloor > 0 && freeHeap < _heapFloor) {
+		result = rejectedHeap;
+	} else if (type < admissionTypes && _limits[type] > 0 && _inFlight[type] >= _limits[type]) {
+		result = rejectedConcurrency;
+	} else if (_perSecond > 0 && !takeToken(address)) {
+		result = rejectedRate;
+	}
+	if (result != admitted) {
+		_rejected[result]++;
+	}
+	return result;
+}
+
+// A request of type was admitted and is in flight
+void WebAdmission::started(uint8_t type) {
+	if (type < admissionTypes) {
+		_inFlight[type]++;
+	}
+}
+
+// A request of type is done
+void WebAdmission::finished(uint8_t type) {
+	if (type < admissionTypes && _inFlight[type] > 0) {
+		_inFlight[type]--;
+	}
+}
+
+// Retry-After sent with rejections
+uint16_t WebAdmission::retryAfter() {
+	return _retryAfter;
+}
+
+// Requests of type in flight
+uint8_t WebAdmission::inFlight(uint8_t type) {
+	return (type < admissionTypes) ? _inFlight[type] : 0;
+}
+
+// Number of requests rejected for reason
+uint32_t WebAdmission::rejected(uint8_t reason) {
+	return (reason < admissionResults) ? _rejected[reason] : 0;
+}
+
+//*************************************************************
+// Private functions
+//*************************************************************
+
+// Take a token from the bucket of address
+bool WebAdmission::takeToken(uint32_t address) {
+	uint32_t now = millis();
+	uint32_t capacity = (uint32_t)_burst * 1000;
+	// Find the client, else take over the least recently seen bucket with a full bucket
+	clientBucket *bucket = &_clients[0];
+	for (uint8_t i = 0; i < admissionClients; i++) {
+		if (_clients[i].address == address) {
+			bucket = &_clients[i];
+			break;
+		}
+		if (now - _clients[i].updated > now - bucket->updated || _clients[i].address == 0) {
+			bucket = &_clients[i];
+		}
+	}
+	if (bucket->address != address) {
+		*bucket = {address, capacity, now};
+	}
+	// Refill at perSecond requests per second, that is perSecond thousandths per ms
+	uint64_t tokens = bucket->tokens + (uint64_t)(now - bucket->updated) * _perSecond;
+	bucket->tokens = (tokens > capacity) ? capacity : tokens;
+	bucket->updated = now;
+	if (bucket->tokens < 1000) {
+		return false;
+	}
+	bucket->tokens -= 1000;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+/*
+ * WebAdmission is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+// Ensure the library is only included once
+#ifndef _WebAdmission_
+#define _WebAdmission_
+
+#include "Arduino.h"
+
+// Number of request types with their own concurrency limit (web content types)
+#define admissionTypes 8
+// Number of client addresses with a rate limit bucket, the least recently seen client is replaced when full
+#define admissionClients 8
+// Default Retry-After of a rejected request, in seconds
+#define defaultRetryAfter 1
+
+// Admission results
+typedef enum {
+	admitted,
+	rejectedConcurrency, // Too many requests of the type in flight
+	rejectedRate, // The client has used up its rate limit
+	rejectedHeap, // Free heap is below the floor
+	admissionResults
+} admissionResults_t;
+
+// Token bucket of a client address
+struct clientBucket {
+	uint32_t address; // Client IPv4 address, 0 for a free bucket
+	uint32_t tokens; // Tokens left, in thousandths of a request
+	uint32_t updated; // Time of the last refill, in ms
+};
+
+// Admission control: caps on requests in flight per type, a token bucket rate limit per client address and a free
+// heap floor. Rejected requests are meant to get a fast 503, so the server keeps a steady throughput under overload.
+// Only used from the async web server task, so it needs no locking
+class WebAdmission {
+	public:
+		// Constructor, nothing is limited
+		WebAdmission();
+
+		// Limit requests of type in flight, 0 for no limit
+		void setConcurrencyLimit(uint8_t type, uint8_t limit);
+		// Limit requests per client address to perSecond, with bursts of up to burst requests. 0 for no limit
+		void setRateLimit(uint16_t perSecond, uint16_t burst);
+		// Reject requests while free heap is below bytes, 0 for no floor
+		void setHeapFloor(uint32_t bytes);
+		// Set Retry-After sent with rejections, in seconds
+		void setRetryAfter(uint16_t seconds);
+
+		// Check if a request may be served, returns admitted or the reason for rejecting it. Call started() when admitted
+		uint8_t admit(uint8_t type, uint32_t address, uint32_t freeHeap);
+		// A request of type was admitted and is in flight
+		void started(uint8_t type);
+		// A request of type is done
+		void finished(uint8_t type);
+
+		// Retry-After sent with rejections, in seconds
+		uint16_t retryAfter();
+		// Requests of type in flight
+		uint8_t inFlight(uint8_t type);
+		// Number of requests rejected for reason
+		uint32_t rejected(uint8_t reason);
+
+	private:
+		// Concurrency limit of each type
+		uint8_t _limits[admissionTypes] = {};
+		// Requests in flight of each type
+		uint8_t _inFlight[admissionTypes] = {};
+		// Rate limit, requests per second
+		uint16_t _perSecond = 0;
+		// Rate limit burst, requests
+		uint16_t _burst = 0;
+		// Client buckets
+		clientBucket _clients[admissionClients] = {};
+		// Free heap floor, bytes
+		uint32_t _heapFloor = 0;
+		// Retry-After, seconds
+		uint16_t _retryAfter = defaultRetryAfter;
+		// Rejections for each reason
+		uint32_t _rejected[admissionResults] = {};
+
+		// Take a token from the bucket of address, returns false if it is empty
+		bool takeToken(uint32_t address);
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,205 @@
+/*
+ * WebAsyncTransport is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+#include "WebAsyncTransport.h"
+
+// Passes the requests of ESPAsyncWebServer on to a request handler
+class asyncDispatcher : public AsyncWebHandler {
+	public:
+		// Constructor
+		asyncDispatcher(WebRequestHandler *handler) : _handler(handler) {}
+		// Check if the request is for the handler, and keep the headers it reads
+		bool canHandle(AsyncWebServerRequest *request) override {
+			const String &url = request->url();
+			if (!_handler->canHandle(url.c_str(), url.length(), request->method())) {
+				return false;
+			}
+			for (const char *const *header = _handler->headers(); *header != nullptr; header++) {
+				request->addInterestingHeader(*header);
+			}
+			return true;
+		}
+		// Serve the request
+		void handleRequest(AsyncWebServerRequest *request) override {
+			asyncWebRequest webRequest(request);
+			_handler->handleRequest(&webRequest);
+		}
+
+	private:
+		// Handler of the requests
+		WebRequestHandler *_handler;
+};
+
+//*************************************************************
+// Request
+//*************************************************************
+
+// Constructor
+asyncWebRequest::asyncWebRequest(AsyncWebServerRequest *request) : _request(request) {}
+
+// Request path
+const String &asyncWebRequest::url() {
+	return _request->url();
+}
+
+// Request method
+uint8_t asyncWebRequest::method() {
+	return _request->method();
+}
+
+// Client address
+uint32_t asyncWebRequest::clientAddress() {
+	return (uint32_t)_request->client()->remoteIP();
+}
+
+// Value of a request header
+const char *asyncWebRequest::header(const char *name) {
+	AsyncWebHeader *header = _request->getHeader(name);
+	return (header != nullptr) ? header->value().c_str() : nullptr;
+}
+
+// Number of query parameters
+size_t asyncWebRequest::params() {
+	return _request->params();
+}
+
+// Name of query parameter index
+const char *asyncWebRequest::paramName(size_t index) {
+	return _request->getParam(index)->name().c_str();
+}
+
+// Value of query parameter index
+const char *asyncWebRequest::paramValue(size_t index) {
+	return _request->getParam(index)->value().c_str();
+}
+
+// Value of query parameter name
+const char *asyncWebRequest::param(const char *name) {
+	AsyncWebParameter *param = _request->getParam(name);
+	return (param != nullptr) ? param->value().c_str() : nullptr;
+}
+
+// Add a header to the reply
+void asyncWebRequest::addHeader(const char *name, const char *value) {
+	if (_headers == asyncReplyHeaders) {
+		webLogError("asyncWebRequest::addHeader(), No room for header %s", name);
+		return;
+	}
+	_headerNames[_headers] = name;
+	_headerValues[_headers] = value;
+	_headers++;
+}
+
+// Send a reply, copying the text
+void asyncWebRequest::send(uint16_t code, const char *contentType, const char *text, size_t length) {
+	if (contentType == nullptr) {
+		sendResponse(_request->beginResponse(code));
+		return;
+	}
+	String content;
+	content.concat(text, length);
+	sendResponse(_request->beginResponse(code, contentType, content));
+}
+
+// Send a reply from a buffer
+void asyncWebRequest::sendBuffer(uint16_t code, const char *contentType, const uint8_t *data, size_t length, bool freeData, placeholderProcessor processor) {
+	// The request frees _tempObject when it is done, so the buffer lives exactly as long as the response
+	if (freeData) {
+		_request->_tempObject = (void*)data;
+	}
+	sendResponse(_request->beginResponse_P(code, contentType, data, length, processor));
+}
+
+// Send an open file
+void asyncWebRequest::sendFile(File file, const char *contentType, placeholderProcessor processor) {
+	// The path is the file name, so the response does not add an encoding of its own
+	sendResponse(_request->beginResponse(file, file.name(), contentType, false, processor));
+}
+
+// Send a reply filled in parts
+void asyncWebRequest::sendChunked(uint16_t code, const char *contentType, webFiller filler) {
+	AsyncWebServerResponse *response = _request->beginChunkedResponse(contentType, filler);
+	response->setCode(code);
+	sendResponse(response);
+}
+
+// Send a printed reply
+void asyncWebRequest::sendPrinted(uint16_t code, const char *contentType, webPrinter printer) {
+	AsyncResponseStream *response = _request->beginResponseStream(contentType);
+	response->setCode(code);
+	printer(*response);
+	sendResponse(response);
+}
+
+// Call done when the request is done
+void asyncWebRequest::onDone(webDone done) {
+	_request->onDisconnect(done);
+}
+
+// The ESPAsyncWebServer request
+AsyncWebServerRequest *asyncWebRequest::asyncRequest() {
+	return _request;
+}
+
+// Add the reply headers, and send
+void asyncWebRequest::sendResponse(AsyncWebServerResponse *response) {
+	for (uint8_t i = 0; i < _headers; i++) {
+		response->addHeader(_headerNames[i], _headerValues[i]);
+	}
+	_request->send(response);
+}
+
+//*************************************************************
+// Transport
+//*************************************************************
+
+// Destructor
+WebAsyncTransport::~WebAsyncTransport() {
+	delete _server;
+}
+
+// Start the server
+bool WebAsyncTransport::begin(uint16_t port, WebRequestHandler *handler) {
+	_server = new AsyncWebServer(port);
+	// One handler serves all requests for the handler, instead of one handler per route
+	_server->addHandler(new asyncDispatcher(handler));
+	// The rest goes to the handler as well, to reply not found
+	_server->onNotFound([handler](AsyncWebServerRequest *request){
+		asyncWebRequest webRequest(request);
+		handler->handleRequest(&webRequest);
+	});
+	_server->begin();
+	return true;
+}
+
+// Get the server
+AsyncWebServer *WebAsyncTransport::server() {
+	return _server;
+}
\ No newline at end of file
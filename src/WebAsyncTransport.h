@@ -0,0 +1,96 @@
+/*
+ * WebAsyncTransport is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+// Ensure the library is only included once
+#ifndef _WebAsyncTransport_
+#define _WebAsyncTransport_
+
+#include "Arduino.h"
+#include "ESPAsyncWebServer.h"
+#include "WebTransport.h"
+#include "WebLog.h"
+
+// Maximum number of headers added to a reply
+#define asyncReplyHeaders 4
+
+// A request of ESPAsyncWebServer, seen as a WebRequest. Lives while the request is handled,
+// what outlives it (fillers, done callbacks) is handed to the ESPAsyncWebServer request
+class asyncWebRequest : public WebRequest {
+	public:
+		// Constructor
+		asyncWebRequest(AsyncWebServerRequest *request);
+
+		const String &url() override;
+		uint8_t method() override;
+		uint32_t clientAddress() override;
+		const char *header(const char *name) override;
+		size_t params() override;
+		const char *paramName(size_t index) override;
+		const char *paramValue(size_t index) override;
+		const char *param(const char *name) override;
+		void addHeader(const char *name, const char *value) override;
+		void send(uint16_t code, const char *contentType, const char *text, size_t length) override;
+		void sendBuffer(uint16_t code, const char *contentType, const uint8_t *data, size_t length, bool freeData = false, placeholderProcessor processor = nullptr) override;
+		void sendFile(File file, const char *contentType, placeholderProcessor processor = nullptr) override;
+		void sendChunked(uint16_t code, const char *contentType, webFiller filler) override;
+		void sendPrinted(uint16_t code, const char *contentType, webPrinter printer) override;
+		void onDone(webDone done) override;
+		AsyncWebServerRequest *asyncRequest() override;
+
+	private:
+		// The ESPAsyncWebServer request
+		AsyncWebServerRequest *_request;
+		// Reply header names
+		const char *_headerNames[asyncReplyHeaders];
+		// Reply header values
+		const char *_headerValues[asyncReplyHeaders];
+		// Number of reply headers
+		uint8_t _headers = 0;
+
+		// Add the reply headers to response, and send it
+		void sendResponse(AsyncWebServerResponse *response);
+};
+
+// Transport over ESPAsyncWebServer, the default of the web manager. Requests are served on the async TCP task
+class WebAsyncTransport : public WebTransport {
+	public:
+		// Destructor
+		~WebAsyncTransport();
+
+		// Start the server on port
+		bool begin(uint16_t port, WebRequestHandler *handler) override;
+		// Get the server, to add handlers of other kinds (push events, WebSockets). nullptr before begin()
+		AsyncWebServer *server();
+
+	private:
+		// The server
+		AsyncWebServer *_server = nullptr;
+};
+#endif
\ No newline at end of file
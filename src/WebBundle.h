@@ -0,0 +1,47 @@
+/*
+ * WebBundle is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+// Ensure the library is only included once
+#ifndef _WebBundle_
+#define _WebBundle_
+
+#include "Arduino.h"
+
+// A file in a compiled-in web asset bundle. Bundles are generated from a data directory by extras/webbundle.py,
+// as a header with the file content in flash, and are sent straight from flash with no filesystem calls or copies
+struct webBundleFile {
+	const char *fileName; // File name, as the path in the data directory ("/index.html")
+	const uint8_t *data; // File content, gzip-compressed if gzip is set
+	uint32_t size; // Size of data
+	const char *mimeType; // MIME type, from the file extension
+	uint32_t etag; // Hash of data (FNV-1a), sent as strong ETag
+	bool gzip; // Data is gzip-compressed
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,172 @@
+/*
+ * WebFileCache is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+#include "Arduino.h"
+#include "WebFileCache.h"
+
+//*************************************************************
+// Public functions
+//*************************************************************
+
+// Constructor
+WebFileCache::WebFileCache(size_t budget, uint8_t maxFiles) : _maxFiles(maxFiles), _budget(budget) {
+	_files = new cachedFile[_maxFiles];
+	for (uint8_t i = 0; i < _maxFiles; i++) {
+		_files[i].data = nullptr;
+		_files[i].size = 0;
+		_files[i].lastUsed = 0;
+		_files[i].users = 0;
+	}
+}
+
+// Destructor
+WebFileCache::~WebFileCache() {
+	for (uint8_t i = 0; i < _maxFiles; i++) {
+		free(_files[i].data);
+	}
+	delete[] _files;
+}
+
+// Get file, loading it on a miss
+cachedFile *WebFileCache::acquire(fs::FS &fs, const char *fileName) {
+	_tick++;
+	// Look for the file in the cache
+	for (uint8_t i = 0; i < _maxFiles; i++) {
+		if (_files[i].data != nullptr && _files[i].fileName.equals(fileName)) {
+			_hits++;
+			_files[i].lastUsed = _tick;
+			_files[i].users++;
+			return &_files[i];
+		}
+	}
+	_misses++;
+	File file = fs.open(fileName, "r");
+	if (!file) {
+		return nullptr;
+	}
+	size_t size = file.size();
+	// Make room for the file, skip caching if it can not fit
+	cachedFile *slot = (size > 0 && size <= _budget) ? makeRoom(size) : nullptr;
+	if (slot == nullptr) {
+		file.close();
+		return nullptr;
+	}
+	// Prefer PSRAM when present, to keep internal heap free
+	uint8_t *data = psramFound() ? (uint8_t*)ps_malloc(size) : (uint8_t*)malloc(size);
+	if (data == nullptr) {
+		file.close();
+		return nullptr;
+	}
+	if (file.read(data, size) != size) {
+		free(data);
+		file.close();
+		return nullptr;
+	}
+	file.close();
+	webLogDebug("WebFileCache::acquire(), Cached file: %s", fileName);
+	slot->fileName = fileName;
+	slot->data = data;
+	slot->size = size;
+	slot->lastUsed = _tick;
+	slot->users = 1;
+	_used += size;
+	return slot;
+}
+
+// Release a file, once the response using it is done
+void WebFileCache::release(cachedFile *file) {
+	if (file != nullptr && file->users > 0) {
+		file->users--;
+	}
+}
+
+// Number of requests served from the cache
+uint32_t WebFileCache::hits() {
+	return _hits;
+}
+
+// Number of requests that had to read the file
+uint32_t WebFileCache::misses() {
+	return _misses;
+}
+
+// Number of files evicted to make room
+uint32_t WebFileCache::evictions() {
+	return _evictions;
+}
+
+// Bytes held in the cache
+size_t WebFileCache::used() {
+	return _used;
+}
+
+// Maximum bytes held in the cache
+size_t WebFileCache::budget() {
+	return _budget;
+}
+
+//*************************************************************
+// Private functions
+//*************************************************************
+
+// Evict least recently used files until size bytes (and a slot) are free
+cachedFile *WebFileCache::makeRoom(size_t size) {
+	while (true) {
+		cachedFile *freeSlot = nullptr;
+		cachedFile *oldest = nullptr;
+		for (uint8_t i = 0; i < _maxFiles; i++) {
+			if (_files[i].data == nullptr) {
+				freeSlot = &_files[i];
+			} else if (_files[i].users == 0 && (oldest == nullptr || _files[i].lastUsed < oldest->lastUsed)) {
+				oldest = &_files[i];
+			}
+		}
+		// Done when there is both a slot and enough budget
+		if (freeSlot != nullptr && _used + size <= _budget) {
+			return freeSlot;
+		}
+		// Nothing left to evict, files in use are kept
+		if (oldest == nullptr) {
+			return nullptr;
+		}
+		evict(oldest);
+	}
+}
+
+// Drop file content from a slot
+void WebFileCache::evict(cachedFile *file) {
+	webLogDebug("WebFileCache::evict(), Evicting file: %s", file->fileName.c_str());
+	_used -= file->size;
+	_evictions++;
+	free(file->data);
+	file->data = nullptr;
+	file->size = 0;
+	file->fileName = String();
+}
@@ -0,0 +1,97 @@
+/*
+ * WebFileCache is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+// Ensure the library is only included once
+#ifndef _WebFileCache_
+#define _WebFileCache_
+
+#include "Arduino.h"
+#include "FS.h"
+#include "WebLog.h"
+
+// Default number of files the cache can hold
+#define defaultCacheFiles 16
+
+// A file held in the cache
+struct cachedFile {
+	String fileName; // The (path and) filename of the cached file
+	uint8_t *data; // File content
+	size_t size; // File size
+	uint32_t lastUsed; // Tick of last use, for LRU eviction
+	uint16_t users; // In-flight responses sending the data, the file is not evicted while in use
+};
+
+// Bounded in-RAM cache of files, with LRU eviction.
+// Only used from the async web server task, so it needs no locking.
+class WebFileCache {
+	public:
+		// Constructor, budget is the maximum number of bytes held
+		WebFileCache(size_t budget, uint8_t maxFiles = defaultCacheFiles);
+		// Destructor
+		~WebFileCache();
+
+		// Get file, loading it on a miss. Returns nullptr if it can not be cached. Release with release()
+		cachedFile *acquire(fs::FS &fs, const char *fileName);
+		// Release a file, once the response using it is done
+		void release(cachedFile *file);
+
+		// Number of requests served from the cache
+		uint32_t hits();
+		// Number of requests that had to read the file
+		uint32_t misses();
+		// Number of files evicted to make room
+		uint32_t evictions();
+		// Bytes held in the cache
+		size_t used();
+		// Maximum bytes held in the cache
+		size_t budget();
+
+	private:
+		// Cache slots
+		cachedFile *_files;
+		// Number of cache slots
+		const uint8_t _maxFiles;
+		// Byte budget
+		const size_t _budget;
+		// Bytes in use
+		size_t _used = 0;
+		// LRU tick
+		uint32_t _tick = 0;
+		// Counters
+		uint32_t _hits = 0;
+		uint32_t _misses = 0;
+		uint32_t _evictions = 0;
+
+		// Evict least recently used files until size bytes (and a slot) are free. Returns free slot, or nullptr
+		cachedFile *makeRoom(size_t size);
+		// Drop file content from a slot
+		void evict(cachedFile *file);
+};
+#endif
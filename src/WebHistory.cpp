@@ -0,0 +1,231 @@
+/*
+ * WebHistory is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+#include "WebHistory.h"
+
+//*************************************************************
+// Public functions
+//*************************************************************
+
+// Constructor
+WebHistory::WebHistory(historySlot *slots, uint16_t count, historyRollup *rollups, uint32_t period, float scale, uint8_t mode) : _slots(slots), _count(count), _rollups(rollups), _period(period > 0 ? period : 1), _scale(scale), _mode(mode) {
+	// One level of rollups per historyFanout, until a block covers all slots (as historyRollupSize())
+	for (uint32_t block = historyFanout; block < _count; block *= historyFanout) {
+		_levels++;
+	}
+}
+
+// Close the slots that ended before now
+void WebHistory::advance(uint32_t now) {
+	if (!_started) {
+		return;
+	}
+	uint32_t slot = (now - _start) / _period;
+	// After a gap longer than the history, skip to a start aligned on the largest block, so all rollups are rebuilt
+	if (slot - _closed > _count) {
+		uint32_t block = 1;
+		for (uint8_t level = 0; level < _levels; level++) {
+			block *= historyFanout;
+		}
+		uint32_t first = slot - _count;
+		first -= first % block;
+		if (first > _closed) {
+			_closed = first;
+			_current = {};
+		}
+	}
+	while (_closed < slot) {
+		closeSlot();
+	}
+}
+
+// Check if a sample is wanted
+bool WebHistory::wantsSample() {
+	return _current.count == 0;
+}
+
+// Add a sample to the current slot
+void WebHistory::sample(float value, uint32_t now) {
+	if (!_started) {
+		_started = true;
+		_start = now;
+	}
+	advance(now);
+	int16_t fixed = toFixed(value);
+	if (_current.count == 0) {
+		_current = {fixed, fixed, fixed, 1};
+	} else {
+		_current.min = (fixed < _current.min) ? fixed : _current.min;
+		_current.max = (fixed > _current.max) ? fixed : _current.max;
+		// The average stops taking samples once the count is full
+		if (_current.count < UINT16_MAX) {
+			_current.sum += fixed;
+			_current.count++;
+		}
+	}
+	_held = fixed;
+}
+
+// Widen the minimum and maximum of the current slot
+void WebHistory::widen(float min, float max) {
+	// A slot without samples has no average to keep apart from its range
+	if (_current.count == 0) {
+		return;
+	}
+	int16_t low = toFixed(min);
+	int16_t high = toFixed(max);
+	_current.min = (low < _current.min) ? low : _current.min;
+	_current.max = (high > _current.max) ? high : _current.max;
+}
+
+// Sampling mode
+uint8_t WebHistory::mode() {
+	return _mode;
+}
+
+// Time covered by all slots, in s rounded up
+uint32_t WebHistory::span() {
+	uint64_t span = ((uint64_t)_count * _period + 999) / 1000;
+	return (span > UINT32_MAX / 1000) ? UINT32_MAX / 1000 : span;
+}
+
+// Print the last window ms, downsampled to points lines
+size_t WebHistory::print(Print &output, uint32_t window, uint16_t points, uint32_t now) {
+	size_t length = 0;
+	if (_closed == 0 || points == 0) {
+		return length;
+	}
+	// Closed slots still held, limited to the window
+	uint32_t oldest = (_closed > _count) ? _closed - _count : 0;
+	uint32_t slots = window / _period + ((window % _period) ? 1 : 0);
+	uint32_t first = (_closed - oldest > slots) ? _closed - slots : oldest;
+	uint32_t slotCount = _closed - first;
+	if (points > historyMaxPoints) {
+		points = historyMaxPoints;
+	}
+	if (points > slotCount) {
+		points = slotCount;
+	}
+	for (uint16_t i = 0; i < points; i++) {
+		uint32_t from = first + (uint64_t)slotCount * i / points;
+		uint32_t to = first + (uint64_t)slotCount * (i + 1) / points;
+		historyRollup summary = summarise(from, to);
+		length += output.printf("%lu %g %g %g\n", (unsigned long)(now - (_start + to * _period)), summary.min / _scale, summary.max / _scale, (float)summary.sum / summary.count / _scale);
+	}
+	return length;
+}
+
+//*************************************************************
+// Private functions
+//*************************************************************
+
+// Convert a value to fixed point
+int16_t WebHistory::toFixed(float value) {
+	float fixed = value * _scale;
+	if (fixed >= INT16_MAX) {
+		return INT16_MAX;
+	}
+	if (fixed <= INT16_MIN) {
+		return INT16_MIN;
+	}
+	return (int16_t)(fixed < 0 ? fixed - 0.5f : fixed + 0.5f);
+}
+
+// Length of the rollup ring of level
+uint16_t WebHistory::levelLength(uint8_t level) {
+	uint32_t block = 1;
+	for (uint8_t i = 0; i < level; i++) {
+		block *= historyFanout;
+	}
+	// Room for every block overlapping the slot ring, plus the one being filled
+	return _count / block + 2;
+}
+
+// Close the current slot and start the next
+void WebHistory::closeSlot() {
+	historySlot closed;
+	if (_current.count == 0) {
+		closed = {_held, _held, _held};
+	} else {
+		closed = {_current.min, _current.max, (int16_t)(_current.sum / _current.count)};
+	}
+	_slots[_closed % _count] = closed;
+	// Add the slot to the rollup of its block on each level, starting a new rollup on the first slot of a block
+	uint32_t block = 1;
+	uint16_t offset = 0;
+	for (uint8_t level = 1; level <= _levels; level++) {
+		block *= historyFanout;
+		uint16_t length = levelLength(level);
+		historyRollup *rollup = &_rollups[offset + (_closed / block) % length];
+		if (_closed % block == 0) {
+			*rollup = {closed.min, closed.max, closed.avg, 1};
+		} else {
+			rollup->min = (closed.min < rollup->min) ? closed.min : rollup->min;
+			rollup->max = (closed.max > rollup->max) ? closed.max : rollup->max;
+			rollup->sum += closed.avg;
+			rollup->count++;
+		}
+		offset += length;
+	}
+	_closed++;
+	_current = {};
+}
+
+// Summary of the closed slots from first to last
+historyRollup WebHistory::summarise(uint32_t first, uint32_t last) {
+	historyRollup summary = {INT16_MAX, INT16_MIN, 0, 0};
+	uint32_t slot = first;
+	while (slot < last) {
+		// Climb to the largest block starting at slot that ends within the range
+		uint8_t level = 0;
+		uint32_t block = 1;
+		uint16_t offset = 0;
+		while (level < _levels && slot % (block * historyFanout) == 0 && slot + block * historyFanout <= last) {
+			if (level > 0) {
+				offset += levelLength(level);
+			}
+			level++;
+			block *= historyFanout;
+		}
+		historyRollup part;
+		if (level == 0) {
+			const historySlot *closed = &_slots[slot % _count];
+			part = {closed->min, closed->max, closed->avg, 1};
+		} else {
+			part = _rollups[offset + (slot / block) % levelLength(level)];
+		}
+		summary.min = (part.min < summary.min) ? part.min : summary.min;
+		summary.max = (part.max > summary.max) ? part.max : summary.max;
+		summary.sum += part.sum;
+		summary.count += part.count;
+		slot += block;
+	}
+	return summary;
+}
\ No newline at end of file
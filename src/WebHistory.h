@@ -0,0 +1,141 @@
+/*
+ * WebHistory is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+// Ensure the library is only included once
+#ifndef _WebHistory_
+#define _WebHistory_
+
+#include "Arduino.h"
+
+// Slots summarised by each rollup of the level above
+#define historyFanout 8
+// Maximum number of points in a history query
+#define historyMaxPoints 240
+
+// Sampling modes
+typedef enum {
+	historyPeriodic, // One sample per slot, taken when the slot starts
+	historyOnChange // Changes seen by poll() are sampled into their slot, the slot min and max take every value set. Unchanged slots hold the last value
+} historyModes;
+
+// A slot of history, values in fixed point (value * scale)
+struct historySlot {
+	int16_t min;
+	int16_t max;
+	int16_t avg;
+};
+
+// Summary of historyFanout^level consecutive slots
+struct historyRollup {
+	int16_t min;
+	int16_t max;
+	int32_t sum; // Sum of slot averages
+	uint16_t count; // Number of slots summarised
+};
+
+// Number of rollups needed above slots, one ring per level until a block covers all slots
+constexpr uint32_t historyRollupSize(uint32_t slots, uint32_t block) {
+	return (block >= slots) ? 0 : slots / block + 2 + historyRollupSize(slots, block * historyFanout);
+}
+
+// History of a numeric keyword: a ring of fixed length slots, plus rings of rollups over historyFanout, historyFanout^2, ...
+// slots. A query is answered from the coarsest rollups that fit each point, so it costs O(points), not O(history).
+// Written by one thread (WebAPI::poll()), a query running at the same time may see a slot being closed
+class WebHistory {
+	public:
+		// Constructor, on storage of count slots and historyRollupSize(count, historyFanout) rollups.
+		// Slots are period ms long, values are stored as value * scale, clamped to 16 bits
+		WebHistory(historySlot *slots, uint16_t count, historyRollup *rollups, uint32_t period, float scale, uint8_t mode);
+
+		// Close the slots that ended before now
+		void advance(uint32_t now);
+		// Check if a sample is wanted, that is the current slot has none yet
+		bool wantsSample();
+		// Add a sample to the current slot
+		void sample(float value, uint32_t now);
+		// Widen the minimum and maximum of the current slot to values seen between samples, without changing the average
+		void widen(float min, float max);
+		// Sampling mode (historyModes)
+		uint8_t mode();
+		// Time covered by all slots, in s rounded up. At most UINT32_MAX / 1000, so it converts to ms
+		uint32_t span();
+
+		// Print the last window ms, downsampled to points lines of "age min max avg", oldest first.
+		// Age is the ms since the end of the point. Prints nothing before the first slot is closed. Returns the bytes printed
+		size_t print(Print &output, uint32_t window, uint16_t points, uint32_t now);
+
+	private:
+		// Slot ring
+		historySlot *_slots;
+		// Number of slots
+		const uint16_t _count;
+		// Rollup rings, level after level
+		historyRollup *_rollups;
+		// Number of rollup levels
+		uint8_t _levels = 0;
+		// Slot length, in ms
+		const uint32_t _period;
+		// Fixed point scale
+		const float _scale;
+		// Sampling mode
+		const uint8_t _mode;
+
+		// Time slot 0 started, in ms
+		uint32_t _start = 0;
+		// Number of closed slots, the current slot is _closed
+		uint32_t _closed = 0;
+		// A sample has been taken
+		bool _started = false;
+		// Current slot, as a rollup of its samples
+		historyRollup _current = {};
+		// Last value, held by slots without samples
+		int16_t _held = 0;
+
+		// Convert a value to fixed point
+		int16_t toFixed(float value);
+		// Length of the rollup ring of level (1 and up)
+		uint16_t levelLength(uint8_t level);
+		// Close the current slot and start the next
+		void closeSlot();
+		// Summary of the closed slots from first to last (exclusive), from the coarsest rollups that fit
+		historyRollup summarise(uint32_t first, uint32_t last);
+};
+
+// History with its storage, e.g. keywordHistory<360> temperatureHistory(10000, 100) for an hour of 10 s slots with 0.01 resolution
+template <uint16_t Slots>
+class keywordHistory : public WebHistory {
+	public:
+		keywordHistory(uint32_t period, float scale = 1, uint8_t mode = historyPeriodic) : WebHistory(_slotStorage, Slots, _rollupStorage, period, scale, mode) {}
+
+	private:
+		historySlot _slotStorage[Slots];
+		historyRollup _rollupStorage[historyRollupSize(Slots, historyFanout) + 1];
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,104 @@
+/*
+ * WebLog is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+#include "Arduino.h"
+#include "WebLog.h"
+
+// Ring buffer storage
+webLogLine WebLog::_lines[webLogLines];
+std::atomic<uint32_t> WebLog::_head(0);
+uint32_t WebLog::_drained = 0;
+
+//*************************************************************
+// Public functions
+//*************************************************************
+
+// Format a line into the ring buffer
+void WebLog::write(char level, const char *format, ...) {
+	// Claim a sequence number, and with it a line
+	uint32_t sequence = _head.fetch_add(1, std::memory_order_relaxed);
+	webLogLine *line = &_lines[sequence % webLogLines];
+	// Mark line as being written
+	line->sequence.store(0, std::memory_order_release);
+	int length = snprintf(line->text, webLogLineLength, "[%lu] %c ", (unsigned long)millis(), level);
+	if (length > 0 && length < webLogLineLength) {
+		va_list args;
+		va_start(args, format);
+		vsnprintf(line->text + length, webLogLineLength - length, format, args);
+		va_end(args);
+	}
+	// Publish the line
+	line->sequence.store(sequence + 1, std::memory_order_release);
+}
+
+// Print lines written since the last drain to out
+void WebLog::drain(Print &out) {
+	_drained = printFrom(out, _drained);
+}
+
+// Print the lines held in the ring buffer to out
+void WebLog::print(Print &out) {
+	uint32_t head = _head.load(std::memory_order_acquire);
+	printFrom(out, head > webLogLines ? head - webLogLines : 0);
+}
+
+//*************************************************************
+// Private functions
+//*************************************************************
+
+// Print lines from sequence number first up to head
+uint32_t WebLog::printFrom(Print &out, uint32_t first) {
+	uint32_t head = _head.load(std::memory_order_acquire);
+	// Lines older than the ring buffer are lost
+	if (head - first > webLogLines) {
+		first = head - webLogLines;
+	}
+	char text[webLogLineLength];
+	for (uint32_t sequence = first; sequence != head; sequence++) {
+		webLogLine *line = &_lines[sequence % webLogLines];
+		uint32_t written = line->sequence.load(std::memory_order_acquire);
+		// Stop at a line still being written, it is printed on the next call
+		if (written == 0) {
+			return sequence;
+		}
+		// Skip lines already overwritten
+		if (written != sequence + 1) {
+			continue;
+		}
+		memcpy(text, line->text, webLogLineLength);
+		// Skip the line if it was overwritten while copying
+		if (line->sequence.load(std::memory_order_acquire) != sequence + 1) {
+			continue;
+		}
+		text[webLogLineLength - 1] = '\0';
+		out.println(text);
+	}
+	return head;
+}
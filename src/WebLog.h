@@ -0,0 +1,103 @@
+/*
+ * WebLog is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+// Ensure the library is only included once
+#ifndef _WebLog_
+#define _WebLog_
+
+#include "Arduino.h"
+#include <atomic>
+
+// Log levels
+#define webLogLevelNone 0
+#define webLogLevelError 1
+#define webLogLevelInfo 2
+#define webLogLevelDebug 3
+
+// Compile time log level, set with a build flag (-DwebLogLevel=3). Statements above the level are removed entirely
+#ifndef webLogLevel
+#define webLogLevel webLogLevelError
+#endif
+
+// Number of lines kept in the ring buffer
+#ifndef webLogLines
+#define webLogLines 32
+#endif
+// Maximum length of a line, longer lines are truncated
+#ifndef webLogLineLength
+#define webLogLineLength 96
+#endif
+
+// Logging statements, printf style
+#if webLogLevel >= webLogLevelError
+#define webLogError(...) WebLog::write('E', __VA_ARGS__)
+#else
+#define webLogError(...) do {} while (0)
+#endif
+#if webLogLevel >= webLogLevelInfo
+#define webLogInfo(...) WebLog::write('I', __VA_ARGS__)
+#else
+#define webLogInfo(...) do {} while (0)
+#endif
+#if webLogLevel >= webLogLevelDebug
+#define webLogDebug(...) WebLog::write('D', __VA_ARGS__)
+#else
+#define webLogDebug(...) do {} while (0)
+#endif
+
+// A line in the ring buffer
+struct webLogLine {
+	std::atomic<uint32_t> sequence; // Sequence number + 1 of the line held, 0 while being written
+	char text[webLogLineLength]; // Line text
+};
+
+// Lock-free ring buffer of log lines. Writers never block, the oldest lines are overwritten.
+// Lines are printed by drain(), off the request path (webManager::poll()).
+class WebLog {
+	public:
+		// Format a line into the ring buffer
+		static void write(char level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+		// Print lines written since the last drain to out
+		static void drain(Print &out);
+		// Print the lines held in the ring buffer to out
+		static void print(Print &out);
+
+	private:
+		// Ring buffer
+		static webLogLine _lines[webLogLines];
+		// Sequence number of the next line
+		static std::atomic<uint32_t> _head;
+		// Sequence number of the next line to drain
+		static uint32_t _drained;
+
+		// Print lines from sequence number first up to head, returns sequence number after the last line
+		static uint32_t printFrom(Print &out, uint32_t first);
+};
+#endif
@@ -0,0 +1,133 @@
+/*
+ * WebMetrics is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+#include "WebMetrics.h"
+#include "esp_heap_caps.h"
+
+// Latency bucket upper bounds, in ms
+static const uint16_t latencyBounds[metricsLatencyBuckets] = {5, 10, 25, 50, 100, 250, 500, 1000};
+
+//*************************************************************
+// Public functions
+//*************************************************************
+
+// Constructor
+WebMetrics::WebMetrics(uint8_t routes) : _count(routes) {
+	_routes = new routeMetrics[routes]();
+}
+
+// Destructor
+WebMetrics::~WebMetrics() {
+	delete[] _routes;
+}
+
+// Name a route
+void WebMetrics::setRoute(uint8_t index, const char *name) {
+	if (index < _count) {
+		_routes[index].route = name;
+	}
+}
+
+// Record a finished request
+void WebMetrics::record(uint8_t index, uint16_t code, size_t bytes, uint32_t micros) {
+	if (index >= _count) {
+		return;
+	}
+	routeMetrics *metrics = &_routes[index];
+	uint32_t ms = micros / 1000;
+	uint8_t bucket = 0;
+	while (bucket < metricsLatencyBuckets && ms > latencyBounds[bucket]) {
+		bucket++;
+	}
+	metrics->requests++;
+	if (code >= 400) {
+		metrics->errors++;
+	}
+	metrics->bytesSent += bytes;
+	metrics->latency[bucket]++;
+	metrics->latencySum += ms;
+}
+
+// Count a request that could not be tracked
+void WebMetrics::untracked() {
+	_untracked++;
+}
+
+// Sample heap headroom
+void WebMetrics::sampleHeap() {
+	uint32_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+	if (largest < _minLargestBlock) {
+		_minLargestBlock = largest;
+	}
+}
+
+// Get the counters of a route
+const routeMetrics *WebMetrics::route(uint8_t index) {
+	return index < _count ? &_routes[index] : nullptr;
+}
+
+// Print all metrics in the Prometheus text format
+void WebMetrics::print(Print &output) {
+	sampleHeap();
+	output.print("# TYPE webmanager_requests_total counter\n");
+	for (uint8_t i = 0; i < _count; i++) {
+		output.printf("webmanager_requests_total{route=\"%s\"} %lu\n", _routes[i].route, (unsigned long)_routes[i].requests);
+	}
+	output.print("# TYPE webmanager_errors_total counter\n");
+	for (uint8_t i = 0; i < _count; i++) {
+		output.printf("webmanager_errors_total{route=\"%s\"} %lu\n", _routes[i].route, (unsigned long)_routes[i].errors);
+	}
+	output.print("# TYPE webmanager_sent_bytes_total counter\n");
+	for (uint8_t i = 0; i < _count; i++) {
+		output.printf("webmanager_sent_bytes_total{route=\"%s\"} %lu\n", _routes[i].route, (unsigned long)_routes[i].bytesSent);
+	}
+	// Histogram buckets are cumulative
+	output.print("# TYPE webmanager_request_duration_ms histogram\n");
+	for (uint8_t i = 0; i < _count; i++) {
+		const routeMetrics *metrics = &_routes[i];
+		uint32_t cumulative = 0;
+		for (uint8_t bucket = 0; bucket < metricsLatencyBuckets; bucket++) {
+			cumulative += metrics->latency[bucket];
+			output.printf("webmanager_request_duration_ms_bucket{route=\"%s\",le=\"%u\"} %lu\n", metrics->route, latencyBounds[bucket], (unsigned long)cumulative);
+		}
+		cumulative += metrics->latency[metricsLatencyBuckets];
+		output.printf("webmanager_request_duration_ms_bucket{route=\"%s\",le=\"+Inf\"} %lu\n", metrics->route, (unsigned long)cumulative);
+		output.printf("webmanager_request_duration_ms_sum{route=\"%s\"} %lu\n", metrics->route, (unsigned long)metrics->latencySum);
+		output.printf("webmanager_request_duration_ms_count{route=\"%s\"} %lu\n", metrics->route, (unsigned long)cumulative);
+	}
+	output.print("# TYPE webmanager_untracked_requests_total counter\n");
+	output.printf("webmanager_untracked_requests_total %lu\n", (unsigned long)_untracked);
+	output.print("# TYPE webmanager_heap_free_bytes gauge\n");
+	output.printf("webmanager_heap_free_bytes %lu\n", (unsigned long)ESP.getFreeHeap());
+	output.print("# TYPE webmanager_heap_free_min_bytes gauge\n");
+	output.printf("webmanager_heap_free_min_bytes %lu\n", (unsigned long)ESP.getMinFreeHeap());
+	output.print("# TYPE webmanager_heap_largest_block_min_bytes gauge\n");
+	output.printf("webmanager_heap_largest_block_min_bytes %lu\n", (unsigned long)_minLargestBlock);
+}
\ No newline at end of file
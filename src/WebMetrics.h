@@ -0,0 +1,84 @@
+/*
+ * WebMetrics is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+// Ensure the library is only included once
+#ifndef _WebMetrics_
+#define _WebMetrics_
+
+#include "Arduino.h"
+
+// Number of latency histogram buckets, not counting the +Inf bucket
+#define metricsLatencyBuckets 8
+
+// Counters of a route
+struct routeMetrics {
+	const char *route; // The web path of the route, used as label
+	uint32_t requests; // Number of requests
+	uint32_t errors; // Number of responses with code 400 or above
+	uint32_t bytesSent; // Response body bytes sent, where the size is known
+	uint32_t latency[metricsLatencyBuckets + 1]; // Requests per latency bucket, the last bucket is above the largest bound
+	uint32_t latencySum; // Sum of latencies, in ms
+};
+
+// Request counters, latency histograms and heap watermarks, exported in the Prometheus text format.
+// Counters are only written from the async web server task, as plain word-sized stores with no locks
+// or allocation, so recording is cheap enough to leave on.
+class WebMetrics {
+	public:
+		// Constructor, with room for the given number of routes
+		WebMetrics(uint8_t routes);
+		// Destructor
+		~WebMetrics();
+
+		// Name a route, name must outlive the metrics
+		void setRoute(uint8_t index, const char *name);
+		// Record a finished request
+		void record(uint8_t index, uint16_t code, size_t bytes, uint32_t micros);
+		// Count a request that could not be tracked
+		void untracked();
+		// Sample heap headroom, keeping the minimum
+		void sampleHeap();
+
+		// Get the counters of a route, nullptr if out of range
+		const routeMetrics *route(uint8_t index);
+		// Print all metrics in the Prometheus text format
+		void print(Print &output);
+
+	private:
+		// Counters for each route
+		routeMetrics *_routes;
+		// Number of routes
+		const uint8_t _count;
+		// Requests not tracked, as all tracking slots were in use
+		uint32_t _untracked = 0;
+		// Smallest largest-free-block seen, in bytes
+		uint32_t _minLargestBlock = UINT32_MAX;
+};
+#endif
\ No newline at end of file
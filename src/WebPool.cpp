@@ -0,0 +1,127 @@
+/*
+ * WebPool is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+#include "WebPool.h"
+
+//*************************************************************
+// Public functions
+//*************************************************************
+
+// Constructor
+WebPool::WebPool(const uint16_t *sizes, const uint8_t *blocks, uint8_t classes) {
+	_count = (classes < poolMaxClasses) ? classes : poolMaxClasses;
+	for (uint8_t i = 0; i < _count; i++) {
+		poolClass *sizeClass = &_classes[i];
+		// Blocks hold the free list pointer, and stay aligned for any value
+		sizeClass->size = (sizes[i] < sizeof(void*)) ? sizeof(void*) : (sizes[i] + 3) & ~3;
+		sizeClass->memory = (uint8_t*)malloc((size_t)sizeClass->size * blocks[i]);
+		if (sizeClass->memory == nullptr) {
+			continue;
+		}
+		sizeClass->blocks = blocks[i];
+		// Chain all blocks into the free list
+		for (uint8_t block = 0; block < sizeClass->blocks; block++) {
+			void *buffer = sizeClass->memory + (size_t)block * sizeClass->size;
+			*(void**)buffer = sizeClass->free;
+			sizeClass->free = buffer;
+		}
+	}
+}
+
+// Destructor
+WebPool::~WebPool() {
+	for (uint8_t i = 0; i < _count; i++) {
+		free(_classes[i].memory);
+	}
+}
+
+// Get a buffer of at least size bytes
+void *WebPool::allocate(size_t size) {
+	for (uint8_t i = 0; i < _count; i++) {
+		poolClass *sizeClass = &_classes[i];
+		if (size <= sizeClass->size && sizeClass->free != nullptr) {
+			void *buffer = sizeClass->free;
+			sizeClass->free = *(void**)buffer;
+			sizeClass->used++;
+			if (sizeClass->used > sizeClass->peak) {
+				sizeClass->peak = sizeClass->used;
+			}
+			return buffer;
+		}
+	}
+	_misses++;
+	return malloc(size);
+}
+
+// Return a buffer from allocate()
+void WebPool::release(void *buffer) {
+	if (buffer == nullptr) {
+		return;
+	}
+	poolClass *sizeClass = owner(buffer);
+	if (sizeClass == nullptr) {
+		free(buffer);
+		return;
+	}
+	*(void**)buffer = sizeClass->free;
+	sizeClass->free = buffer;
+	sizeClass->used--;
+}
+
+// Number of size classes
+uint8_t WebPool::classes() {
+	return _count;
+}
+
+// Get a size class
+const poolClass *WebPool::sizeClass(uint8_t index) {
+	return index < _count ? &_classes[index] : nullptr;
+}
+
+// Number of buffers taken from the heap
+uint32_t WebPool::misses() {
+	return _misses;
+}
+
+//*************************************************************
+// Private functions
+//*************************************************************
+
+// Get the class a buffer belongs to
+poolClass *WebPool::owner(void *buffer) {
+	uint8_t *address = (uint8_t*)buffer;
+	for (uint8_t i = 0; i < _count; i++) {
+		poolClass *sizeClass = &_classes[i];
+		if (sizeClass->memory != nullptr && address >= sizeClass->memory && address < sizeClass->memory + (size_t)sizeClass->size * sizeClass->blocks) {
+			return sizeClass;
+		}
+	}
+	return nullptr;
+}
\ No newline at end of file
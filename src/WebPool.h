@@ -0,0 +1,91 @@
+/*
+ * WebPool is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+// Ensure the library is only included once
+#ifndef _WebPool_
+#define _WebPool_
+
+#include "Arduino.h"
+
+// Maximum number of size classes
+#define poolMaxClasses 4
+// Default size classes, in bytes, with the default number of blocks of each
+#define defaultPoolSmall 128
+#define defaultPoolSmallBlocks 8
+#define defaultPoolMedium 512
+#define defaultPoolMediumBlocks 4
+#define defaultPoolLarge 2048
+#define defaultPoolLargeBlocks 2
+
+// A size class, blocks of one size carved from a single allocation
+struct poolClass {
+	uint16_t size; // Block size, in bytes
+	uint8_t blocks; // Number of blocks
+	uint8_t used; // Blocks handed out
+	uint8_t peak; // Most blocks handed out at once
+	uint8_t *memory; // The blocks, nullptr if the allocation failed
+	void *free; // Free list, each free block holds the pointer to the next
+};
+
+// Pool of fixed size buffers for request scratch memory. The blocks are allocated once, so buffers that come and go
+// with each request do not fragment the heap. Both allocate() and release() are O(1). Requests that do not fit a free
+// block fall back to the heap, and are counted as misses.
+// Only used from the async web server task, so it needs no locking
+class WebPool {
+	public:
+		// Constructor, sizes and blocks list the size classes, smallest first
+		WebPool(const uint16_t *sizes, const uint8_t *blocks, uint8_t classes);
+		// Destructor
+		~WebPool();
+
+		// Get a buffer of at least size bytes, from the smallest class with a free block, else from the heap. nullptr if out of memory
+		void *allocate(size_t size);
+		// Return a buffer from allocate()
+		void release(void *buffer);
+
+		// Number of size classes
+		uint8_t classes();
+		// Get a size class (for block counts), nullptr if index is out of range
+		const poolClass *sizeClass(uint8_t index);
+		// Number of buffers taken from the heap, because no block was free or large enough
+		uint32_t misses();
+
+	private:
+		// Size classes
+		poolClass _classes[poolMaxClasses] = {};
+		// Number of size classes
+		uint8_t _count = 0;
+		// Heap fallbacks
+		uint32_t _misses = 0;
+
+		// Get the class a buffer belongs to, nullptr if it is from the heap
+		poolClass *owner(void *buffer);
+};
+#endif
\ No newline at end of file
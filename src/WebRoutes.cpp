@@ -0,0 +1,169 @@
+/*
+ * WebRoutes is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+#include "WebRoutes.h"
+
+// Order routes by match type, then path (shorter first on a common start)
+static int compareRoute(const webRoute *route, uint8_t match, const char *path, size_t length) {
+	if (route->match != match) {
+		return (route->match < match) ? -1 : 1;
+	}
+	size_t common = (route->length < length) ? route->length : length;
+	int result = strncmp(route->path, path, common);
+	if (result != 0) {
+		return result;
+	}
+	if (route->length == length) {
+		return 0;
+	}
+	return (route->length < length) ? -1 : 1;
+}
+
+//*************************************************************
+// Public functions
+//*************************************************************
+
+// Constructor
+WebRoutes::WebRoutes(uint8_t maxRoutes) : _maxRoutes(maxRoutes) {
+	_routes = new webRoute[maxRoutes];
+}
+
+// Destructor
+WebRoutes::~WebRoutes() {
+	delete[] _routes;
+}
+
+// Add a route
+bool WebRoutes::add(const char *path, uint8_t methods, uint8_t target) {
+	if (_count >= _maxRoutes) {
+		return false;
+	}
+	size_t length = strlen(path);
+	const char *wildcard = strchr(path, '*');
+	if (wildcard == nullptr) {
+		_routes[_count] = {path, (uint16_t)length, routeExact, methods, target};
+	} else if (strncmp(path, "/*.", 3) == 0 && strchr(path + 2, '*') == nullptr) {
+		// "/*.ext" matches paths ending in the extension, from its last '.' as ESPAsyncWebServer
+		const char *extension = strrchr(path, '.');
+		_routes[_count] = {extension, (uint16_t)(path + length - extension), routeExtension, methods, target};
+		_extensions = true;
+	} else if (wildcard == path + length - 1) {
+		// "/path/*" and "/prefix*" match paths starting with everything before the '*'
+		_routes[_count] = {path, (uint16_t)(length - 1), routePrefix, methods, target};
+		_prefixLengths |= 1ULL << ((length - 1 < 63) ? length - 1 : 63);
+	} else {
+		webLogError("WebRoutes::add(), Unsupported route pattern: %s", path);
+		return false;
+	}
+	_count++;
+	return true;
+}
+
+// Sort the index
+void WebRoutes::build() {
+	// Insertion sort, stable so routes of the same path keep their order. Only run once at begin()
+	for (uint8_t i = 1; i < _count; i++) {
+		webRoute route = _routes[i];
+		uint8_t j = i;
+		while (j > 0 && compareRoute(&_routes[j - 1], route.match, route.path, route.length) > 0) {
+			_routes[j] = _routes[j - 1];
+			j--;
+		}
+		_routes[j] = route;
+	}
+}
+
+// Find the route of a path and request method
+int16_t WebRoutes::match(const char *path, size_t length, uint8_t method) {
+	int16_t found = search(routeExact, path, length, method);
+	if (found >= 0) {
+		return found;
+	}
+	// Try each start of the path, longest first: prefix routes of that length, and exact routes followed by a slash
+	for (size_t i = length; i > 0; i--) {
+		if ((_prefixLengths & (1ULL << ((i < 63) ? i : 63))) != 0) {
+			found = search(routePrefix, path, i, method);
+			if (found >= 0) {
+				return found;
+			}
+		}
+		if (path[i - 1] == '/' && i > 1) {
+			found = search(routeExact, path, i - 1, method);
+			if (found >= 0) {
+				return found;
+			}
+		}
+	}
+	// Extensions last, from the last '.' of the path
+	if (_extensions) {
+		for (size_t i = length; i > 0; i--) {
+			if (path[i - 1] == '.') {
+				return search(routeExtension, path + i - 1, length - i + 1, method);
+			}
+		}
+	}
+	return -1;
+}
+
+// Number of routes
+uint8_t WebRoutes::routes() {
+	return _count;
+}
+
+//*************************************************************
+// Private functions
+//*************************************************************
+
+// Binary search for a route of match type, with exact path and accepting method
+int16_t WebRoutes::search(uint8_t match, const char *path, size_t length, uint8_t method) {
+	int16_t low = 0;
+	int16_t high = (int16_t)_count - 1;
+	while (low <= high) {
+		int16_t middle = (low + high) / 2;
+		int result = compareRoute(&_routes[middle], match, path, length);
+		if (result == 0) {
+			// Routes of the same path are next to each other, take the first accepting method
+			while (middle > 0 && compareRoute(&_routes[middle - 1], match, path, length) == 0) {
+				middle--;
+			}
+			for (; middle < _count && compareRoute(&_routes[middle], match, path, length) == 0; middle++) {
+				if (_routes[middle].methods & method) {
+					return _routes[middle].target;
+				}
+			}
+			return -1;
+		} else if (result > 0) {
+			high = middle - 1;
+		} else {
+			low = middle + 1;
+		}
+	}
+	return -1;
+}
\ No newline at end of file
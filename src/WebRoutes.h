@@ -0,0 +1,89 @@
+/*
+ * WebRoutes is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+// Ensure the library is only included once
+#ifndef _WebRoutes_
+#define _WebRoutes_
+
+#include "Arduino.h"
+#include "WebLog.h"
+
+// How a route matches a request path, as the patterns of ESPAsyncWebServer
+typedef enum {
+	routeExact, // "/path", the path is the route path, or the route path, a slash and anything after it
+	routePrefix, // "/path/*" or "/prefix*", the path starts with the route path (up to the '*')
+	routeExtension // "/*.ext", the path ends with the extension
+} routeMatches;
+
+// A route in the index
+struct webRoute {
+	const char *path; // Route path, not null terminated for prefix routes. The extension (".ext") for extension routes
+	uint16_t length; // Length of the route path
+	uint8_t match; // How the route matches (routeMatches)
+	uint8_t methods; // Request methods the route accepts (bit mask)
+	uint8_t target; // Value returned on a match, such as the web content entry index
+};
+
+// Route index, sorted once so a path is matched by binary search instead of trying every route.
+// An exact match wins, then the longest match of a prefix or of an exact route followed by a slash, then extensions
+class WebRoutes {
+	public:
+		// Constructor, with room for maxRoutes routes
+		WebRoutes(uint8_t maxRoutes);
+		// Destructor
+		~WebRoutes();
+
+		// Add a route, "/path", "/path/*", "/prefix*" or "/*.ext". The path must outlive the index.
+		// Returns false if full, or if the path has a '*' elsewhere
+		bool add(const char *path, uint8_t methods, uint8_t target);
+		// Sort the index, call after adding all routes and before matching
+		void build();
+		// Find the route of a path and request method, returns its target or -1 if no route matches
+		int16_t match(const char *path, size_t length, uint8_t method);
+
+		// Number of routes
+		uint8_t routes();
+
+	private:
+		// Routes, sorted by match type and path
+		webRoute *_routes;
+		// Number of routes added
+		uint8_t _count = 0;
+		// Room for routes
+		const uint8_t _maxRoutes;
+		// Lengths of prefix routes, bit n for length n (lengths of 63 and up share bit 63), so a match only searches those
+		uint64_t _prefixLengths = 0;
+		// There are extension routes
+		bool _extensions = false;
+
+		// Binary search for a route of match type, with exact path and accepting method
+		int16_t search(uint8_t match, const char *path, size_t length, uint8_t method);
+};
+#endif
\ No newline at end of file
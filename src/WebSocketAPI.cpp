@@ -0,0 +1,206 @@
+/*
+ * WebSocketAPI is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+#include "WebSocketAPI.h"
+
+//*************************************************************
+// Public functions
+//*************************************************************
+
+// Constructor
+WebSocketAPI::WebSocketAPI(WebAPI *api, const char *path, uint16_t interval) : _api(api), _interval(interval) {
+	_socket = new AsyncWebSocket(path);
+	_socket->onEvent([this](AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t length){
+		this->onEvent(client, type, arg, data, length);
+	});
+	// Changes made before any client connects are sent with the subscribe reply
+	_sentGeneration = _api->generation();
+}
+
+// Destructor
+WebSocketAPI::~WebSocketAPI() {
+	delete _socket;
+}
+
+// Get the WebSocket handler
+AsyncWebSocket *WebSocketAPI::handler() {
+	return _socket;
+}
+
+// Send changes of subscribed keywords
+void WebSocketAPI::poll() {
+	if (millis() - _lastSend < _interval) {
+		return;
+	}
+	_lastSend = millis();
+	// Free the slots of clients that are gone
+	_socket->cleanupClients(socketMaxClients);
+	uint32_t generation = _api->generation();
+	if (generation == _sentGeneration) {
+		return;
+	}
+	// Find the changed keywords once, then each client only takes the bitwise and with its subscriptions
+	keywordSet changed = {};
+	_api->changedKeywords(_sentGeneration, &changed);
+	_sentGeneration = generation;
+	for (uint8_t i = 0; i < socketMaxClients; i++) {
+		socketClient *slot = &_clients[i];
+		if (slot->id == 0) {
+			continue;
+		}
+		keywordSet selected;
+		bool any = false;
+		for (uint8_t word = 0; word < keywordSetWords; word++) {
+			selected.words[word] = changed.words[word] & slot->subscribed.words[word];
+			any = any || selected.words[word] != 0;
+		}
+		if (any) {
+			String frame = "values " + _api->selectedValues(&selected);
+			_socket->text(slot->id, frame.c_str(), frame.length());
+		}
+	}
+}
+
+// Number of connected clients
+uint8_t WebSocketAPI::clients() {
+	return _socket->count();
+}
+
+//*************************************************************
+// Private functions
+//*************************************************************
+
+// Handle a WebSocket event
+void WebSocketAPI::onEvent(AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t length) {
+	switch (type) {
+		case WS_EVT_CONNECT: {
+			socketClient *slot = findClient(0);
+			if (slot == nullptr) {
+				webLogInfo("WebSocketAPI::onEvent(), No slot for client %lu", (unsigned long)client->id());
+				client->close(1013, "Too many clients");
+				return;
+			}
+			// Clear the subscriptions before the slot is taken, as poll() reads taken slots
+			memset(&slot->subscribed, 0, sizeof(slot->subscribed));
+			slot->id = client->id();
+		} break;
+		case WS_EVT_DISCONNECT: {
+			socketClient *slot = findClient(client->id());
+			if (slot != nullptr) {
+				slot->id = 0;
+			}
+		} break;
+		case WS_EVT_DATA: {
+			socketClient *slot = findClient(client->id());
+			AwsFrameInfo *info = (AwsFrameInfo*)arg;
+			// Commands are single text frames
+			if (slot == nullptr || !info->final || info->index != 0 || info->len != length || info->opcode != WS_TEXT) {
+				client->text("error Unsupported frame");
+				return;
+			}
+			if (length >= socketMaxMessage) {
+				client->text("error Command too long");
+				return;
+			}
+			char command[socketMaxMessage];
+			memcpy(command, data, length);
+			command[length] = '\0';
+			handleCommand(client, slot, command);
+		} break;
+		default:
+			break;
+	}
+}
+
+// Handle a command of a client
+void WebSocketAPI::handleCommand(AsyncWebSocketClient *client, socketClient *slot, char *command) {
+	// Split the command name from its argument
+	char *argument = strchr(command, ' ');
+	if (argument != nullptr) {
+		*argument++ = '\0';
+	} else {
+		argument = command + strlen(command);
+	}
+	webLogDebug("WebSocketAPI::handleCommand(), Client %lu: %s %s", (unsigned long)client->id(), command, argument);
+	if (strcmp(command, "sub") == 0 || strcmp(command, "unsub") == 0) {
+		// Collect the matches of all patterns, space separated
+		keywordSet matched = {};
+		char *next;
+		for (char *pattern = strtok_r(argument, " ", &next); pattern != nullptr; pattern = strtok_r(nullptr, " ", &next)) {
+			if (_api->matchKeywords(pattern, strlen(pattern), &matched) == 0) {
+				String error = String("error Unknown keyword ") + pattern;
+				client->text(error);
+			}
+		}
+		bool subscribe = command[0] == 's';
+		for (uint8_t word = 0; word < keywordSetWords; word++) {
+			if (subscribe) {
+				slot->subscribed.words[word] |= matched.words[word];
+			} else {
+				slot->subscribed.words[word] &= ~matched.words[word];
+			}
+		}
+		// New subscriptions start with the current values
+		if (subscribe) {
+			String frame = "values " + _api->selectedValues(&matched);
+			client->text(frame);
+		}
+	} else if (strcmp(command, "set") == 0 || strcmp(command, "get") == 0) {
+		// Same request as "/api/keyword=value" and "/api/keyword"
+		if ((command[0] == 's') != (strchr(argument, '=') != nullptr)) {
+			client->text("error Bad request");
+			return;
+		}
+		valueLock lock(_api);
+		char buffer[valueTextSize];
+		apiReply reply = _api->requestHandler(argument, buffer);
+		size_t nameLength = strcspn(argument, "=");
+		String frame = command;
+		frame += ' ';
+		frame.concat(argument, nameLength);
+		frame += ':';
+		frame += reply.responseCode;
+		frame += ':';
+		frame.concat(reply.text, reply.length);
+		client->text(frame);
+	} else {
+		client->text("error Unknown command");
+	}
+}
+
+// Get the slot of a client id
+socketClient *WebSocketAPI::findClient(uint32_t id) {
+	for (uint8_t i = 0; i < socketMaxClients; i++) {
+		if (_clients[i].id == id) {
+			return &_clients[i];
+		}
+	}
+	return nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+/*
+ * WebSocketAPI is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+// Ensure the library is only included once
+#ifndef _WebSocketAPI_
+#define _WebSocketAPI_
+
+#include "Arduino.h"
+#include "ESPAsyncWebServer.h"
+#include "WebAPI.h"
+#include "WebLog.h"
+
+// Maximum number of connected clients, more are closed on connect
+#define socketMaxClients 8
+// Maximum length of a command, in bytes
+#define socketMaxMessage 256
+
+// Subscriptions of a connected client
+struct socketClient {
+	uint32_t id; // WebSocket client id, 0 for a free slot
+	keywordSet subscribed; // Subscribed keywords
+};
+
+// Keyword API over a WebSocket. Clients send text commands:
+//   "sub LED1State Temp*"   subscribe to keywords and prefix groups, replied with "values ..." of their current values
+//   "unsub Temp*"           unsubscribe
+//   "set LED1State=1"       set a keyword, replied with "set LED1State:200:Ok"
+//   "get LED1State"         get a keyword, replied with "get LED1State:200:1"
+// Changes of subscribed keywords are sent as one "values keyword=value&keyword=value" frame per client per interval.
+// Errors are sent as "error text"
+class WebSocketAPI {
+	public:
+		// Constructor, the socket is served on path, add handler() to the server
+		WebSocketAPI(WebAPI *api, const char *path, uint16_t interval);
+		// Destructor
+		~WebSocketAPI();
+
+		// Get the WebSocket handler
+		AsyncWebSocket *handler();
+		// Send changes of subscribed keywords, at most once per interval. Call from the application loop
+		void poll();
+		// Number of connected clients
+		uint8_t clients();
+
+	private:
+		// The keyword API
+		WebAPI *_api;
+		// The WebSocket
+		AsyncWebSocket *_socket;
+		// Interval between change frames, in ms
+		const uint16_t _interval;
+		// Time of the last change frames
+		uint32_t _lastSend = 0;
+		// Change generation sent in the last change frames
+		uint32_t _sentGeneration = 0;
+		// Client slots, written by the web server task, read by poll()
+		socketClient _clients[socketMaxClients] = {};
+
+		// Handle a WebSocket event
+		void onEvent(AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t length);
+		// Handle a command of a client
+		void handleCommand(AsyncWebSocketClient *client, socketClient *slot, char *command);
+		// Get the slot of a client id, nullptr if none. Id 0 finds a free slot
+		socketClient *findClient(uint32_t id);
+};
+#endif
\ No newline at end of file
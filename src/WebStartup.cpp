@@ -0,0 +1,152 @@
+/*
+ * WebStartup is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+#include "WebStartup.h"
+#include "WebLog.h"
+
+// Phase names, for logging. Only defined when info statements are compiled in
+#if webLogLevel >= webLogLevelInfo
+static const char *phaseNames[phaseCount] = {"SPIFFS", "routes", "WiFi", "MDNS"};
+#endif
+
+//*************************************************************
+// Public functions
+//*************************************************************
+
+// Constructor
+WebStartup::WebStartup(WebNetwork *network) : _network(network) {}
+
+// Set callback for phase changes
+void WebStartup::onPhase(startupCallback callback) {
+	_callback = callback;
+}
+
+// Start connecting
+void WebStartup::connect(const char *ssid, const char *password, const char *hostname) {
+	_ssid = ssid;
+	_password = password;
+	_hostname = hostname;
+	started(phaseWiFi);
+	_network->connect(_ssid, _password);
+}
+
+// Mark phase as started
+void WebStartup::started(uint8_t phase) {
+	_states[phase] = phaseRunning;
+	_started[phase] = millis();
+}
+
+// Mark phase as done, or failed
+void WebStartup::finished(uint8_t phase, bool success) {
+	_states[phase] = success ? phaseDone : phaseFailed;
+	_finished[phase] = millis();
+	webLogInfo("WebStartup::finished(), %s %s after %lu ms", phaseNames[phase], success ? "done" : "failed", (unsigned long)duration(phase));
+	if (_callback != nullptr) {
+		_callback(phase, _states[phase], duration(phase));
+	}
+}
+
+// Network event, an IP address was assigned
+void WebStartup::connected() {
+	_connectedEvent.store(true, std::memory_order_release);
+}
+
+// Network event, the connection was lost or could not be made
+void WebStartup::disconnected() {
+	_disconnectedEvent.store(true, std::memory_order_release);
+}
+
+// Advance the state machine
+void WebStartup::poll() {
+	uint32_t now = millis();
+	// Connection lost or failed, retry after a growing delay
+	if (_disconnectedEvent.exchange(false, std::memory_order_acq_rel) && !_reconnecting) {
+		if (_states[phaseWiFi] == phaseDone) {
+			// Lost an established connection, WiFi is starting over
+			finished(phaseWiFi, false);
+			started(phaseWiFi);
+		}
+		_reconnecting = true;
+		_reconnectAt = now + _reconnectDelay;
+		webLogInfo("WebStartup::poll(), WiFi disconnected, reconnecting in %lu ms", (unsigned long)_reconnectDelay);
+		_reconnectDelay = (_reconnectDelay * 2 > maxReconnectDelay) ? maxReconnectDelay : _reconnectDelay * 2;
+	}
+	// Connected, after the disconnect so the latest event wins
+	if (_connectedEvent.exchange(false, std::memory_order_acq_rel)) {
+		_reconnecting = false;
+		_reconnectDelay = defaultReconnectDelay;
+		_attempts = 0;
+		if (_states[phaseWiFi] == phaseRunning) {
+			finished(phaseWiFi, true);
+		}
+		// MDNS needs an IP address
+		if (_hostname != nullptr && _states[phaseMDNS] == phasePending) {
+			started(phaseMDNS);
+			finished(phaseMDNS, _network->startMDNS(_hostname));
+		}
+	}
+	// Reconnect once the delay is over
+	if (_reconnecting && (int32_t)(now - _reconnectAt) >= 0) {
+		_reconnecting = false;
+		_attempts++;
+		_network->connect(_ssid, _password);
+	}
+}
+
+// Check if all phases are done
+bool WebStartup::ready() {
+	for (uint8_t i = 0; i < phaseCount; i++) {
+		// MDNS is only started when a hostname is given
+		if (_states[i] != phaseDone && !(i == phaseMDNS && _hostname == nullptr)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// State of phase
+uint8_t WebStartup::state(uint8_t phase) {
+	return _states[phase];
+}
+
+// Duration of phase in ms
+uint32_t WebStartup::duration(uint8_t phase) {
+	switch (_states[phase]) {
+		case phaseRunning: return millis() - _started[phase];
+		case phaseDone:
+		case phaseFailed: return _finished[phase] - _started[phase];
+	}
+	return 0;
+}
+
+// Number of reconnect attempts since the last connection
+uint16_t WebStartup::attempts() {
+	return _attempts;
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+/*
+ * WebStartup is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+// Ensure the library is only included once
+#ifndef _WebStartup_
+#define _WebStartup_
+
+#include "Arduino.h"
+#include <atomic>
+
+// First delay before reconnecting a lost WiFi connection, in ms. Doubled on every failed attempt
+#define defaultReconnectDelay 500
+// Longest delay between reconnect attempts, in ms
+#define maxReconnectDelay 30000
+
+// Startup phases
+typedef enum {
+	phaseSPIFFS, // Mount SPIFFS
+	phaseRoutes, // Build routes and caches
+	phaseWiFi, // Connect to WiFi, until an IP address is assigned
+	phaseMDNS, // Start the MDNS responder
+	phaseCount
+} startupPhases;
+
+// State of a startup phase
+typedef enum {
+	phasePending,
+	phaseRunning,
+	phaseDone,
+	phaseFailed
+} phaseStates;
+
+// Callback function typedef for startup phase changes, called when a phase is done or failed (and when WiFi is lost)
+typedef void (*startupCallback)(uint8_t phase, uint8_t state, uint32_t duration);
+
+// Network the startup connects through. Implemented on WiFi for the ESP32, and by a mock for host tests
+class WebNetwork {
+	public:
+		virtual ~WebNetwork() {}
+		// Start connecting, return at once. The result is reported through WebStartup::connected() or disconnected()
+		virtual void connect(const char *ssid, const char *password) = 0;
+		// Start the MDNS responder
+		virtual bool startMDNS(const char *hostname) = 0;
+};
+
+// Non-blocking startup state machine. WiFi connects in the background while SPIFFS is mounted and routes are built,
+// lost connections are retried with backoff, and MDNS starts once an IP address is assigned.
+// Network events may come from another task, everything else runs from poll()
+class WebStartup {
+	public:
+		// Constructor
+		WebStartup(WebNetwork *network);
+
+		// Set callback for phase changes
+		void onPhase(startupCallback callback);
+
+		// Start connecting, returns at once
+		void connect(const char *ssid, const char *password, const char *hostname);
+		// Mark phase as started
+		void started(uint8_t phase);
+		// Mark phase as done, or failed
+		void finished(uint8_t phase, bool success);
+
+		// Network event, an IP address was assigned. Safe to call from the network event task
+		void connected();
+		// Network event, the connection was lost or could not be made. Safe to call from the network event task
+		void disconnected();
+
+		// Advance the state machine: report network events, reconnect after backoff and start MDNS. Call from loop()
+		void poll();
+
+		// Check if all phases are done
+		bool ready();
+		// State of phase
+		uint8_t state(uint8_t phase);
+		// Duration of phase in ms, up to now if it is still running
+		uint32_t duration(uint8_t phase);
+		// Number of reconnect attempts since the last connection
+		uint16_t attempts();
+
+	private:
+		// Network to connect through
+		WebNetwork *_network;
+		// Phase change callback
+		startupCallback _callback = nullptr;
+
+		// Connection details
+		const char *_ssid = nullptr;
+		const char *_password = nullptr;
+		const char *_hostname = nullptr;
+
+		// State of each phase
+		uint8_t _states[phaseCount] = {};
+		// Start time of each phase, in ms
+		uint32_t _started[phaseCount] = {};
+		// End time of each phase, in ms
+		uint32_t _finished[phaseCount] = {};
+
+		// Pending network events, set by the event task and taken by poll()
+		std::atomic<bool> _connectedEvent{false};
+		std::atomic<bool> _disconnectedEvent{false};
+		// Time of the next reconnect attempt, in ms
+		uint32_t _reconnectAt = 0;
+		// Delay before the next reconnect attempt, in ms
+		uint32_t _reconnectDelay = defaultReconnectDelay;
+		// Reconnect attempts since the last connection
+		uint16_t _attempts = 0;
+		// A reconnect attempt is scheduled
+		bool _reconnecting = false;
+};
+#endif
\ No newline at end of file
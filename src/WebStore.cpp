@@ -0,0 +1,258 @@
+/*
+ * WebStore is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+#include "WebStore.h"
+
+// Record header sizes, around the name
+#define recordNameHeader 1
+#define recordValueHeader 3
+
+//*************************************************************
+// Public functions
+//*************************************************************
+
+// Constructor
+WebStore::WebStore(WebAPI *api, fs::FS &fs, const char *fileName, uint32_t interval, size_t compactSize) : _api(api), _fs(fs), _fileName(fileName), _interval(interval), _compactSize(compactSize) {}
+
+// Restore persistent keywords from the log
+uint16_t WebStore::restore() {
+	// Finish a compaction cut short between removing the old log and renaming the new one
+	String tempName = String(_fileName) + ".tmp";
+	if (!_fs.exists(_fileName) && _fs.exists(tempName)) {
+		_fs.rename(tempName.c_str(), _fileName);
+	}
+	File file = _fs.open(_fileName, "r");
+	if (!file) {
+		return 0;
+	}
+	// Read the whole log at once
+	size_t size = file.size();
+	uint8_t *log = (uint8_t*)malloc(size);
+	if (log == nullptr) {
+		file.close();
+		webLogError("WebStore::restore(), No memory for %u byte log", (unsigned int)size);
+		return 0;
+	}
+	size = file.read(log, size);
+	file.close();
+	uint16_t applied = 0;
+	size_t offset = 0;
+	while (offset + recordNameHeader <= size) {
+		uint8_t nameLength = log[offset];
+		const char *name = (const char*)log + offset + recordNameHeader;
+		size_t valueHeader = offset + recordNameHeader + nameLength;
+		if (valueHeader + recordValueHeader > size) {
+			break;
+		}
+		uint8_t type = log[valueHeader];
+		size_t valueLength = log[valueHeader + 1] | (log[valueHeader + 2] << 8);
+		const uint8_t *value = log + valueHeader + recordValueHeader;
+		// A record cut short (power lost while writing) ends the log
+		if (valueHeader + recordValueHeader + valueLength > size) {
+			_torn = true;
+			break;
+		}
+		offset = valueHeader + recordValueHeader + valueLength;
+		// Skip keywords that are gone, changed type or are no longer persistent
+		int16_t index = _api->findKeywordIndex(name, nameLength);
+		if (index >= 0 && _api->_apiKeywords[index].persistent && _api->_apiKeywords[index].valueType == type && _api->setBinaryValue(index, value, valueLength)) {
+			applied++;
+		}
+	}
+	free(log);
+	webLogInfo("WebStore::restore(), Restored %u records from %u bytes", applied, (unsigned int)size);
+	if (size > _compactSize || _torn) {
+		compact();
+	}
+	return applied;
+}
+
+// Write changed values once the interval has passed
+void WebStore::poll() {
+	if (millis() - _lastFlush >= _interval) {
+		_lastFlush = millis();
+		flush();
+	}
+}
+
+// Write changed values now
+bool WebStore::flush() {
+	bool dirty = false;
+	for (uint8_t i = 0; i < _api->_keywords && !dirty; i++) {
+		dirty = _api->_states[i].dirty.load(std::memory_order_acquire);
+	}
+	if (!dirty) {
+		return true;
+	}
+	// A torn log is rewritten with all keywords, instead of appending after the record cut short
+	if (_torn) {
+		if (!compact()) {
+			return false;
+		}
+		_flushes++;
+		return true;
+	}
+	if (!writeRecords(_fileName, "a", false)) {
+		return false;
+	}
+	_flushes++;
+	// Compact once the log has grown past the limit
+	File file = _fs.open(_fileName, "r");
+	size_t size = file ? file.size() : 0;
+	if (file) {
+		file.close();
+	}
+	if (size > _compactSize) {
+		compact();
+	}
+	return true;
+}
+
+// Number of batches written
+uint32_t WebStore::flushes() {
+	return _flushes;
+}
+
+// Number of records written
+uint32_t WebStore::records() {
+	return _records;
+}
+
+// Bytes written to flash
+uint32_t WebStore::bytesWritten() {
+	return _bytesWritten;
+}
+
+// Number of compactions
+uint32_t WebStore::compactions() {
+	return _compactions;
+}
+
+// Changes of persistent keywords
+uint32_t WebStore::changes() {
+	return _api->_persistentChanges;
+}
+
+//*************************************************************
+// Private functions
+//*************************************************************
+
+// Write records of keywords to file
+bool WebStore::writeRecords(const char *fileName, const char *mode, bool all) {
+	// Size the batch, so it is written with a single write
+	size_t length = 0;
+	for (uint8_t i = 0; i < _api->_keywords; i++) {
+		const apiKeyword *keyword = &_api->_apiKeywords[i];
+		if (keyword->persistent && (all || _api->_states[i].dirty.load(std::memory_order_acquire))) {
+			length += recordNameHeader + keyword->requestKeyword.length() + recordValueHeader + _api->binaryValue(i, nullptr, 0);
+		}
+	}
+	uint8_t *batch = (uint8_t*)malloc(length);
+	if (batch == nullptr) {
+		return false;
+	}
+	size_t used = 0;
+	uint32_t records = 0;
+	// Keywords in the batch, marked dirty again if the batch does not reach the file
+	keywordSet batched = {};
+	for (uint8_t i = 0; i < _api->_keywords; i++) {
+		const apiKeyword *keyword = &_api->_apiKeywords[i];
+		if (!keyword->persistent || !(all || _api->_states[i].dirty.load(std::memory_order_acquire))) {
+			continue;
+		}
+		size_t nameLength = keyword->requestKeyword.length();
+		if (nameLength > 255) {
+			continue;
+		}
+		// Cleared before reading, so a change made meanwhile is written by the next flush
+		_api->_states[i].dirty.store(false, std::memory_order_release);
+		size_t valueOffset = used + recordNameHeader + nameLength + recordValueHeader;
+		size_t valueLength = _api->binaryValue(i, batch + valueOffset, length - valueOffset);
+		// A string that grew since sizing the batch waits for the next flush
+		if (valueOffset + valueLength > length) {
+			_api->_states[i].dirty.store(true, std::memory_order_release);
+			continue;
+		}
+		batch[used] = nameLength;
+		memcpy(batch + used + recordNameHeader, keyword->requestKeyword.c_str(), nameLength);
+		batch[valueOffset - 3] = keyword->valueType;
+		batch[valueOffset - 2] = valueLength & 0xFF;
+		batch[valueOffset - 1] = valueLength >> 8;
+		used = valueOffset + valueLength;
+		records++;
+		batched.words[i / 32] |= 1UL << (i % 32);
+	}
+	File file = _fs.open(fileName, mode);
+	if (!file) {
+		free(batch);
+		restoreDirty(&batched);
+		webLogError("WebStore::writeRecords(), Could not open %s", fileName);
+		return false;
+	}
+	size_t written = file.write(batch, used);
+	file.close();
+	free(batch);
+	_bytesWritten += written;
+	// A short write leaves the batch to the next flush, restore() ignores the partial record at the end
+	if (written != used) {
+		if (written > 0 && fileName == _fileName) {
+			_torn = true;
+		}
+		restoreDirty(&batched);
+		webLogError("WebStore::writeRecords(), Wrote %u of %u bytes to %s", (unsigned int)written, (unsigned int)used, fileName);
+		return false;
+	}
+	_records += records;
+	return true;
+}
+
+// Mark the keywords of a batch that was not written as dirty again
+void WebStore::restoreDirty(const keywordSet *batched) {
+	for (uint8_t i = 0; i < _api->_keywords; i++) {
+		if (batched->words[i / 32] & (1UL << (i % 32))) {
+			_api->_states[i].dirty.store(true, std::memory_order_release);
+		}
+	}
+}
+
+// Rewrite the log with one record per keyword
+bool WebStore::compact() {
+	String tempName = String(_fileName) + ".tmp";
+	if (!writeRecords(tempName.c_str(), "w", true)) {
+		_fs.remove(tempName.c_str());
+		return false;
+	}
+	_fs.remove(_fileName);
+	_fs.rename(tempName.c_str(), _fileName);
+	_torn = false;
+	_compactions++;
+	webLogInfo("WebStore::compact(), Compacted %s", _fileName);
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+/*
+ * WebStore is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+// Ensure the library is only included once
+#ifndef _WebStore_
+#define _WebStore_
+
+#include "Arduino.h"
+#include "FS.h"
+#include "WebAPI.h"
+
+// Default file of the keyword store
+#define defaultStoreFile "/keywords.log"
+// Default interval between writes of changed values, in ms
+#define defaultStoreInterval 5000
+// Default store file size that triggers compaction, in bytes
+#define defaultStoreCompactSize 4096
+
+// Persistent keyword store. Changed values of persistent keywords are appended to a log file in batches, one
+// compact binary record each: uint8 name length, name, uint8 value type, uint16 value length, value (as in
+// WebAPI::binaryValues()). At startup the whole log is read at once and the last record of each keyword wins.
+// When the log grows past the compaction size it is rewritten with one record per keyword.
+class WebStore {
+	public:
+		// Constructor
+		WebStore(WebAPI *api, fs::FS &fs, const char *fileName = defaultStoreFile, uint32_t interval = defaultStoreInterval, size_t compactSize = defaultStoreCompactSize);
+
+		// Restore persistent keywords from the log, without running callbacks. Returns the number of records applied
+		uint16_t restore();
+		// Write changed values once the interval has passed. Call from loop()
+		void poll();
+		// Write changed values now, returns false if the log could not be written
+		bool flush();
+
+		// Number of batches written
+		uint32_t flushes();
+		// Number of records written
+		uint32_t records();
+		// Bytes written to flash, including compaction
+		uint32_t bytesWritten();
+		// Number of compactions
+		uint32_t compactions();
+		// Changes of persistent keywords, compare with records() for the writes saved by batching
+		uint32_t changes();
+
+	private:
+		// API holding the keywords
+		WebAPI *_api;
+		// Filesystem of the log
+		fs::FS &_fs;
+		// Log file name
+		const char *_fileName;
+		// Interval between writes, in ms
+		const uint32_t _interval;
+		// Log size that triggers compaction, in bytes
+		const size_t _compactSize;
+		// Time of the last write, in ms
+		uint32_t _lastFlush = 0;
+		// The log ends in a record cut short, records appended after it could not be read, so it is rewritten instead
+		bool _torn = false;
+
+		// Counters
+		uint32_t _flushes = 0;
+		uint32_t _records = 0;
+		uint32_t _bytesWritten = 0;
+		uint32_t _compactions = 0;
+
+		// Write records of keywords to file, only changed ones unless all. Returns false on a write error
+		bool writeRecords(const char *fileName, const char *mode, bool all);
+		// Mark the keywords of a batch that was not written as dirty again
+		void restoreDirty(const keywordSet *batched);
+		// Rewrite the log with one record per keyword, returns false if the log could not be written
+		bool compact();
+};
+#endif
\ No newline at end of file
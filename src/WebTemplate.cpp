@@ -0,0 +1,320 @@
+/*
+ * WebTemplate is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+#include "Arduino.h"
+#include "WebTemplate.h"
+
+//*************************************************************
+// Public functions
+//*************************************************************
+
+// Constructor
+WebTemplate::WebTemplate() {}
+
+// Destructor
+WebTemplate::~WebTemplate() {
+	free(_page);
+	delete[] _segments;
+}
+
+// Load and parse the template from the filesystem
+bool WebTemplate::load(fs::FS &fs, const char *fileName, WebAPI *api) {
+
+	File file = fs.open(fileName, "r");
+	if (!file) {
+		return false;
+	}
+	// Read the whole page once
+	size_t size = file.size();
+	char *page = (char*)malloc(size + 1);
+	if (page == nullptr) {
+		file.close();
+		return false;
+	}
+	size_t read = file.read((uint8_t*)page, size);
+	file.close();
+	if (read != size) {
+		free(page);
+		return false;
+	}
+	page[size] = '\0';
+	// Replace any previously loaded page
+	free(_page);
+	delete[] _segments;
+	_page = page;
+	_pageLength = size;
+	_api = api;
+	// First pass counts the segments, second pass fills them in
+	_segmentCount = parse(nullptr);
+	_segments = new templateSegment[_segmentCount];
+	parse(_segments);
+	webLogDebug("WebTemplate::load(), Parsed template %s into %u segments", fileName, (unsigned int)_segmentCount);
+	return true;
+}
+
+// Check if template is loaded
+bool WebTemplate::loaded() {
+	return _page != nullptr;
+}
+
+// Render the next part of the page into buffer
+size_t WebTemplate::render(templateState *state, uint8_t *buffer, size_t maxLen, placeholderProcessor processor) {
+	// String values are copied under the value lock
+	valueLock lock(_api);
+	size_t written = 0;
+	while (written < maxLen && state->segment < _segmentCount) {
+		const templateSegment *segment = &_segments[state->segment];
+		const char *text = nullptr;
+		size_t length = 0;
+		switch (segment->type) {
+			case templateStatic: {
+				text = _page + segment->offset;
+				length = segment->length;
+			} break;
+			case templateKeyword: {
+				// Value is fetched again on every call, so a string value changed between chunks is never read out of bounds
+				text = _api->valueText(segment->keyword, state->value, &length);
+			} break;
+			case templateProcessor: {
+				// Run the processor once, when entering the segment
+				if (state->offset == 0) {
+					state->processed = processor ? processor(String(_page + segment->offset)) : String();
+				}
+				text = state->processed.c_str();
+				length = state->processed.length();
+			} break;
+		}
+		// Copy as much of the segment as fits
+		if (state->offset < length) {
+			size_t count = length - state->offset;
+			if (count > maxLen - written) {
+				count = maxLen - written;
+			}
+			memcpy(buffer + written, text + state->offset, count);
+			written += count;
+			state->offset += count;
+		}
+		// Move on to the next segment, when done with this one
+		if (state->offset >= length) {
+			state->segment++;
+			state->offset = 0;
+		}
+	}
+	return written;
+}
+
+//*************************************************************
+// Private functions
+//*************************************************************
+
+// Parse the page, filling segments if not null
+size_t WebTemplate::parse(templateSegment *segments) {
+	size_t count = 0;
+	// Start of the current static span
+	size_t start = 0;
+	size_t i = 0;
+	while (i < _pageLength) {
+		if (_page[i] != '%') {
+			i++;
+			continue;
+		}
+		// Escaped percent sign, keep one of them
+		if (i + 1 < _pageLength && _page[i + 1] == '%') {
+			addSegment(segments, &count, templateStatic, -1, start, i + 1 - start);
+			start = i + 2;
+			i = start;
+			continue;
+		}
+		// Look for the closing percent sign, within the placeholder length limit
+		size_t searchLength = _pageLength - i - 1;
+		if (searchLength > templatePlaceholderLength) {
+			searchLength = templatePlaceholderLength;
+		}
+		const char *end = (const char*)memchr(_page + i + 1, '%', searchLength);
+		if (end == nullptr) {
+			// Not a placeholder, keep the percent sign
+			i++;
+			continue;
+		}
+		size_t nameOffset = i + 1;
+		size_t nameLength = end - (_page + nameOffset);
+		// Close the static span before the placeholder
+		addSegment(segments, &count, templateStatic, -1, start, i - start);
+		// Resolve the placeholder against the API keywords
+		int16_t keyword = (_api != nullptr) ? _api->placeholderIndex(_page + nameOffset, nameLength) : -1;
+		if (keyword >= 0) {
+			addSegment(segments, &count, templateKeyword, keyword, nameOffset, nameLength);
+		} else {
+			addSegment(segments, &count, templateProcessor, -1, nameOffset, nameLength);
+			// Terminate the name in place (the closing percent sign is never sent), so it can be passed to the processor
+			if (segments != nullptr) {
+				_page[nameOffset + nameLength] = '\0';
+			}
+		}
+		start = nameOffset + nameLength + 1;
+		i = start;
+	}
+	// Static span after the last placeholder
+	addSegment(segments, &count, templateStatic, -1, start, _pageLength - start);
+	return count;
+}
+
+// Add segment to segments, if not null
+void WebTemplate::addSegment(templateSegment *segments, size_t *count, uint8_t type, int16_t keyword, size_t offset, size_t length) {
+	// Skip empty static spans
+	if (type == templateStatic && length == 0) {
+		return;
+	}
+	if (segments != nullptr) {
+		segments[*count] = {type, keyword, offset, length};
+	}
+	(*count)++;
+}
+
+//*************************************************************
+// Template stream
+//*************************************************************
+
+// Constructor
+WebTemplateStream::WebTemplateStream(fs::FS &fs, const char *fileName, WebAPI *api) : _api(api) {
+	_file = fs.open(fileName, "r");
+}
+
+// Destructor
+WebTemplateStream::~WebTemplateStream() {
+	if (_file) {
+		_file.close();
+	}
+}
+
+// Check if the file was opened
+bool WebTemplateStream::opened() {
+	return (bool)_file;
+}
+
+// Render the next part of the page into buffer. Placeholders follow the same rules as WebTemplate::parse()
+size_t WebTemplateStream::render(uint8_t *buffer, size_t maxLen, placeholderProcessor processor) {
+	// String values are copied under the value lock
+	valueLock lock(_api);
+	size_t written = 0;
+	while (written < maxLen) {
+		// Send the value or literal, resuming where the last chunk stopped
+		if (_mode == streamValue || _mode == streamLiteral) {
+			const char *text;
+			size_t length;
+			if (_mode == streamLiteral) {
+				text = _name;
+				length = _nameLength + 1;
+			} else if (_keyword >= 0) {
+				// Value is fetched again on every call, so a string value changed between chunks is never read out of bounds
+				text = _api->valueText(_keyword, _value, &length);
+			} else {
+				text = _processed.c_str();
+				length = _processed.length();
+			}
+			if (_offset < length) {
+				size_t count = length - _offset;
+				if (count > maxLen - written) {
+					count = maxLen - written;
+				}
+				memcpy(buffer + written, text + _offset, count);
+				written += count;
+				_offset += count;
+			}
+			if (_offset >= length) {
+				_mode = streamText;
+				_offset = 0;
+				_processed = String();
+			}
+			continue;
+		}
+		// Read more of the page
+		if (_inputOffset >= _inputLength) {
+			_inputLength = _file.read(_input, sizeof(_input));
+			_inputOffset = 0;
+			if (_inputLength == 0) {
+				// A placeholder not closed at the end of the page is sent as is
+				if (_mode == streamName) {
+					_mode = streamLiteral;
+					continue;
+				}
+				break;
+			}
+		}
+		if (_mode == streamText) {
+			// Copy text up to the next percent sign
+			size_t count = _inputLength - _inputOffset;
+			if (count > maxLen - written) {
+				count = maxLen - written;
+			}
+			const uint8_t *percent = (const uint8_t*)memchr(_input + _inputOffset, '%', count);
+			if (percent != nullptr) {
+				count = percent - (_input + _inputOffset);
+			}
+			memcpy(buffer + written, _input + _inputOffset, count);
+			written += count;
+			_inputOffset += count;
+			if (percent != nullptr) {
+				_inputOffset++;
+				_mode = streamName;
+				_name[0] = '%';
+				_nameLength = 0;
+			}
+			continue;
+		}
+		// Reading a placeholder name
+		char c = _input[_inputOffset];
+		if (c == '%') {
+			_inputOffset++;
+			if (_nameLength == 0) {
+				// Escaped percent sign, keep one of them
+				buffer[written++] = '%';
+				_mode = streamText;
+				continue;
+			}
+			// Resolve the placeholder against the API keywords, else pass it to the processor
+			_keyword = (_api != nullptr) ? _api->placeholderIndex(_name + 1, _nameLength) : -1;
+			if (_keyword < 0) {
+				_name[_nameLength + 1] = '\0';
+				_processed = processor ? processor(String(_name + 1)) : String();
+			}
+			_mode = streamValue;
+			_offset = 0;
+		} else if (_nameLength + 1 >= templatePlaceholderLength) {
+			// Too long to be a placeholder, send it as text and go on from this character
+			_mode = streamLiteral;
+			_offset = 0;
+		} else {
+			_name[++_nameLength] = c;
+			_inputOffset++;
+		}
+	}
+	return written;
+}
\ No newline at end of file
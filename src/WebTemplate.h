@@ -0,0 +1,153 @@
+/*
+ * WebTemplate is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+// Ensure the library is only included once
+#ifndef _WebTemplate_
+#define _WebTemplate_
+
+#include "Arduino.h"
+#include "FS.h"
+#include "WebAPI.h"
+#include <functional>
+
+// Maximum length of a placeholder name, same limit as the ESPAsyncWebServer template processor
+#define templatePlaceholderLength 32
+
+// Size of the file read buffer of a template stream
+#define templateStreamBuffer 256
+
+// Processor for placeholders that are not API keywords (same signature as the ESPAsyncWebServer template processor)
+typedef std::function<String(const String &)> placeholderProcessor;
+
+// Template segment types
+typedef enum {
+	templateStatic, // Static span of the page, copied as is
+	templateKeyword, // API keyword value
+	templateProcessor // Placeholder not matching a keyword, passed to the HTML processor
+} templateSegmentTypes;
+
+// A parsed piece of the template
+struct templateSegment {
+	uint8_t type; // The segment type
+	int16_t keyword; // Keyword index, for keyword segments
+	size_t offset; // Offset of the span (or placeholder name) in the page buffer
+	size_t length; // Length of the span
+};
+
+// Render progress of a single response
+struct templateState {
+	size_t segment = 0; // Segment being rendered
+	size_t offset = 0; // Bytes of the segment already rendered
+	char value[valueTextSize]; // Buffer for formatting keyword values
+	String processed; // Output of the HTML processor, for processor segments
+};
+
+// Modes of a template stream
+typedef enum {
+	streamText, // Copying page text
+	streamName, // Reading a placeholder name
+	streamValue, // Sending a keyword value or processor output
+	streamLiteral // Sending a percent sign and name that turned out not to be a placeholder
+} templateStreamModes;
+
+class WebTemplate {
+	public:
+		// Constructor
+		WebTemplate();
+		// Destructor
+		~WebTemplate();
+
+		// Load and parse the template from the filesystem, resolving placeholders against the API keywords
+		bool load(fs::FS &fs, const char *fileName, WebAPI *api);
+		// Check if template is loaded
+		bool loaded();
+
+		// Render the next part of the page into buffer, returns bytes written (0 when done)
+		size_t render(templateState *state, uint8_t *buffer, size_t maxLen, placeholderProcessor processor);
+
+	private:
+		// Page content
+		char *_page = nullptr;
+		// Page length
+		size_t _pageLength = 0;
+		// Parsed segments
+		templateSegment *_segments = nullptr;
+		// Number of segments
+		size_t _segmentCount = 0;
+		// API used for keyword placeholders
+		WebAPI *_api = nullptr;
+
+		// Parse the page, filling segments if not null. Returns number of segments
+		size_t parse(templateSegment *segments);
+		// Add segment to segments, if not null
+		void addSegment(templateSegment *segments, size_t *count, uint8_t type, int16_t keyword, size_t offset, size_t length);
+};
+// Template expanded while streaming it from the filesystem, one response each. Memory use is fixed
+// (the read buffer, a placeholder name and a value buffer) however large the page or its values are.
+// Only output of the HTML processor, for placeholders that are not keywords, is held in a String
+class WebTemplateStream {
+	public:
+		// Constructor, opens the file. Placeholders are resolved against the API keywords, if api is not null
+		WebTemplateStream(fs::FS &fs, const char *fileName, WebAPI *api);
+		// Destructor
+		~WebTemplateStream();
+
+		// Check if the file was opened
+		bool opened();
+		// Render the next part of the page into buffer, returns bytes written (0 when done)
+		size_t render(uint8_t *buffer, size_t maxLen, placeholderProcessor processor);
+
+	private:
+		// Page file
+		File _file;
+		// API used for keyword placeholders
+		WebAPI *_api;
+		// File read buffer
+		uint8_t _input[templateStreamBuffer];
+		// Bytes in the read buffer
+		size_t _inputLength = 0;
+		// Bytes of the read buffer already used
+		size_t _inputOffset = 0;
+		// Render mode (templateStreamModes)
+		uint8_t _mode = streamText;
+		// Percent sign and placeholder name, null terminated for the processor
+		char _name[templatePlaceholderLength + 1];
+		// Length of the placeholder name
+		size_t _nameLength = 0;
+		// Keyword index of the placeholder, -1 for processor output
+		int16_t _keyword = -1;
+		// Bytes of the value or literal already sent
+		size_t _offset = 0;
+		// Buffer for formatting keyword values
+		char _value[valueTextSize];
+		// Output of the HTML processor
+		String _processed;
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,120 @@
+/*
+ * WebTransport is a subelement of ESPWebManager.
+ * ESPWebManager provides an implementation of an asynchronous
+ * web server (ESPAsyncWebServer) and a SPIFFS filesystem for
+ * to easily deploy a website on a ESP32 with multiple web pages
+ * javascript and css styles.
+ * At the same time it features an interface for setting and
+ * getting states of user defined variables on the ESP. This
+ * "API", thus allows the web pages to change states of
+ * varaibles on the ESP, using simple web request which can be
+ * implemented in javascript, using the XMLHttpRequest()
+ * function.
+ * 
+ * This library is build uppon the Arduino-ESP core library,
+ * SPIFFS library and the ESPAsyncWebServer library, both 
+ * of which are required to run this library.
+ * 
+ * SPIFFS should be included as part of the Arduino-ESP32 
+ * library, which can be found at:
+ * https://github.com/espressif/arduino-esp32
+ * 
+ * ESPAsyncWebServer can be found at:
+ * https://github.com/me-no-dev/ESPAsyncWebServer
+ * 
+ * The library is distrubuted with the GNU Lesser General 
+ * Public License v2.1, as per requirement of the Arduino-ESP32
+ * and ESPAsyncWebServer library.
+ * This library was created by ldaug99.
+*/ 
+
+// Ensure the library is only included once
+#ifndef _WebTransport_
+#define _WebTransport_
+
+#include "Arduino.h"
+#include "FS.h"
+#include "WebTemplate.h"
+#include <functional>
+
+class AsyncWebServerRequest;
+
+// Fills buffer with the next part of a body, at most maxLen bytes, index bytes were sent before. Returns the bytes written,
+// 0 when done (same signature as the ESPAsyncWebServer response filler)
+typedef std::function<size_t(uint8_t *buffer, size_t maxLen, size_t index)> webFiller;
+// Prints a body
+typedef std::function<void(Print &output)> webPrinter;
+// Called when a request is done
+typedef std::function<void()> webDone;
+
+// A request, as the web manager sees it. Handlers read the request, add reply headers and send one reply.
+// Request methods are the HTTP_GET, HTTP_POST, ... bits of ESPAsyncWebServer
+class WebRequest {
+	public:
+		// Destructor
+		virtual ~WebRequest() {}
+
+		// Request path, decoded and without the query
+		virtual const String &url() = 0;
+		// Request method
+		virtual uint8_t method() = 0;
+		// Client IPv4 address
+		virtual uint32_t clientAddress() = 0;
+		// Value of a request header, nullptr if not sent. Only headers the handler asked for are kept (see WebRequestHandler::headers())
+		virtual const char *header(const char *name) = 0;
+
+		// Number of query parameters
+		virtual size_t params() = 0;
+		// Name of query parameter index
+		virtual const char *paramName(size_t index) = 0;
+		// Value of query parameter index, empty if it has none
+		virtual const char *paramValue(size_t index) = 0;
+		// Value of query parameter name, nullptr if not sent
+		virtual const char *param(const char *name) = 0;
+
+		// Add a header to the reply, call before sending it. Name and value are not copied, and must stay valid until the reply is sent
+		virtual void addHeader(const char *name, const char *value) = 0;
+		// Send a reply, the text is copied. contentType may be nullptr for a reply without body
+		virtual void send(uint16_t code, const char *contentType, const char *text, size_t length) = 0;
+		// Send a reply from a buffer, without copying it. The buffer must stay valid until the request is done, with
+		// freeData it is from malloc() and freed then. With a processor, the body is sent as a template
+		virtual void sendBuffer(uint16_t code, const char *contentType, const uint8_t *data, size_t length, bool freeData = false, placeholderProcessor processor = nullptr) = 0;
+		// Send an open file, closed when the request is done. With a processor, the file is sent as a template
+		virtual void sendFile(File file, const char *contentType, placeholderProcessor processor = nullptr) = 0;
+		// Send a reply of unknown length, filled in parts as the connection can take them
+		virtual void sendChunked(uint16_t code, const char *contentType, webFiller filler) = 0;
+		// Send a reply printed by printer, at once
+		virtual void sendPrinted(uint16_t code, const char *contentType, webPrinter printer) = 0;
+
+		// Call done when the request is done, after its reply is sent or the connection closed. One callback per request
+		virtual void onDone(webDone done) = 0;
+		// The ESPAsyncWebServer request underneath, nullptr over other transports
+		virtual AsyncWebServerRequest *asyncRequest() { return nullptr; }
+};
+
+// Handler of the requests of a transport, the web manager
+class WebRequestHandler {
+	public:
+		// Destructor
+		virtual ~WebRequestHandler() {}
+
+		// Check if a request is for the handler, from its path and method, before its headers are read
+		virtual bool canHandle(const char *path, size_t length, uint8_t method) = 0;
+		// Request headers the handler reads, nullptr terminated. Transports may drop all others
+		virtual const char *const *headers() = 0;
+		// Serve a request, with a not found reply if it is not for the handler
+		virtual void handleRequest(WebRequest *request) = 0;
+};
+
+// Transport the web manager serves requests over, such as ESPAsyncWebServer (see WebAsyncTransport)
+class WebTransport {
+	public:
+		// Destructor
+		virtual ~WebTransport() {}
+
+		// Start serving on port, passing requests to handler
+		virtual bool begin(uint16_t port, WebRequestHandler *handler) = 0;
+		// Serve pending connections, called by webManager::poll(). Transports with their own task have nothing to do
+		virtual void poll() {}
+};
+#endif
\ No newline at end of file